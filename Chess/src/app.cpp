@@ -1,4 +1,5 @@
-﻿#include "core/Stockfish.h"
+﻿#include "core/EnginePool.h"
+#include "core/Tablebase.h"
 #include "core/board.h"
 #include "game_controller.h"
 #include "graphic/ResourceManager.h"
@@ -48,6 +49,16 @@ int main()
     std::shared_ptr<SFMLGraphics> graphics = nullptr;
 
     std::unique_ptr<NetworkClient> netClient = nullptr;
+    // Движки запускаются один раз и переиспользуются между партиями
+    std::shared_ptr<EnginePool> enginePool = nullptr;
+    // Дебютная книга (необязательна): если файла нет, ИИ думает с первого хода
+    std::shared_ptr<Book> openingBook = std::make_shared<Book>();
+    if (!openingBook->open("book.bin"))
+        openingBook = nullptr;
+    // Таблицы эндшпиля (необязательны): теоретически ничейные позиции завершают партию
+    std::shared_ptr<const Tablebase> tablebase = std::make_shared<Tablebase>("tb");
+    if (tablebase->getTableCount() == 0)
+        tablebase = nullptr;
     std::thread connectionThread;
     std::atomic<bool> isConnecting{ false };
     std::atomic<bool> connectionSuccess{ false };
@@ -102,6 +113,13 @@ int main()
 
                 if (netClient->connect(ip, 53000))
                 {
+                    std::string code = config.roomCode;
+                    code.erase(std::remove(code.begin(), code.end(), ' '), code.end());
+                    if (code.empty())
+                        netClient->createRoom();
+                    else
+                        netClient->joinRoom(code);
+
                     std::cout << "Connected. Sending game config..." << std::endl;
                     netClient->sendGameConfig(
                         config.playerColor,
@@ -146,11 +164,16 @@ int main()
             graphics = std::make_shared<SFMLGraphics>(window, resourceManager, config.playerColor);
 
             std::unique_ptr<INetworkInterface> network = nullptr;
-            std::unique_ptr<Stockfish> stockfish = nullptr;
+            std::shared_ptr<EnginePool> aiEngines = nullptr;
 
             if (config.opponentType == OpponentType::AI)
             {
-                stockfish = std::make_unique<Stockfish>("stockfish.exe");
+                if (!enginePool)
+                {
+                    enginePool = std::make_shared<EnginePool>("stockfish.exe", 1);
+                    enginePool->setCache(std::make_shared<AnalysisCache>(1 << 16, "analysis.cache"));
+                }
+                aiEngines = enginePool;
             }
 
             std::unique_ptr<GameMode> gameMode;
@@ -160,14 +183,18 @@ int main()
                 gameMode = std::make_unique<Fischer>(config.seed);
 
             auto board = std::make_unique<Board>(std::move(gameMode), config.timeMinutes * 60, config.incrementSeconds);
+            board->setTablebase(tablebase);
 
             gameController = std::make_unique<GameController>(
                 std::move(board),
                 graphics,
                 std::move(network),
-                std::move(stockfish),
+                aiEngines,
                 config.playerColor);
 
+            if (aiEngines)
+                gameController->setBook(openingBook);
+
             gameController->setOnGameEnd(
                 [&appState]() {
                     appState = AppState::EndGame;
@@ -215,6 +242,9 @@ int main()
             }
         }
 
+        if (appState == AppState::Menu && isConnecting && netClient)
+            mainMenu.setRoomCode(netClient->getRoomCode());
+
         // Логика завершения подключения
         if (appState == AppState::Menu && !isConnecting && connectionThread.joinable())
         {
@@ -262,8 +292,9 @@ int main()
                 // Ошибка или отмена подключения
                 if (mainMenu.getCurrentScreen() == MenuScreen::Connecting)
                 {
-                    mainMenu.setErrorMessage("Connection failed or lost");
+                    std::string error = netClient ? netClient->getLastError() : "";
                     mainMenu.showGameSetup();
+                    mainMenu.setErrorMessage(error.empty() ? "Connection failed or lost" : error);
                 }
             }
         }
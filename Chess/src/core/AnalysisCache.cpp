@@ -0,0 +1,176 @@
+#include "AnalysisCache.h"
+#include <cstring>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "disk cache needs lock-free 32-bit atomics");
+
+AnalysisCache::AnalysisCache(size_t memoryEntries, const std::string& diskPath, size_t diskEntries)
+    : memoryCapacity(memoryEntries > 0 ? memoryEntries : 1)
+{
+    static_assert(sizeof(DiskSlot) == 32, "DiskSlot layout is part of the file format");
+
+    if (diskPath.empty() || diskEntries == 0)
+        return;
+
+    if (!disk.openReadWrite(diskPath, sizeof(DiskHeader) + diskEntries * sizeof(DiskSlot)))
+        return;
+
+    auto* header = reinterpret_cast<DiskHeader*>(disk.data());
+    if (header->magic != DISK_MAGIC)
+    {
+        // новый файл: он уже заполнен нулями, остаётся записать заголовок
+        header->slots = diskEntries;
+        header->magic = DISK_MAGIC;
+    }
+
+    // размер таблицы берём из файла: его мог создать другой процесс с другими настройками
+    size_t available = (disk.size() - sizeof(DiskHeader)) / sizeof(DiskSlot);
+    if (header->slots == 0 || header->slots > available)
+    {
+        disk.close();
+        return;
+    }
+
+    slots = reinterpret_cast<DiskSlot*>(disk.data() + sizeof(DiskHeader));
+    slotCount = static_cast<size_t>(header->slots);
+}
+
+std::optional<AnalysisResult> AnalysisCache::lookup(uint64_t key, int moveTimeMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end() && it->second->moveTimeMs >= moveTimeMs)
+        {
+            lru.splice(lru.begin(), lru, it->second);
+            ++hits;
+            return it->second->result;
+        }
+    }
+
+    auto entry = lookupDisk(key);
+    if (entry && entry->moveTimeMs >= moveTimeMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        storeMemory(entry->key, entry->moveTimeMs, entry->result);
+        ++hits;
+        return entry->result;
+    }
+
+    ++misses;
+    return std::nullopt;
+}
+
+void AnalysisCache::store(uint64_t key, int moveTimeMs, const AnalysisResult& result)
+{
+    if (result.bestMove.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        storeMemory(key, moveTimeMs, result);
+    }
+    storeDisk(key, moveTimeMs, result);
+}
+
+size_t AnalysisCache::getHits() const
+{
+    return hits;
+}
+
+size_t AnalysisCache::getMisses() const
+{
+    return misses;
+}
+
+void AnalysisCache::storeMemory(uint64_t key, int moveTimeMs, const AnalysisResult& result)
+{
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        // более короткий анализ не вытесняет более длинный
+        if (it->second->moveTimeMs <= moveTimeMs)
+        {
+            it->second->moveTimeMs = moveTimeMs;
+            it->second->result = result;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return;
+    }
+
+    lru.push_front(Entry { key, moveTimeMs, result });
+    index[key] = lru.begin();
+
+    if (lru.size() > memoryCapacity)
+    {
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+std::optional<AnalysisCache::Entry> AnalysisCache::lookupDisk(uint64_t key)
+{
+    if (!slots)
+        return std::nullopt;
+
+    for (size_t i = 0; i < DISK_PROBES; ++i)
+    {
+        DiskSlot& slot = slots[(key + i) % slotCount];
+
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        uint64_t slotKey = slot.key;
+        Entry entry;
+        entry.key = slotKey;
+        entry.moveTimeMs = slot.moveTimeMs;
+        entry.result.score = slot.score;
+        entry.result.depth = slot.depth;
+        char move[sizeof(slot.bestMove) + 1] = {};
+        std::memcpy(move, slot.bestMove, sizeof(slot.bestMove));
+        entry.result.bestMove = move;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before)
+            continue;
+
+        if (slotKey == key && !entry.result.bestMove.empty())
+            return entry;
+    }
+    return std::nullopt;
+}
+
+void AnalysisCache::storeDisk(uint64_t key, int moveTimeMs, const AnalysisResult& result)
+{
+    if (!slots || result.bestMove.size() > sizeof(DiskSlot::bestMove))
+        return;
+
+    // среди нескольких ячеек выбираем свою, пустую или с самым коротким анализом
+    DiskSlot* target = nullptr;
+    for (size_t i = 0; i < DISK_PROBES; ++i)
+    {
+        DiskSlot& slot = slots[(key + i) % slotCount];
+        if (slot.key == key)
+        {
+            if (slot.moveTimeMs > moveTimeMs)
+                return;
+            target = &slot;
+            break;
+        }
+        if (!target || slot.moveTimeMs < target->moveTimeMs)
+            target = &slot;
+    }
+
+    uint32_t seq = target->seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !target->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+        return; // ячейку сейчас пишет другой процесс
+
+    target->key = key;
+    target->moveTimeMs = moveTimeMs;
+    target->score = result.score;
+    target->depth = static_cast<int16_t>(result.depth);
+    std::memset(target->bestMove, 0, sizeof(target->bestMove));
+    std::memcpy(target->bestMove, result.bestMove.data(), result.bestMove.size());
+
+    target->seq.store(seq + 2, std::memory_order_release);
+}
\ No newline at end of file
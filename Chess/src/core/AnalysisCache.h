@@ -0,0 +1,75 @@
+#pragma once
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+struct AnalysisResult
+{
+    std::string bestMove;
+    std::string ponderMove;  // ожидаемый ответ соперника; в файловый кеш не попадает
+    int score = 0; // в сантипешках с точки зрения стороны, которая ходит
+    int depth = 0;
+};
+
+// Двухуровневый кеш анализа: LRU в памяти процесса и хеш-таблица в файле, общая для всех процессов.
+// Результат, полученный с большим лимитом времени, подходит и для запросов с меньшим.
+class AnalysisCache
+{
+public:
+    AnalysisCache(size_t memoryEntries = 1 << 16, const std::string& diskPath = "", size_t diskEntries = 1 << 20);
+
+    std::optional<AnalysisResult> lookup(uint64_t key, int moveTimeMs);
+    void store(uint64_t key, int moveTimeMs, const AnalysisResult& result);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        int moveTimeMs;
+        AnalysisResult result;
+    };
+
+    // Ячейка файла. seq нечётный, пока ячейку пишут; читатель сверяет seq до и после копирования
+    struct DiskSlot
+    {
+        std::atomic<uint32_t> seq;
+        int32_t moveTimeMs;
+        uint64_t key;
+        int32_t score;
+        int16_t depth;
+        char bestMove[6];
+    };
+
+    struct DiskHeader
+    {
+        uint64_t magic;
+        uint64_t slots;
+    };
+
+    static constexpr uint64_t DISK_MAGIC = 0x3148434143414E41ULL;
+    static constexpr size_t DISK_PROBES = 4;
+
+    size_t memoryCapacity;
+    std::list<Entry> lru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    std::mutex mutex;
+
+    MappedFile disk;
+    DiskSlot* slots = nullptr;
+    size_t slotCount = 0;
+
+    std::atomic<size_t> hits { 0 };
+    std::atomic<size_t> misses { 0 };
+
+    void storeMemory(uint64_t key, int moveTimeMs, const AnalysisResult& result);
+    std::optional<Entry> lookupDisk(uint64_t key);
+    void storeDisk(uint64_t key, int moveTimeMs, const AnalysisResult& result);
+};
\ No newline at end of file
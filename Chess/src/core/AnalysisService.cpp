@@ -0,0 +1,113 @@
+#include "AnalysisService.h"
+#include <algorithm>
+#include <cstring>
+
+AnalysisService::AnalysisService(int lineCount, size_t hashMb)
+    : lines(std::clamp(lineCount, 1, AnalysisSnapshot::MAX_LINES))
+{
+    search.setHashSize(hashMb);
+    search.setInfoCallback([this](const SearchInfo& info) { onInfo(info); });
+    worker = std::thread([this] { run(); });
+}
+
+AnalysisService::~AnalysisService()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        search.stop();
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AnalysisService::setPosition(const std::string& fen)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingFen = fen;
+        hasPending = true;
+        search.stop();
+    }
+    wake.notify_one();
+}
+
+void AnalysisService::run()
+{
+    while (true)
+    {
+        std::string fen;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return hasPending || quit; });
+            if (quit)
+                return;
+            fen = std::move(pendingFen);
+            hasPending = false;
+            // под тем же мьютексом, что и stop() в setPosition, - остановка ради новой позиции не теряется
+            search.clearStop();
+        }
+
+        // старые варианты в новой позиции бессмысленны
+        working.lineCount = 0;
+        working.nodes = 0;
+        publish();
+        if (!root.setFen(fen))
+            continue;
+
+        // без ограничений: перебор идёт до новой позиции или до доказанного мата
+        SearchLimits limits;
+        limits.multiPv = lines;
+        search.run(root, limits);
+    }
+}
+
+void AnalysisService::onInfo(const SearchInfo& info)
+{
+    int index = info.multiPv - 1;
+    if (index < 0 || index >= AnalysisSnapshot::MAX_LINES)
+        return;
+
+    AnalysisSnapshot::Line& line = working.lines[index];
+    line.score = root.sideToMove() == SIDE_WHITE ? info.score : -info.score;
+    line.depth = info.depth;
+
+    // запись рокировки в режиме Фишера зависит от позиции, поэтому ходы проигрываются по порядку
+    std::string text;
+    FastBoard pos = root;
+    for (FastMove m : info.pv)
+    {
+        std::string uci = pos.moveToUci(m);
+        if (text.size() + uci.size() + 1 >= sizeof(line.text))
+            break;
+        text += (text.empty() ? "" : " ") + uci;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+    }
+    std::memcpy(line.text, text.c_str(), text.size() + 1);
+
+    working.lineCount = std::max(working.lineCount, index + 1);
+    working.nodes = info.nodes;
+    publish();
+}
+
+void AnalysisService::publish()
+{
+    uint32_t value = seq.load(std::memory_order_relaxed);
+    seq.store(value + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&snapshot, &working, sizeof(snapshot));
+    seq.store(value + 2, std::memory_order_release);
+}
+
+bool AnalysisService::read(AnalysisSnapshot& out) const
+{
+    uint32_t before = seq.load(std::memory_order_acquire);
+    if (before & 1)
+        return false;
+
+    std::memcpy(&out, &snapshot, sizeof(out));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq.load(std::memory_order_relaxed) == before;
+}
\ No newline at end of file
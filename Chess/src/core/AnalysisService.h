@@ -0,0 +1,63 @@
+#pragma once
+#include "FastBoard.h"
+#include "Search.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Снимок фонового анализа. Простая структура без указателей - копируется целиком под seqlock
+struct AnalysisSnapshot
+{
+    static constexpr int MAX_LINES = 8;
+    static constexpr int MAX_TEXT = 96;
+
+    struct Line
+    {
+        int score;               // с точки зрения белых; маты - как в Search
+        int depth;
+        char text[MAX_TEXT];     // ходы варианта в записи UCI через пробел
+    };
+
+    int lineCount = 0;
+    uint64_t nodes = 0;
+    Line lines[MAX_LINES];
+};
+
+// Непрерывный анализ текущей позиции партии с несколькими вариантами (MultiPV) в отдельном потоке.
+// Новая позиция прерывает перебор и запускает его заново с тем же хешем, поэтому после хода
+// глубина набирается быстро. Результат публикуется через seqlock: читатель не ждёт писателя.
+class AnalysisService
+{
+public:
+    explicit AnalysisService(int lines = 3, size_t hashMb = 16);
+    ~AnalysisService();
+
+    void setPosition(const std::string& fen);
+
+    // Вызывается из потока отрисовки каждый кадр; false - снимок как раз переписывается
+    bool read(AnalysisSnapshot& out) const;
+
+private:
+    Search search;
+    int lines;
+    FastBoard root;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::string pendingFen;
+    bool hasPending = false;
+    bool quit = false;
+
+    // seq нечётный, пока snapshot пишется; пишет только поток анализа
+    std::atomic<uint32_t> seq { 0 };
+    AnalysisSnapshot snapshot;
+    AnalysisSnapshot working;
+
+    void run();
+    void onInfo(const SearchInfo& info);
+    void publish();
+};
\ No newline at end of file
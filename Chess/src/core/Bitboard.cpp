@@ -0,0 +1,101 @@
+#include "Bitboard.h"
+
+Bitboard Attacks::KNIGHT_ATTACKS[64];
+Bitboard Attacks::KING_ATTACKS[64];
+Bitboard Attacks::PAWN_ATTACKS[2][64];
+Bitboard Attacks::RAYS[8][64];
+Bitboard Attacks::BETWEEN[64][64];
+
+// Направления: первые четыре увеличивают индекс поля, остальные - уменьшают
+static const int DIR_X[8] = { 0, 1, 1, -1, 0, -1, -1, 1 };
+static const int DIR_Y[8] = { 1, 0, 1, 1, -1, 0, -1, -1 };
+
+const bool Attacks::initialized = Attacks::init();
+
+static Bitboard stepTargets(int sq, const int (*steps)[2], int count)
+{
+    Bitboard res = 0;
+    int x = fileOf(sq), y = rankOf(sq);
+    for (int i = 0; i < count; ++i)
+    {
+        int nx = x + steps[i][0], ny = y + steps[i][1];
+        if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8)
+            res |= squareBit(squareOf(nx, ny));
+    }
+    return res;
+}
+
+bool Attacks::init()
+{
+    static const int knightSteps[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+    static const int kingSteps[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+    static const int whitePawnSteps[2][2] = { { -1, 1 }, { 1, 1 } };
+    static const int blackPawnSteps[2][2] = { { -1, -1 }, { 1, -1 } };
+
+    for (int sq = 0; sq < 64; ++sq)
+    {
+        KNIGHT_ATTACKS[sq] = stepTargets(sq, knightSteps, 8);
+        KING_ATTACKS[sq] = stepTargets(sq, kingSteps, 8);
+        PAWN_ATTACKS[SIDE_WHITE][sq] = stepTargets(sq, whitePawnSteps, 2);
+        PAWN_ATTACKS[SIDE_BLACK][sq] = stepTargets(sq, blackPawnSteps, 2);
+
+        for (int dir = 0; dir < 8; ++dir)
+        {
+            Bitboard ray = 0;
+            int x = fileOf(sq) + DIR_X[dir], y = rankOf(sq) + DIR_Y[dir];
+            while (x >= 0 && x < 8 && y >= 0 && y < 8)
+            {
+                int to = squareOf(x, y);
+                BETWEEN[sq][to] = ray;
+                ray |= squareBit(to);
+                x += DIR_X[dir];
+                y += DIR_Y[dir];
+            }
+            RAYS[dir][sq] = ray;
+        }
+    }
+    return true;
+}
+
+Bitboard Attacks::ray(int dir, int sq, Bitboard occupied)
+{
+    Bitboard attacks = RAYS[dir][sq];
+    Bitboard blockers = attacks & occupied;
+    if (blockers)
+    {
+        int blocker = dir < 4 ? lsb(blockers) : msb(blockers);
+        attacks ^= RAYS[dir][blocker];
+    }
+    return attacks;
+}
+
+Bitboard Attacks::bishop(int sq, Bitboard occupied)
+{
+    return ray(2, sq, occupied) | ray(3, sq, occupied) | ray(6, sq, occupied) | ray(7, sq, occupied);
+}
+
+Bitboard Attacks::rook(int sq, Bitboard occupied)
+{
+    return ray(0, sq, occupied) | ray(1, sq, occupied) | ray(4, sq, occupied) | ray(5, sq, occupied);
+}
+
+Bitboard Attacks::piece(int type, int side, int sq, Bitboard occupied)
+{
+    switch (type)
+    {
+    case PAWN:
+        return PAWN_ATTACKS[side][sq];
+    case KNIGHT:
+        return KNIGHT_ATTACKS[sq];
+    case BISHOP:
+        return bishop(sq, occupied);
+    case ROOK:
+        return rook(sq, occupied);
+    case QUEEN:
+        return queen(sq, occupied);
+    case KING:
+        return KING_ATTACKS[sq];
+    default:
+        return 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Поле - индекс 0..63 = y * 8 + x, как у Position (a1 = 0, h8 = 63)
+using Bitboard = uint64_t;
+
+enum PieceType : int
+{
+    PAWN,
+    KNIGHT,
+    BISHOP,
+    ROOK,
+    QUEEN,
+    KING,
+    NO_PIECE_TYPE
+};
+
+enum Side : int
+{
+    SIDE_WHITE,
+    SIDE_BLACK
+};
+
+constexpr Bitboard squareBit(int sq) { return 1ULL << sq; }
+constexpr int squareOf(int x, int y) { return y * 8 + x; }
+constexpr int fileOf(int sq) { return sq & 7; }
+constexpr int rankOf(int sq) { return sq >> 3; }
+
+inline int popCount(Bitboard b)
+{
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+inline int lsb(Bitboard b)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int msb(Bitboard b)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, b);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b)
+{
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Таблицы атак заполняются один раз при загрузке программы
+class Attacks
+{
+public:
+    static Bitboard knight(int sq) { return KNIGHT_ATTACKS[sq]; }
+    static Bitboard king(int sq) { return KING_ATTACKS[sq]; }
+    static Bitboard pawn(int side, int sq) { return PAWN_ATTACKS[side][sq]; }
+    static Bitboard bishop(int sq, Bitboard occupied);
+    static Bitboard rook(int sq, Bitboard occupied);
+    static Bitboard queen(int sq, Bitboard occupied) { return bishop(sq, occupied) | rook(sq, occupied); }
+    static Bitboard piece(int type, int side, int sq, Bitboard occupied);
+
+    // Поля строго между a и b на одной линии (0, если не на одной линии)
+    static Bitboard between(int a, int b) { return BETWEEN[a][b]; }
+
+private:
+    static Bitboard KNIGHT_ATTACKS[64];
+    static Bitboard KING_ATTACKS[64];
+    static Bitboard PAWN_ATTACKS[2][64];
+    static Bitboard RAYS[8][64];
+    static Bitboard BETWEEN[64][64];
+
+    static Bitboard ray(int dir, int sq, Bitboard occupied);
+    static bool init();
+    static const bool initialized;
+};
\ No newline at end of file
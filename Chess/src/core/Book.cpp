@@ -0,0 +1,166 @@
+#include "Book.h"
+#include "board.h"
+#include <random>
+
+static uint64_t readBigEndian(const uint8_t* p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+bool Book::open(const std::string& path)
+{
+    if (!file.openReadOnly(path))
+        return false;
+
+    entries = file.size() / ENTRY_SIZE;
+    return entries > 0;
+}
+
+void Book::close()
+{
+    file.close();
+    entries = 0;
+}
+
+bool Book::isOpen() const
+{
+    return file.isOpen() && entries > 0;
+}
+
+size_t Book::size() const
+{
+    return entries;
+}
+
+uint64_t Book::keyAt(size_t index) const
+{
+    return readBigEndian(file.data() + index * ENTRY_SIZE, 8);
+}
+
+BookEntry Book::entryAt(size_t index) const
+{
+    const uint8_t* p = file.data() + index * ENTRY_SIZE;
+    BookEntry entry;
+    entry.key = readBigEndian(p, 8);
+    entry.move = static_cast<uint16_t>(readBigEndian(p + 8, 2));
+    entry.weight = static_cast<uint16_t>(readBigEndian(p + 10, 2));
+    entry.learn = static_cast<uint32_t>(readBigEndian(p + 12, 4));
+    return entry;
+}
+
+std::vector<BookEntry> Book::getEntries(uint64_t key) const
+{
+    std::vector<BookEntry> result;
+    if (!isOpen())
+        return result;
+
+    // бинарный поиск первой записи с нужным ключом прямо по отображённым страницам
+    size_t lo = 0, hi = entries;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keyAt(mid) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (size_t i = lo; i < entries && keyAt(i) == key; ++i)
+        result.push_back(entryAt(i));
+    return result;
+}
+
+std::optional<std::string> Book::probe(const Board& board) const
+{
+    std::vector<BookEntry> candidates = getEntries(board.getKey());
+
+    uint32_t totalWeight = 0;
+    for (const auto& entry : candidates)
+        totalWeight += entry.weight;
+    if (totalWeight == 0)
+        return std::nullopt;
+
+    thread_local std::mt19937 rng(std::random_device {}());
+    uint32_t pick = std::uniform_int_distribution<uint32_t>(0, totalWeight - 1)(rng);
+
+    const BookEntry* chosen = nullptr;
+    for (const auto& entry : candidates)
+    {
+        if (pick < entry.weight)
+        {
+            chosen = &entry;
+            break;
+        }
+        pick -= entry.weight;
+    }
+    if (!chosen)
+        return std::nullopt;
+
+    std::string uci = moveToUci(chosen->move);
+
+    // король "берёт" свою ладью - это рокировка, у нас король идёт на g или c
+    int fromX = uci[0] - 'a', fromY = uci[1] - '1';
+    int toX = uci[2] - 'a', toY = uci[3] - '1';
+    const auto& grid = board.getGrid();
+    const auto& mover = grid[fromY][fromX];
+    const auto& target = grid[toY][toX];
+    if (mover && target && mover->getType() == "king" && target->getType() == "rook"
+        && mover->getColor() == target->getColor())
+    {
+        uci[2] = (toX > fromX) ? 'g' : 'c';
+    }
+
+    return uci;
+}
+
+std::string Book::moveToUci(uint16_t move)
+{
+    static const char promotions[] = { 0, 'n', 'b', 'r', 'q' };
+
+    int toX = move & 7;
+    int toY = (move >> 3) & 7;
+    int fromX = (move >> 6) & 7;
+    int fromY = (move >> 9) & 7;
+    int promo = (move >> 12) & 7;
+
+    std::string uci;
+    uci += static_cast<char>('a' + fromX);
+    uci += static_cast<char>('1' + fromY);
+    uci += static_cast<char>('a' + toX);
+    uci += static_cast<char>('1' + toY);
+    if (promo > 0 && promo < 5)
+        uci += promotions[promo];
+    return uci;
+}
+
+uint16_t Book::uciToMove(const std::string& uci)
+{
+    if (uci.size() < 4)
+        return 0;
+
+    int fromX = uci[0] - 'a', fromY = uci[1] - '1';
+    int toX = uci[2] - 'a', toY = uci[3] - '1';
+    int promo = 0;
+    if (uci.size() >= 5)
+    {
+        switch (uci[4])
+        {
+        case 'n':
+            promo = 1;
+            break;
+        case 'b':
+            promo = 2;
+            break;
+        case 'r':
+            promo = 3;
+            break;
+        case 'q':
+            promo = 4;
+            break;
+        }
+    }
+    return static_cast<uint16_t>(toX | (toY << 3) | (fromX << 6) | (fromY << 9) | (promo << 12));
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Board;
+
+struct BookEntry
+{
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+// Дебютная книга в формате Polyglot (.bin): отсортированные по ключу 16-байтные записи в big-endian.
+// Файл отображается в память целиком, при открытии ничего не читается и не разбирается.
+class Book
+{
+public:
+    static constexpr size_t ENTRY_SIZE = 16;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    size_t size() const;
+
+    std::vector<BookEntry> getEntries(uint64_t key) const;
+
+    // Случайный ход с вероятностью, пропорциональной весу; ход в формате UCI
+    std::optional<std::string> probe(const Board& board) const;
+
+    // Ход Polyglot в UCI. Рокировка в Polyglot записана как взятие своей ладьи королём
+    static std::string moveToUci(uint16_t move);
+    static uint16_t uciToMove(const std::string& uci);
+
+private:
+    MappedFile file;
+    size_t entries = 0;
+
+    BookEntry entryAt(size_t index) const;
+    uint64_t keyAt(size_t index) const;
+};
\ No newline at end of file
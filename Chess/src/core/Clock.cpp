@@ -6,30 +6,34 @@ Clock::Clock(float startTimeSeconds, float inc, bool isWhite)
     , increment(inc * 1000)
     , isWhiteTurn(isWhite)
     , isPaused(true)
+    , lastUpdate(std::chrono::steady_clock::now())
 {
 }
 
 void Clock::start()
 {
     isPaused = false;
+    lastUpdate = std::chrono::steady_clock::now();
 }
 
 void Clock::update()
 {
-    sf::Time dt = deltaClock.restart();
+    auto now = std::chrono::steady_clock::now();
+    double dt = std::chrono::duration<double, std::milli>(now - lastUpdate).count();
+    lastUpdate = now;
 
     if (isPaused)
         return;
 
     if (isWhiteTurn)
     {
-        timeWhite -= dt.asMilliseconds();
+        timeWhite -= dt;
         if (timeWhite < 0)
             timeWhite = 0;
     }
     else
     {
-        timeBlack -= dt.asMilliseconds();
+        timeBlack -= dt;
         if (timeBlack < 0)
             timeBlack = 0;
     }
@@ -40,6 +44,8 @@ void Clock::switchTurn()
     if (isPaused)
         return;
 
+    // ход сделан сейчас, а не в момент последнего кадра
+    update();
     if (isWhiteTurn)
         timeWhite += increment;
     else
@@ -47,6 +53,13 @@ void Clock::switchTurn()
     isWhiteTurn = !isWhiteTurn;
 }
 
+void Clock::setTimes(float whiteSeconds, float blackSeconds)
+{
+    timeWhite = whiteSeconds * 1000.0;
+    timeBlack = blackSeconds * 1000.0;
+    lastUpdate = std::chrono::steady_clock::now();
+}
+
 bool Clock::isTimeUp() const
 {
     return timeWhite <= 0 || timeBlack <= 0;
@@ -62,6 +75,11 @@ float Clock::getBlackTime() const
     return timeBlack / 1000;
 }
 
+float Clock::getIncrement() const
+{
+    return increment / 1000;
+}
+
 void Clock::stop()
 {
     isPaused = true;
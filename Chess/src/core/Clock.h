@@ -1,19 +1,20 @@
 #pragma once
-#include <SFML/Graphics.hpp>
-#include <SFML/System.hpp>
+#include <chrono>
 #include <string>
 #include <iomanip> 
 #include <sstream>
 
+// Шахматные часы. Время списывается по монотонным часам между вызовами update() и при смене хода,
+// поэтому не зависит от длительности кадров и не теряет доли миллисекунд.
 class Clock {
-    float timeWhite; 
-    float timeBlack; 
-    float increment; 
+    double timeWhite; 
+    double timeBlack; 
+    double increment; 
 
     bool isWhiteTurn;
     bool isPaused; 
 
-    sf::Clock deltaClock; 
+    std::chrono::steady_clock::time_point lastUpdate;
 
 public:
     
@@ -22,8 +23,11 @@ public:
     void start();
     void update();
     void switchTurn();
+    // Время от сервера сетевой партии заменяет своё; отсчёт продолжается с этого момента
+    void setTimes(float whiteSeconds, float blackSeconds);
     bool isTimeUp() const;
     float getWhiteTime() const;
     float getBlackTime() const;
+    float getIncrement() const;
     void stop();
 };
\ No newline at end of file
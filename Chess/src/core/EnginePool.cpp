@@ -0,0 +1,349 @@
+#include "EnginePool.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+EnginePool::EnginePool(std::string enginePath, size_t size, size_t memoryBudgetMb)
+    : enginePath(std::move(enginePath))
+{
+    size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (size == 0 || size > cores)
+        size = cores;
+    if (memoryBudgetMb > 0)
+        size = std::min<size_t>(size, std::max<size_t>(1, memoryBudgetMb / ENGINE_MEMORY_MB));
+    this->size = size;
+    latencies.reserve(LATENCY_WINDOW);
+}
+
+EnginePool::~EnginePool()
+{
+    stop();
+}
+
+bool EnginePool::start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running)
+        return true;
+
+    engines.clear();
+    idle.clear();
+    for (size_t i = 0; i < size; ++i)
+    {
+        auto engine = std::make_unique<Stockfish>(enginePath);
+        if (!engine->start())
+        {
+            std::cerr << "EnginePool: failed to start engine " << i << std::endl;
+            continue;
+        }
+        idle.push_back(engine.get());
+        engines.push_back(std::move(engine));
+    }
+
+    running = !engines.empty();
+    return running;
+}
+
+void EnginePool::stop()
+{
+    // движок, занятый размышлением, иначе не вернётся в пул
+    cancelPonder();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running)
+        return;
+    running = false;
+
+    // будим всех ожидающих - они получат пустой результат
+    for (Waiter* waiter : queue)
+        waiter->cv.notify_one();
+    queue.clear();
+
+    // ждём возврата выданных движков, чтобы не уничтожить их посреди поиска
+    allReturned.wait(lock, [this]() { return idle.size() == engines.size(); });
+
+    for (auto& engine : engines)
+        engine->stop();
+    idle.clear();
+    engines.clear();
+}
+
+std::optional<std::string> EnginePool::getBestMove(const std::string& fen, int moveTimeMs, std::chrono::milliseconds deadline)
+{
+    auto result = analyse(fen, moveTimeMs, deadline);
+    if (!result)
+        return std::nullopt;
+    return result->bestMove;
+}
+
+std::optional<AnalysisResult> EnginePool::analyse(const std::string& fen, int moveTimeMs, std::chrono::milliseconds deadline)
+{
+    auto enqueued = std::chrono::steady_clock::now();
+    auto deadlineTime = enqueued + deadline;
+
+    std::shared_ptr<AnalysisCache> cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache = this->cache;
+    }
+
+    uint64_t key = cache ? Zobrist::hashFen(fen) : 0;
+    if (key)
+    {
+        if (auto cached = cache->lookup(key, moveTimeMs))
+        {
+            std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - enqueued;
+            std::lock_guard<std::mutex> lock(mutex);
+            ++served;
+            ++cacheHits;
+            recordLatency(latency.count());
+            return cached;
+        }
+    }
+
+    Stockfish* engine = lease(deadlineTime);
+    if (!engine)
+        return std::nullopt;
+
+    if (!ensureAlive(engine))
+    {
+        release(engine, false);
+        return std::nullopt;
+    }
+
+    // движку даём не больше, чем осталось до дедлайна (с запасом на обмен по трубам)
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadlineTime - std::chrono::steady_clock::now()).count() - 50;
+    int moveTime = static_cast<int>(std::min<long long>(moveTimeMs, left));
+    if (moveTime <= 0)
+    {
+        release(engine, true);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++timeouts;
+        return std::nullopt;
+    }
+
+    AnalysisResult result = engine->analyse(fen, moveTime);
+    bool healthy = !result.bestMove.empty();
+    release(engine, healthy);
+
+    // в кеш кладём с запрошенным лимитом, только если движку не урезали время
+    if (key && healthy && moveTime == moveTimeMs)
+        cache->store(key, moveTimeMs, result);
+
+    std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - enqueued;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!healthy)
+    {
+        ++timeouts;
+        return std::nullopt;
+    }
+    ++served;
+    recordLatency(latency.count());
+    return result;
+}
+
+bool EnginePool::startPonder(const std::string& fen, const std::string& expectedMove, int moveTimeMs)
+{
+    Stockfish* engine;
+    {
+        // ждать движок ради размышления не стоит - очередь важнее
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running || ponderEngine || ponderStarting || !queue.empty() || idle.empty())
+            return false;
+        engine = idle.back();
+        idle.pop_back();
+        ponderStarting = true;
+    }
+
+    bool alive = ensureAlive(engine);
+    if (alive)
+        engine->ponder(fen, expectedMove, moveTimeMs);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ponderStarting = false;
+        // stop() мог пройти, пока перебор запускался: тогда движок сразу возвращается в пул
+        if (alive && running)
+        {
+            ponderEngine = engine;
+            ponderExpected = expectedMove;
+            ponderMoveTimeMs = moveTimeMs;
+            return true;
+        }
+    }
+
+    if (alive)
+        engine->cancelPonder();
+    release(engine, alive);
+    return false;
+}
+
+std::optional<AnalysisResult> EnginePool::finishPonder(const std::string& playedMove)
+{
+    Stockfish* engine;
+    std::string expected;
+    int moveTimeMs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        engine = ponderEngine;
+        expected = ponderExpected;
+        moveTimeMs = ponderMoveTimeMs;
+        ponderEngine = nullptr;
+    }
+    if (!engine)
+        return std::nullopt;
+
+    if (playedMove != expected)
+    {
+        engine->cancelPonder();
+        release(engine, true);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!playedMove.empty())
+            ++ponderMisses;
+        return std::nullopt;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    AnalysisResult result = engine->ponderHit(moveTimeMs);
+    bool healthy = !result.bestMove.empty();
+    release(engine, healthy);
+
+    std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - started;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!healthy)
+    {
+        ++timeouts;
+        return std::nullopt;
+    }
+    ++served;
+    ++ponderHits;
+    recordLatency(latency.count());
+    return result;
+}
+
+void EnginePool::cancelPonder()
+{
+    finishPonder("");
+}
+
+Stockfish* EnginePool::lease(TimePoint deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running)
+        return nullptr;
+
+    if (queue.empty() && !idle.empty())
+    {
+        Stockfish* engine = idle.back();
+        idle.pop_back();
+        return engine;
+    }
+
+    // FIFO: освободившийся движок передаётся первому в очереди напрямую
+    Waiter waiter;
+    queue.push_back(&waiter);
+    bool got = waiter.cv.wait_until(lock, deadline, [&]() { return waiter.engine != nullptr || !running; });
+
+    if (waiter.engine)
+        return waiter.engine;
+
+    if (!got)
+        ++timeouts;
+    auto it = std::find(queue.begin(), queue.end(), &waiter);
+    if (it != queue.end())
+        queue.erase(it);
+    return nullptr;
+}
+
+void EnginePool::release(Stockfish* engine, bool healthy)
+{
+    bool restart;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        restart = !healthy && running;
+    }
+
+    // движок, не ответивший вовремя, мог остаться посреди поиска - перезапускаем
+    if (restart)
+    {
+        engine->stop();
+        engine->start();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (restart)
+        ++restarts;
+    if (running && !queue.empty())
+    {
+        Waiter* next = queue.front();
+        queue.pop_front();
+        next->engine = engine;
+        next->cv.notify_one();
+        return;
+    }
+    idle.push_back(engine);
+    allReturned.notify_all();
+}
+
+bool EnginePool::ensureAlive(Stockfish* engine)
+{
+    if (engine->isAlive())
+        return true;
+
+    std::cerr << "EnginePool: engine crashed, restarting" << std::endl;
+    engine->stop();
+    bool started = engine->start();
+    std::lock_guard<std::mutex> lock(mutex);
+    ++restarts;
+    return started;
+}
+
+void EnginePool::recordLatency(double ms)
+{
+    if (latencies.size() < LATENCY_WINDOW)
+        latencies.push_back(ms);
+    else
+        latencies[latencyPos] = ms;
+    latencyPos = (latencyPos + 1) % LATENCY_WINDOW;
+}
+
+EnginePoolStats EnginePool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    EnginePoolStats stats;
+    stats.engines = engines.size();
+    stats.busy = engines.size() - idle.size();
+    stats.queueDepth = queue.size();
+    stats.served = served;
+    stats.cacheHits = cacheHits;
+    stats.timeouts = timeouts;
+    stats.restarts = restarts;
+    stats.ponderHits = ponderHits;
+    stats.ponderMisses = ponderMisses;
+
+    if (!latencies.empty())
+    {
+        std::vector<double> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p) {
+            return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+        };
+        stats.latencyP50Ms = percentile(0.50);
+        stats.latencyP90Ms = percentile(0.90);
+        stats.latencyP99Ms = percentile(0.99);
+    }
+    return stats;
+}
+
+size_t EnginePool::getSize() const
+{
+    return size;
+}
+
+void EnginePool::setCache(std::shared_ptr<AnalysisCache> cache)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->cache = std::move(cache);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include "AnalysisCache.h"
+#include "Stockfish.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct EnginePoolStats
+{
+    size_t engines = 0;
+    size_t busy = 0;
+    size_t queueDepth = 0;
+    size_t served = 0;
+    size_t cacheHits = 0;
+    size_t timeouts = 0;
+    size_t restarts = 0;
+    size_t ponderHits = 0;
+    size_t ponderMisses = 0;
+    double latencyP50Ms = 0;
+    double latencyP90Ms = 0;
+    double latencyP99Ms = 0;
+};
+
+// Пул заранее запущенных процессов движка. Запросы обслуживаются строго по очереди,
+// каждый со своим дедлайном; упавшие движки перезапускаются перед выдачей.
+class EnginePool
+{
+public:
+    // Примерный расход памяти одним процессом Stockfish с настройками по умолчанию
+    static constexpr size_t ENGINE_MEMORY_MB = 64;
+
+    // size == 0 - по числу ядер; memoryBudgetMb == 0 - без ограничения по памяти
+    EnginePool(std::string enginePath, size_t size = 0, size_t memoryBudgetMb = 0);
+    ~EnginePool();
+
+    bool start();
+    void stop();
+
+    // Пустой результат - дедлайн истёк в очереди или движок не ответил
+    std::optional<std::string> getBestMove(const std::string& fen, int moveTimeMs, std::chrono::milliseconds deadline);
+    std::optional<AnalysisResult> analyse(const std::string& fen, int moveTimeMs, std::chrono::milliseconds deadline);
+
+    // Перебор на времени соперника: fen - позиция после своего хода, expectedMove - ожидаемый ответ.
+    // Движок закрепляется за перебором до finishPonder; false - свободного движка нет или перебор уже идёт
+    bool startPonder(const std::string& fen, const std::string& expectedMove, int moveTimeMs);
+    // Соперник сыграл playedMove. При попадании ответ даёт уже идущий перебор, при промахе
+    // перебор останавливается и возвращается пустой результат - ход ищется обычным запросом
+    std::optional<AnalysisResult> finishPonder(const std::string& playedMove);
+    void cancelPonder();
+
+    EnginePoolStats getStats() const;
+    size_t getSize() const;
+
+    // Кеш проверяется до обращения к движку; найденные движком ходы попадают в кеш
+    void setCache(std::shared_ptr<AnalysisCache> cache);
+
+private:
+    struct Waiter
+    {
+        std::condition_variable cv;
+        Stockfish* engine = nullptr;
+    };
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    std::string enginePath;
+    size_t size;
+    std::shared_ptr<AnalysisCache> cache;
+
+    std::vector<std::unique_ptr<Stockfish>> engines;
+    std::vector<Stockfish*> idle;
+    std::deque<Waiter*> queue;
+    bool running = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable allReturned;
+
+    static constexpr size_t LATENCY_WINDOW = 1024;
+    std::vector<double> latencies;
+    size_t latencyPos = 0;
+    size_t served = 0;
+    size_t cacheHits = 0;
+    size_t timeouts = 0;
+    size_t restarts = 0;
+    size_t ponderHits = 0;
+    size_t ponderMisses = 0;
+
+    // одновременно идёт не больше одного перебора на времени соперника
+    Stockfish* ponderEngine = nullptr;
+    // движок уже взят под перебор, но ещё не запущен: место занято, второй перебор не начнётся
+    bool ponderStarting = false;
+    std::string ponderExpected;
+    int ponderMoveTimeMs = 0;
+
+    Stockfish* lease(TimePoint deadline);
+    void release(Stockfish* engine, bool healthy);
+    bool ensureAlive(Stockfish* engine);
+    void recordLatency(double ms);
+};
\ No newline at end of file
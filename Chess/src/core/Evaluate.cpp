@@ -0,0 +1,185 @@
+#include "Evaluate.h"
+#include "EvalParams.h"
+#include <algorithm>
+
+static const int PHASE_WEIGHT[6] = { 0, 1, 1, 2, 4, 0 };
+
+static Bitboard FILE_MASK[8];
+static Bitboard ADJACENT_FILES[8];
+static Bitboard PASSED_MASK[2][64]; // поля впереди на своей и соседних вертикалях
+static Bitboard FORWARD_FILE[2][64];
+
+static int WEIGHT_MG[TERM_COUNT];
+static int WEIGHT_EG[TERM_COUNT];
+
+static void setWeight(int term, int mg, int eg)
+{
+    WEIGHT_MG[term] = mg;
+    WEIGHT_EG[term] = eg;
+}
+
+static bool init()
+{
+    for (int type = PAWN; type <= KING; ++type)
+    {
+        setWeight(TERM_MATERIAL + type, MATERIAL_MG[type], MATERIAL_EG[type]);
+        setWeight(TERM_MOBILITY + type, MOBILITY_MG[type], MOBILITY_EG[type]);
+        for (int sq = 0; sq < 64; ++sq)
+            setWeight(TERM_PST + type * 64 + sq, PST_MG[type][sq], PST_EG[type][sq]);
+    }
+    for (int rank = 0; rank < 8; ++rank)
+        setWeight(TERM_PASSED_PAWN + rank, PASSED_PAWN_MG[rank], PASSED_PAWN_EG[rank]);
+    setWeight(TERM_BISHOP_PAIR, BISHOP_PAIR_MG, BISHOP_PAIR_EG);
+    setWeight(TERM_DOUBLED_PAWN, DOUBLED_PAWN_MG, DOUBLED_PAWN_EG);
+    setWeight(TERM_ISOLATED_PAWN, ISOLATED_PAWN_MG, ISOLATED_PAWN_EG);
+    setWeight(TERM_ROOK_OPEN_FILE, ROOK_OPEN_FILE_MG, ROOK_OPEN_FILE_EG);
+    setWeight(TERM_ROOK_SEMI_OPEN_FILE, ROOK_SEMI_OPEN_FILE_MG, ROOK_SEMI_OPEN_FILE_EG);
+    setWeight(TERM_TEMPO, TEMPO_MG, TEMPO_EG);
+
+    for (int x = 0; x < 8; ++x)
+        FILE_MASK[x] = 0x0101010101010101ULL << x;
+    for (int x = 0; x < 8; ++x)
+        ADJACENT_FILES[x] = (x > 0 ? FILE_MASK[x - 1] : 0) | (x < 7 ? FILE_MASK[x + 1] : 0);
+    for (int sq = 0; sq < 64; ++sq)
+    {
+        int x = fileOf(sq), y = rankOf(sq);
+        for (int r = 0; r < 8; ++r)
+        {
+            Bitboard rank = 0xFFULL << (8 * r);
+            Bitboard files = FILE_MASK[x] | ADJACENT_FILES[x];
+            if (r > y)
+            {
+                PASSED_MASK[SIDE_WHITE][sq] |= files & rank;
+                FORWARD_FILE[SIDE_WHITE][sq] |= FILE_MASK[x] & rank;
+            }
+            if (r < y)
+            {
+                PASSED_MASK[SIDE_BLACK][sq] |= files & rank;
+                FORWARD_FILE[SIDE_BLACK][sq] |= FILE_MASK[x] & rank;
+            }
+        }
+    }
+    return true;
+}
+
+static const bool initialized = init();
+
+static Bitboard pawnAttacks(int side, Bitboard pawns)
+{
+    Bitboard notA = ~FILE_MASK[0], notH = ~FILE_MASK[7];
+    if (side == SIDE_WHITE)
+        return ((pawns & notA) << 7) | ((pawns & notH) << 9);
+    return ((pawns & notA) >> 9) | ((pawns & notH) >> 7);
+}
+
+int Evaluator::pieceValue(int type)
+{
+    return MATERIAL_MG[type];
+}
+
+int Evaluator::phase(const FastBoard& pos)
+{
+    int phase = 0;
+    for (int type = KNIGHT; type <= QUEEN; ++type)
+        phase += PHASE_WEIGHT[type] * popCount(pos.piecesOfType(type));
+    return std::min(phase, MAX_PHASE);
+}
+
+// Члены оценки передаются приёмнику: при игре он суммирует веса, при настройке - считает коэффициенты
+struct ScoreSink
+{
+    int mg[2] = { 0, 0 };
+    int eg[2] = { 0, 0 };
+
+    void add(int side, int term, int count = 1)
+    {
+        mg[side] += WEIGHT_MG[term] * count;
+        eg[side] += WEIGHT_EG[term] * count;
+    }
+};
+
+struct TraceSink
+{
+    int* coefficients;
+
+    void add(int side, int term, int count = 1)
+    {
+        coefficients[term] += side == SIDE_WHITE ? count : -count;
+    }
+};
+
+template <typename Sink>
+static void collectTerms(const FastBoard& pos, Sink& sink)
+{
+    Bitboard occ = pos.occupied();
+    Bitboard pawns[2] = { pos.pieces(SIDE_WHITE, PAWN), pos.pieces(SIDE_BLACK, PAWN) };
+    Bitboard attackedByPawns[2] = { pawnAttacks(SIDE_WHITE, pawns[0]), pawnAttacks(SIDE_BLACK, pawns[1]) };
+
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; ++side)
+    {
+        int them = side ^ 1;
+        for (int type = PAWN; type <= KING; ++type)
+        {
+            Bitboard bb = pos.pieces(side, type);
+            while (bb)
+            {
+                int sq = popLsb(bb);
+                int rel = side == SIDE_WHITE ? sq : sq ^ 56;
+                sink.add(side, TERM_MATERIAL + type);
+                sink.add(side, TERM_PST + type * 64 + rel);
+
+                if (type >= KNIGHT && type <= QUEEN)
+                {
+                    int mobility = popCount(Attacks::piece(type, side, sq, occ) & ~pos.piecesOf(side) & ~attackedByPawns[them]);
+                    sink.add(side, TERM_MOBILITY + type, mobility);
+                }
+
+                if (type == PAWN)
+                {
+                    if (!(PASSED_MASK[side][sq] & pawns[them]) && !(FORWARD_FILE[side][sq] & pawns[side]))
+                        sink.add(side, TERM_PASSED_PAWN + rankOf(rel));
+                    if (FORWARD_FILE[side][sq] & pawns[side])
+                        sink.add(side, TERM_DOUBLED_PAWN);
+                    if (!(ADJACENT_FILES[fileOf(sq)] & pawns[side]))
+                        sink.add(side, TERM_ISOLATED_PAWN);
+                }
+                else if (type == ROOK)
+                {
+                    Bitboard file = FILE_MASK[fileOf(sq)];
+                    if (!(file & (pawns[0] | pawns[1])))
+                        sink.add(side, TERM_ROOK_OPEN_FILE);
+                    else if (!(file & pawns[side]))
+                        sink.add(side, TERM_ROOK_SEMI_OPEN_FILE);
+                }
+            }
+        }
+
+        if (popCount(pos.pieces(side, BISHOP)) >= 2)
+            sink.add(side, TERM_BISHOP_PAIR);
+    }
+
+    sink.add(pos.sideToMove(), TERM_TEMPO);
+}
+
+int Evaluator::evaluate(const FastBoard& pos)
+{
+    ScoreSink sink;
+    collectTerms(pos, sink);
+
+    int gamePhase = phase(pos);
+    int score = ((sink.mg[0] - sink.mg[1]) * gamePhase + (sink.eg[0] - sink.eg[1]) * (MAX_PHASE - gamePhase)) / MAX_PHASE;
+    return pos.sideToMove() == SIDE_WHITE ? score : -score;
+}
+
+void Evaluator::trace(const FastBoard& pos, int* coefficients)
+{
+    std::fill(coefficients, coefficients + TERM_COUNT, 0);
+    TraceSink sink { coefficients };
+    collectTerms(pos, sink);
+}
+
+void Evaluator::getWeights(int* mg, int* eg)
+{
+    std::copy(WEIGHT_MG, WEIGHT_MG + TERM_COUNT, mg);
+    std::copy(WEIGHT_EG, WEIGHT_EG + TERM_COUNT, eg);
+}
\ No newline at end of file
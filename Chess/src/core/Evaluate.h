@@ -0,0 +1,37 @@
+#pragma once
+#include "FastBoard.h"
+
+// Линейные члены оценки в порядке таблиц EvalParams.h; у каждого вес для миттельшпиля и для эндшпиля
+enum EvalTerm : int
+{
+    TERM_MATERIAL = 0,
+    TERM_PST = TERM_MATERIAL + 6,
+    TERM_MOBILITY = TERM_PST + 6 * 64,
+    TERM_PASSED_PAWN = TERM_MOBILITY + 6,
+    TERM_BISHOP_PAIR = TERM_PASSED_PAWN + 8,
+    TERM_DOUBLED_PAWN,
+    TERM_ISOLATED_PAWN,
+    TERM_ROOK_OPEN_FILE,
+    TERM_ROOK_SEMI_OPEN_FILE,
+    TERM_TEMPO,
+    TERM_COUNT
+};
+
+// Оценка позиции по параметрам из EvalParams.h: материал, таблицы полей, подвижность, пешечная
+// структура. Смешивается между миттельшпилем и эндшпилем по количеству фигур на доске.
+class Evaluator
+{
+public:
+    static constexpr int MAX_PHASE = 24;
+
+    // В сантипешках с точки зрения стороны, которая ходит
+    static int evaluate(const FastBoard& pos);
+    // MAX_PHASE - все фигуры на доске, 0 - остались короли и пешки
+    static int phase(const FastBoard& pos);
+    static int pieceValue(int type);
+
+    // Сколько раз сработал каждый член (белые минус чёрные): оценка белых линейна по весам
+    static void trace(const FastBoard& pos, int* coefficients);
+    // Текущие веса в порядке EvalTerm
+    static void getWeights(int* mg, int* eg);
+};
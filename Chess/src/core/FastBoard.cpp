@@ -0,0 +1,640 @@
+#include "FastBoard.h"
+#include "Zobrist.h"
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+const char* FastBoard::START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static const char PIECE_CHARS[] = "pnbrqk";
+
+// Вид фигуры в раскладке Polyglot: чёрные на чётных местах, белые на нечётных
+static int polyglotKind(int side, int type)
+{
+    return 2 * type + (side == SIDE_WHITE ? 1 : 0);
+}
+
+FastBoard::FastBoard()
+{
+    clear();
+}
+
+void FastBoard::clear()
+{
+    std::memset(byColor, 0, sizeof(byColor));
+    std::memset(byType, 0, sizeof(byType));
+    std::memset(board, -1, sizeof(board));
+    std::memset(castlingRook, -1, sizeof(castlingRook));
+    std::memset(castlingMask, 0xFF, sizeof(castlingMask));
+    side = SIDE_WHITE;
+    epSquare = -1;
+    castling = 0;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    key = Zobrist::keys()[Zobrist::TURN_OFFSET];
+}
+
+void FastBoard::putPiece(int pieceSide, int type, int sq)
+{
+    Bitboard bit = squareBit(sq);
+    byColor[pieceSide] |= bit;
+    byType[type] |= bit;
+    board[sq] = static_cast<int8_t>(pieceSide * 6 + type);
+    key ^= Zobrist::pieceKey(polyglotKind(pieceSide, type), fileOf(sq), rankOf(sq));
+}
+
+void FastBoard::removePiece(int sq)
+{
+    int piece = board[sq];
+    if (piece < 0)
+        return;
+    Bitboard bit = squareBit(sq);
+    byColor[pieceSide(piece)] ^= bit;
+    byType[pieceType(piece)] ^= bit;
+    board[sq] = -1;
+    key ^= Zobrist::pieceKey(polyglotKind(pieceSide(piece), pieceType(piece)), fileOf(sq), rankOf(sq));
+}
+
+void FastBoard::setSideToMove(int newSide)
+{
+    if (newSide != side)
+    {
+        side = newSide;
+        key ^= Zobrist::keys()[Zobrist::TURN_OFFSET];
+    }
+}
+
+void FastBoard::addCastling(int sideIndex, int rookSq)
+{
+    int castleSide = sideIndex / 2;
+    castling |= static_cast<uint8_t>(1 << sideIndex);
+    castlingRook[sideIndex] = static_cast<int8_t>(rookSq);
+    castlingMask[rookSq] &= static_cast<uint8_t>(~(1 << sideIndex));
+    castlingMask[kingSquare(castleSide)] &= static_cast<uint8_t>(~(3 << (2 * castleSide)));
+    key ^= Zobrist::keys()[Zobrist::CASTLE_OFFSET + sideIndex];
+}
+
+bool FastBoard::setFen(const std::string& fen)
+{
+    std::istringstream ss(fen);
+    std::string placement, turn, rights = "-", ep = "-";
+    if (!(ss >> placement >> turn))
+        return false;
+    ss >> rights >> ep;
+    int halfmove = 0, fullmove = 1;
+    ss >> halfmove >> fullmove;
+
+    clear();
+
+    int x = 0, y = 7;
+    for (char c : placement)
+    {
+        if (c == '/')
+        {
+            x = 0;
+            --y;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)))
+            x += c - '0';
+        else
+        {
+            const char* p = std::strchr(PIECE_CHARS, std::tolower(static_cast<unsigned char>(c)));
+            if (!p || x > 7 || y < 0)
+                return false;
+            putPiece(std::isupper(static_cast<unsigned char>(c)) ? SIDE_WHITE : SIDE_BLACK, static_cast<int>(p - PIECE_CHARS), squareOf(x, y));
+            ++x;
+        }
+    }
+    if (popCount(pieces(SIDE_WHITE, KING)) != 1 || popCount(pieces(SIDE_BLACK, KING)) != 1)
+        return false;
+
+    setSideToMove(turn == "b" ? SIDE_BLACK : SIDE_WHITE);
+
+    for (char c : rights)
+    {
+        if (c == '-')
+            break;
+        int castleSide = std::isupper(static_cast<unsigned char>(c)) ? SIDE_WHITE : SIDE_BLACK;
+        char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        int homeY = castleSide == SIDE_WHITE ? 0 : 7;
+        int kingX = fileOf(kingSquare(castleSide));
+        if (rankOf(kingSquare(castleSide)) != homeY)
+            continue;
+
+        // K/Q - крайняя ладья со своей стороны (X-FEN), буква вертикали - конкретная ладья (Shredder-FEN)
+        int rookX = -1;
+        if (lower == 'k' || lower == 'q')
+        {
+            int dx = lower == 'k' ? -1 : 1;
+            for (int rx = lower == 'k' ? 7 : 0; rx != kingX; rx += dx)
+            {
+                if (board[squareOf(rx, homeY)] == castleSide * 6 + ROOK)
+                {
+                    rookX = rx;
+                    break;
+                }
+            }
+        }
+        else if (lower >= 'a' && lower <= 'h')
+        {
+            rookX = lower - 'a';
+            chess960 = true;
+        }
+        if (rookX < 0 || rookX == kingX || board[squareOf(rookX, homeY)] != castleSide * 6 + ROOK)
+            continue;
+
+        int sideIndex = 2 * castleSide + (rookX > kingX ? 0 : 1);
+        if (!(castling & (1 << sideIndex)))
+            addCastling(sideIndex, squareOf(rookX, homeY));
+    }
+    if (((castling & 3) && fileOf(kingSquare(SIDE_WHITE)) != 4) || ((castling & 12) && fileOf(kingSquare(SIDE_BLACK)) != 4))
+        chess960 = true;
+
+    if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && (ep[1] == '3' || ep[1] == '6'))
+        epSquare = squareOf(ep[0] - 'a', ep[1] - '1');
+
+    halfmoveClock = halfmove;
+    fullmoveNumber = fullmove > 0 ? fullmove : 1;
+    return true;
+}
+
+std::string FastBoard::getFen() const
+{
+    std::ostringstream ss;
+    for (int y = 7; y >= 0; --y)
+    {
+        int empty = 0;
+        for (int x = 0; x < 8; ++x)
+        {
+            int piece = board[squareOf(x, y)];
+            if (piece < 0)
+            {
+                ++empty;
+                continue;
+            }
+            if (empty > 0)
+            {
+                ss << empty;
+                empty = 0;
+            }
+            char c = PIECE_CHARS[pieceType(piece)];
+            ss << static_cast<char>(pieceSide(piece) == SIDE_WHITE ? std::toupper(c) : c);
+        }
+        if (empty > 0)
+            ss << empty;
+        if (y > 0)
+            ss << '/';
+    }
+
+    ss << (side == SIDE_WHITE ? " w " : " b ");
+
+    std::string rights;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!(castling & (1 << i)))
+            continue;
+        int castleSide = i / 2;
+        int rookSq = castlingRook[i];
+        // K/Q пишем, только если ладья крайняя, иначе вертикаль ладьи
+        bool outermost = true;
+        int dx = (i % 2 == 0) ? 1 : -1;
+        for (int x = fileOf(rookSq) + dx; x >= 0 && x < 8; x += dx)
+        {
+            if (board[squareOf(x, rankOf(rookSq))] == castleSide * 6 + ROOK)
+                outermost = false;
+        }
+        char c = outermost ? (i % 2 == 0 ? 'k' : 'q') : static_cast<char>('a' + fileOf(rookSq));
+        rights += static_cast<char>(castleSide == SIDE_WHITE ? std::toupper(c) : c);
+    }
+    ss << (rights.empty() ? "-" : rights) << ' ';
+
+    if (epSquare >= 0)
+        ss << static_cast<char>('a' + fileOf(epSquare)) << static_cast<char>('1' + rankOf(epSquare));
+    else
+        ss << '-';
+
+    ss << ' ' << halfmoveClock << ' ' << fullmoveNumber;
+    return ss.str();
+}
+
+bool FastBoard::epCapturable() const
+{
+    return epSquare >= 0 && (Attacks::pawn(side ^ 1, epSquare) & pieces(side, PAWN));
+}
+
+uint64_t FastBoard::getKey() const
+{
+    // Как в Polyglot: взятие на проходе входит в ключ, только если оно возможно
+    if (epCapturable())
+        return key ^ Zobrist::keys()[Zobrist::EN_PASSANT_OFFSET + fileOf(epSquare)];
+    return key;
+}
+
+Bitboard FastBoard::attackersTo(int sq, Bitboard occ) const
+{
+    return (Attacks::pawn(SIDE_WHITE, sq) & pieces(SIDE_BLACK, PAWN))
+        | (Attacks::pawn(SIDE_BLACK, sq) & pieces(SIDE_WHITE, PAWN))
+        | (Attacks::knight(sq) & byType[KNIGHT])
+        | (Attacks::king(sq) & byType[KING])
+        | (Attacks::bishop(sq, occ) & (byType[BISHOP] | byType[QUEEN]))
+        | (Attacks::rook(sq, occ) & (byType[ROOK] | byType[QUEEN]));
+}
+
+bool FastBoard::isAttacked(int sq, int bySide) const
+{
+    return (attackersTo(sq, occupied()) & byColor[bySide]) != 0;
+}
+
+bool FastBoard::inCheck() const
+{
+    return isAttacked(kingSquare(side), side ^ 1);
+}
+
+bool FastBoard::isCapture(FastMove m) const
+{
+    return moveFlag(m) == FLAG_EN_PASSANT || (moveFlag(m) != FLAG_CASTLING && board[moveTo(m)] >= 0);
+}
+
+int FastBoard::castlingIndex(FastMove m) const
+{
+    return 2 * side + (fileOf(moveTo(m)) == 6 ? 0 : 1);
+}
+
+void FastBoard::generatePseudo(MoveList& list, bool capturesOnly) const
+{
+    int us = side, them = side ^ 1;
+    Bitboard own = byColor[us], enemy = byColor[them], occ = own | enemy;
+    int forward = us == SIDE_WHITE ? 8 : -8;
+    int startRank = us == SIDE_WHITE ? 1 : 6;
+    int lastRank = us == SIDE_WHITE ? 7 : 0;
+
+    auto addPawnMove = [&](int from, int to, int flag) {
+        if (rankOf(to) == lastRank)
+        {
+            for (int promo = FLAG_PROMO_QUEEN; promo >= FLAG_PROMO_KNIGHT; --promo)
+                list.push(makeFastMove(from, to, promo));
+        }
+        else
+            list.push(makeFastMove(from, to, flag));
+    };
+
+    Bitboard pawns = pieces(us, PAWN);
+    while (pawns)
+    {
+        int from = popLsb(pawns);
+        int to = from + forward;
+        if (!(occ & squareBit(to)) && (!capturesOnly || rankOf(to) == lastRank))
+        {
+            addPawnMove(from, to, FLAG_NORMAL);
+            if (rankOf(from) == startRank && !(occ & squareBit(to + forward)))
+                list.push(makeFastMove(from, to + forward, FLAG_DOUBLE_PUSH));
+        }
+        Bitboard captures = Attacks::pawn(us, from) & enemy;
+        while (captures)
+            addPawnMove(from, popLsb(captures), FLAG_NORMAL);
+        if (epSquare >= 0 && (Attacks::pawn(us, from) & squareBit(epSquare)))
+            list.push(makeFastMove(from, epSquare, FLAG_EN_PASSANT));
+    }
+
+    for (int type = KNIGHT; type <= KING; ++type)
+    {
+        Bitboard bb = pieces(us, type);
+        while (bb)
+        {
+            int from = popLsb(bb);
+            Bitboard targets = Attacks::piece(type, us, from, occ) & (capturesOnly ? enemy : ~own);
+            while (targets)
+                list.push(makeFastMove(from, popLsb(targets)));
+        }
+    }
+    if (capturesOnly)
+        return;
+
+    // Рокировка: поля между королём и ладьёй и их конечными полями свободны, король не проходит через битые поля
+    int ksq = kingSquare(us);
+    for (int i = 2 * us; i < 2 * us + 2; ++i)
+    {
+        if (!(castling & (1 << i)))
+            continue;
+        int rookSq = castlingRook[i];
+        int homeY = rankOf(ksq);
+        int kingTo = squareOf(i % 2 == 0 ? 6 : 2, homeY);
+        int rookTo = squareOf(i % 2 == 0 ? 5 : 3, homeY);
+        Bitboard others = occ ^ squareBit(ksq) ^ squareBit(rookSq);
+        Bitboard path = Attacks::between(ksq, kingTo) | squareBit(kingTo) | Attacks::between(rookSq, rookTo) | squareBit(rookTo);
+        if (path & others)
+            continue;
+        if (isAttacked(ksq, them))
+            continue;
+
+        bool safe = true;
+        Bitboard kingPath = Attacks::between(ksq, kingTo) | squareBit(kingTo);
+        while (kingPath && safe)
+        {
+            int sq = popLsb(kingPath);
+            safe = !(attackersTo(sq, others) & enemy);
+        }
+        if (safe)
+            list.push(makeFastMove(ksq, kingTo, FLAG_CASTLING));
+    }
+}
+
+bool FastBoard::isLegal(FastMove m) const
+{
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    if (flag == FLAG_CASTLING)
+        return true;
+
+    Bitboard enemy = byColor[side ^ 1];
+    Bitboard occ = occupied() ^ squareBit(from);
+    if (pieceType(board[from]) == KING)
+        return !(attackersTo(to, occ) & enemy);
+
+    occ |= squareBit(to);
+    Bitboard captured = squareBit(to);
+    if (flag == FLAG_EN_PASSANT)
+    {
+        int capSq = to + (side == SIDE_WHITE ? -8 : 8);
+        occ ^= squareBit(capSq);
+        captured = squareBit(capSq);
+    }
+    return !(attackersTo(kingSquare(side), occ) & enemy & ~captured);
+}
+
+void FastBoard::generateMoves(MoveList& list) const
+{
+    MoveList pseudo;
+    generatePseudo(pseudo, false);
+    list.size = 0;
+    for (FastMove m : pseudo)
+    {
+        if (isLegal(m))
+            list.push(m);
+    }
+}
+
+void FastBoard::generateCaptures(MoveList& list) const
+{
+    MoveList pseudo;
+    generatePseudo(pseudo, true);
+    list.size = 0;
+    for (FastMove m : pseudo)
+    {
+        if (isLegal(m))
+            list.push(m);
+    }
+}
+
+bool FastBoard::givesCheck(FastMove m)
+{
+    UndoInfo undo;
+    makeMove(m, undo);
+    bool check = inCheck();
+    unmakeMove(m, undo);
+    return check;
+}
+
+bool FastBoard::hasNonPawnMaterial(int pieceSide) const
+{
+    return (byColor[pieceSide] & ~byType[PAWN] & ~byType[KING]) != 0;
+}
+
+void FastBoard::makeMove(FastMove m, UndoInfo& undo)
+{
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    int us = side;
+    int piece = board[from];
+
+    undo.captured = -1;
+    undo.castling = castling;
+    undo.epSquare = static_cast<int8_t>(epSquare);
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (castling & (1 << i))
+            key ^= Zobrist::keys()[Zobrist::CASTLE_OFFSET + i];
+    }
+    epSquare = -1;
+    ++halfmoveClock;
+
+    if (flag == FLAG_CASTLING)
+    {
+        int index = castlingIndex(m);
+        int rookSq = castlingRook[index];
+        int rookTo = squareOf(index % 2 == 0 ? 5 : 3, rankOf(from));
+        removePiece(from);
+        removePiece(rookSq);
+        putPiece(us, KING, to);
+        putPiece(us, ROOK, rookTo);
+    }
+    else
+    {
+        if (flag == FLAG_EN_PASSANT)
+        {
+            int capSq = to + (us == SIDE_WHITE ? -8 : 8);
+            undo.captured = board[capSq];
+            removePiece(capSq);
+        }
+        else if (board[to] >= 0)
+        {
+            undo.captured = board[to];
+            removePiece(to);
+            halfmoveClock = 0;
+        }
+
+        removePiece(from);
+        putPiece(us, isPromotion(m) ? promotionType(m) : pieceType(piece), to);
+
+        if (pieceType(piece) == PAWN)
+        {
+            halfmoveClock = 0;
+            if (flag == FLAG_DOUBLE_PUSH)
+                epSquare = (from + to) / 2;
+        }
+    }
+
+    castling &= castlingMask[from] & castlingMask[to];
+    for (int i = 0; i < 4; ++i)
+    {
+        if (castling & (1 << i))
+            key ^= Zobrist::keys()[Zobrist::CASTLE_OFFSET + i];
+    }
+
+    if (us == SIDE_BLACK)
+        ++fullmoveNumber;
+    setSideToMove(us ^ 1);
+}
+
+void FastBoard::unmakeMove(FastMove m, const UndoInfo& undo)
+{
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    side ^= 1;
+    int us = side;
+
+    if (flag == FLAG_CASTLING)
+    {
+        int index = castlingIndex(m);
+        int rookTo = squareOf(index % 2 == 0 ? 5 : 3, rankOf(from));
+        removePiece(to);
+        removePiece(rookTo);
+        putPiece(us, KING, from);
+        putPiece(us, ROOK, castlingRook[index]);
+    }
+    else
+    {
+        int type = isPromotion(m) ? PAWN : pieceType(board[to]);
+        removePiece(to);
+        putPiece(us, type, from);
+        if (undo.captured >= 0)
+        {
+            int capSq = flag == FLAG_EN_PASSANT ? to + (us == SIDE_WHITE ? -8 : 8) : to;
+            putPiece(pieceSide(undo.captured), pieceType(undo.captured), capSq);
+        }
+    }
+
+    if (us == SIDE_BLACK)
+        --fullmoveNumber;
+    castling = undo.castling;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+}
+
+void FastBoard::makeNullMove(UndoInfo& undo)
+{
+    undo.captured = -1;
+    undo.castling = castling;
+    undo.epSquare = static_cast<int8_t>(epSquare);
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+
+    epSquare = -1;
+    ++halfmoveClock;
+    setSideToMove(side ^ 1);
+}
+
+void FastBoard::unmakeNullMove(const UndoInfo& undo)
+{
+    side ^= 1;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+}
+
+std::string FastBoard::moveToUci(FastMove m) const
+{
+    int from = moveFrom(m), to = moveTo(m);
+    if (moveFlag(m) == FLAG_CASTLING && chess960)
+        to = castlingRook[castlingIndex(m)];
+
+    std::string res;
+    res += static_cast<char>('a' + fileOf(from));
+    res += static_cast<char>('1' + rankOf(from));
+    res += static_cast<char>('a' + fileOf(to));
+    res += static_cast<char>('1' + rankOf(to));
+    if (isPromotion(m))
+        res += PIECE_CHARS[promotionType(m)];
+    return res;
+}
+
+FastMove FastBoard::parseUci(const std::string& uci) const
+{
+    if (uci.size() < 4)
+        return NO_MOVE;
+
+    MoveList list;
+    generateMoves(list);
+    for (FastMove m : list)
+    {
+        std::string text = moveToUci(m);
+        if (text == uci)
+            return m;
+        if (moveFlag(m) == FLAG_CASTLING)
+        {
+            // вторая запись рокировки: король на поле ладьи или на g/c-вертикаль
+            std::string other = text.substr(0, 2);
+            int to = chess960 ? moveTo(m) : castlingRook[castlingIndex(m)];
+            other += static_cast<char>('a' + fileOf(to));
+            other += static_cast<char>('1' + rankOf(to));
+            if (other == uci)
+                return m;
+        }
+    }
+    return NO_MOVE;
+}
+
+std::string FastBoard::moveToSan(FastMove m) const
+{
+    static const char SAN_LETTERS[] = "PNBRQK";
+    int from = moveFrom(m), to = moveTo(m), type = pieceType(board[from]);
+
+    std::string san;
+    if (moveFlag(m) == FLAG_CASTLING)
+        san = fileOf(to) == 6 ? "O-O" : "O-O-O";
+    else
+    {
+        bool capture = isCapture(m);
+        if (type == PAWN)
+        {
+            if (capture)
+                san += static_cast<char>('a' + fileOf(from));
+        }
+        else
+        {
+            san += SAN_LETTERS[type];
+
+            // уточняем вертикаль или горизонталь, если на поле может пойти такая же фигура
+            MoveList list;
+            generateMoves(list);
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (FastMove other : list)
+            {
+                int otherFrom = moveFrom(other);
+                if (moveTo(other) != to || otherFrom == from || moveFlag(other) == FLAG_CASTLING || pieceType(board[otherFrom]) != type)
+                    continue;
+                ambiguous = true;
+                sameFile |= fileOf(otherFrom) == fileOf(from);
+                sameRank |= rankOf(otherFrom) == rankOf(from);
+            }
+            if (ambiguous && (!sameFile || sameRank))
+                san += static_cast<char>('a' + fileOf(from));
+            if (ambiguous && sameFile)
+                san += static_cast<char>('1' + rankOf(from));
+        }
+
+        if (capture)
+            san += 'x';
+        san += static_cast<char>('a' + fileOf(to));
+        san += static_cast<char>('1' + rankOf(to));
+        if (isPromotion(m))
+        {
+            san += '=';
+            san += SAN_LETTERS[promotionType(m)];
+        }
+    }
+
+    FastBoard next = *this;
+    UndoInfo undo;
+    next.makeMove(m, undo);
+    if (next.inCheck())
+    {
+        MoveList replies;
+        next.generateMoves(replies);
+        san += replies.size ? '+' : '#';
+    }
+    return san;
+}
+
+bool FastBoard::isInsufficientMaterial() const
+{
+    if (byType[PAWN] | byType[ROOK] | byType[QUEEN])
+        return false;
+    // один лёгкий конь или слон, либо только слоны на полях одного цвета
+    Bitboard minors = byType[KNIGHT] | byType[BISHOP];
+    if (popCount(minors) <= 1)
+        return true;
+    const Bitboard darkSquares = 0xAA55AA55AA55AA55ULL;
+    return !byType[KNIGHT] && ((byType[BISHOP] & darkSquares) == 0 || (byType[BISHOP] & ~darkSquares) == 0);
+}
\ No newline at end of file
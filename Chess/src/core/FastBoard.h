@@ -0,0 +1,139 @@
+#pragma once
+#include "Bitboard.h"
+#include <cstdint>
+#include <string>
+
+// Ход в 16 битах: откуда (6) | куда (6) | флаг (3). Рокировка кодируется ходом короля на g/c-вертикаль.
+using FastMove = uint16_t;
+
+enum MoveFlag : int
+{
+    FLAG_NORMAL,
+    FLAG_DOUBLE_PUSH,
+    FLAG_CASTLING,
+    FLAG_EN_PASSANT,
+    FLAG_PROMO_KNIGHT,
+    FLAG_PROMO_BISHOP,
+    FLAG_PROMO_ROOK,
+    FLAG_PROMO_QUEEN
+};
+
+constexpr FastMove NO_MOVE = 0;
+
+constexpr FastMove makeFastMove(int from, int to, int flag = FLAG_NORMAL)
+{
+    return static_cast<FastMove>(from | (to << 6) | (flag << 12));
+}
+constexpr int moveFrom(FastMove m) { return m & 63; }
+constexpr int moveTo(FastMove m) { return (m >> 6) & 63; }
+constexpr int moveFlag(FastMove m) { return m >> 12; }
+constexpr bool isPromotion(FastMove m) { return moveFlag(m) >= FLAG_PROMO_KNIGHT; }
+constexpr int promotionType(FastMove m) { return moveFlag(m) - FLAG_PROMO_KNIGHT + KNIGHT; }
+
+// Список ходов фиксированного размера: генерация не выделяет память
+struct MoveList
+{
+    FastMove moves[256];
+    int size = 0;
+
+    void push(FastMove m) { moves[size++] = m; }
+    const FastMove* begin() const { return moves; }
+    const FastMove* end() const { return moves + size; }
+};
+
+struct UndoInfo
+{
+    int captured;
+    uint8_t castling;
+    int8_t epSquare;
+    int halfmoveClock;
+    uint64_t key;
+};
+
+// Компактная позиция на битбордах для перебора, таблиц эндшпиля и проверки ходов на сервере.
+// Поддерживает рокировку Фишера (ладьи рокировки хранятся явно), ключ совпадает с Board::getKey().
+class FastBoard
+{
+public:
+    static const char* START_FEN;
+
+    FastBoard();
+
+    bool setFen(const std::string& fen);
+    std::string getFen() const;
+
+    void clear();
+    void putPiece(int side, int type, int sq);
+    void removePiece(int sq);
+    void setSideToMove(int side);
+
+    int sideToMove() const { return side; }
+    // -1 - пустое поле, иначе side * 6 + type
+    int pieceOn(int sq) const { return board[sq]; }
+    static int pieceSide(int piece) { return piece / 6; }
+    static int pieceType(int piece) { return piece % 6; }
+
+    Bitboard pieces(int side, int type) const { return byColor[side] & byType[type]; }
+    Bitboard piecesOf(int side) const { return byColor[side]; }
+    Bitboard piecesOfType(int type) const { return byType[type]; }
+    Bitboard occupied() const { return byColor[SIDE_WHITE] | byColor[SIDE_BLACK]; }
+    int kingSquare(int side) const { return lsb(pieces(side, KING)); }
+    int getEpSquare() const { return epSquare; }
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+    uint8_t getCastlingRights() const { return castling; }
+    // Исходное поле ладьи для хода-рокировки (ход стороны, которая сейчас ходит)
+    int castlingRookSquare(FastMove m) const { return castlingRook[castlingIndex(m)]; }
+
+    bool isChess960() const { return chess960; }
+    void setChess960(bool value) { chess960 = value; }
+
+    uint64_t getKey() const;
+
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    bool isAttacked(int sq, int bySide) const;
+    bool inCheck() const;
+
+    // Только легальные ходы
+    void generateMoves(MoveList& list) const;
+    // Легальные взятия и превращения - для форсированного перебора
+    void generateCaptures(MoveList& list) const;
+    bool isCapture(FastMove m) const;
+    bool givesCheck(FastMove m);
+    bool hasNonPawnMaterial(int side) const;
+
+    void makeMove(FastMove m, UndoInfo& undo);
+    void unmakeMove(FastMove m, const UndoInfo& undo);
+    void makeNullMove(UndoInfo& undo);
+    void unmakeNullMove(const UndoInfo& undo);
+
+    // В режиме Фишера рокировка записывается как ход короля на поле своей ладьи (UCI_Chess960)
+    std::string moveToUci(FastMove m) const;
+    // NO_MOVE, если ход не легален; принимает обе записи рокировки
+    FastMove parseUci(const std::string& uci) const;
+    // Краткая алгебраическая запись для PGN ("Nbd7", "exd6", "O-O", "e8=Q+")
+    std::string moveToSan(FastMove m) const;
+
+    bool isInsufficientMaterial() const;
+    int pieceCount() const { return popCount(occupied()); }
+
+private:
+    Bitboard byColor[2];
+    Bitboard byType[6];
+    int8_t board[64];
+    int side;
+    int epSquare;
+    uint8_t castling; // биты: 1 - белые в короткую, 2 - белые в длинную, 4 и 8 - то же для чёрных
+    int8_t castlingRook[4];
+    uint8_t castlingMask[64];
+    int halfmoveClock;
+    int fullmoveNumber;
+    uint64_t key;
+    bool chess960 = false;
+
+    void generatePseudo(MoveList& list, bool capturesOnly) const;
+    bool isLegal(FastMove m) const;
+    void addCastling(int sideIndex, int rookSq);
+    int castlingIndex(FastMove m) const;
+    bool epCapturable() const;
+};
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::openReadOnly(const std::string& path)
+{
+    return map(path, 0, false);
+}
+
+bool MappedFile::openReadWrite(const std::string& path, size_t size)
+{
+    return map(path, size, true);
+}
+
+bool MappedFile::isOpen() const
+{
+    return mapped != nullptr;
+}
+
+size_t MappedFile::size() const
+{
+    return mappedSize;
+}
+
+const uint8_t* MappedFile::data() const
+{
+    return mapped;
+}
+
+uint8_t* MappedFile::data()
+{
+    return writable ? mapped : nullptr;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::string& path, size_t size, bool write)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(),
+        write ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+        write ? OPEN_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    size_t mapSize = static_cast<size_t>(fileSize.QuadPart);
+    if (write && mapSize < size)
+        mapSize = size;
+    if (mapSize == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // для записи CreateFileMapping сам расширяет файл до нужного размера
+    unsigned long long mapSize64 = mapSize;
+    HANDLE mapping = CreateFileMappingA(file, NULL, write ? PAGE_READWRITE : PAGE_READONLY,
+        static_cast<DWORD>(mapSize64 >> 32), static_cast<DWORD>(mapSize64 & 0xFFFFFFFF), NULL);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, mapSize);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    mapped = static_cast<uint8_t*>(view);
+    mappedSize = mapSize;
+    writable = write;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapped)
+        UnmapViewOfFile(mapped);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    mapped = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    mappedSize = 0;
+    writable = false;
+}
+
+#else
+
+bool MappedFile::map(const std::string& path, size_t size, bool write)
+{
+    close();
+
+    int file = ::open(path.c_str(), write ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (file < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(file, &st) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    size_t mapSize = static_cast<size_t>(st.st_size);
+    if (write && mapSize < size)
+    {
+        if (ftruncate(file, static_cast<off_t>(size)) != 0)
+        {
+            ::close(file);
+            return false;
+        }
+        mapSize = size;
+    }
+    if (mapSize == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, mapSize, write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    mapped = static_cast<uint8_t*>(view);
+    mappedSize = mapSize;
+    writable = write;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapped)
+        munmap(mapped, mappedSize);
+    if (fd >= 0)
+        ::close(fd);
+    mapped = nullptr;
+    fd = -1;
+    mappedSize = 0;
+    writable = false;
+}
+
+#endif
\ No newline at end of file
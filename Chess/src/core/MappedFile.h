@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Файл, отображённый в память. Данные читаются напрямую со страниц ОС, без копирования и разбора.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool openReadOnly(const std::string& path);
+    // Создаёт файл нужного размера, если его нет; существующий файл короче size дополняется нулями
+    bool openReadWrite(const std::string& path, size_t size);
+    void close();
+
+    bool isOpen() const;
+    size_t size() const;
+    const uint8_t* data() const;
+    uint8_t* data();
+
+private:
+    uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    bool writable = false;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool map(const std::string& path, size_t size, bool write);
+};
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "MateSolver.h"
+#include <algorithm>
+
+static const int16_t ANY_DEPTH = 1000;
+
+static uint32_t saturatedAdd(uint32_t a, uint32_t b, uint32_t limit)
+{
+    return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(a) + b, limit));
+}
+
+MateSolver::MateSolver(size_t hashMb)
+{
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= std::max<size_t>(hashMb, 1) * 1024 * 1024)
+        count *= 2;
+    table.resize(count);
+    mask = count - 1;
+}
+
+void MateSolver::clear()
+{
+    std::fill(table.begin(), table.end(), Entry {});
+}
+
+// Доказательство с запасом глубины годится и для большего запаса, опровержение - и для меньшего
+void MateSolver::lookup(uint64_t key, int depth, uint32_t& pn, uint32_t& dn, int& distance) const
+{
+    const Entry& entry = table[key & mask];
+    pn = 1;
+    dn = 1;
+    distance = 0;
+    if (entry.key != key || (entry.pn | entry.dn) == 0)
+        return;
+
+    if (entry.pn == 0 && entry.distance <= depth)
+    {
+        pn = 0;
+        dn = INF;
+        distance = entry.distance;
+    }
+    else if (entry.dn == 0 && entry.depth >= depth)
+    {
+        pn = INF;
+        dn = 0;
+    }
+    else if (entry.depth == depth && entry.pn != 0 && entry.dn != 0)
+    {
+        pn = entry.pn;
+        dn = entry.dn;
+    }
+}
+
+void MateSolver::store(uint64_t key, int depth, uint32_t pn, uint32_t dn, int distance)
+{
+    Entry& entry = table[key & mask];
+    // доказательства ценнее всего остального - их не затираем ради той же позиции
+    if (entry.key == key && entry.pn == 0 && pn != 0)
+        return;
+    entry = { key, pn, dn, static_cast<int16_t>(depth), static_cast<int16_t>(distance) };
+}
+
+// Раскрытие хода m; attacker - ходит ли атакующий в текущем узле, depth - запас полуходов в нём
+void MateSolver::expandChild(Child& child, bool attacker, int depth)
+{
+    UndoInfo undo;
+    pos.makeMove(child.move, undo);
+    child.key = pos.getKey();
+    child.pn = 1;
+    child.dn = 1;
+    child.fixed = false;
+
+    if (std::find(path.begin(), path.end(), child.key) != path.end())
+    {
+        // повторение - ничья, мата этим путём нет
+        child.pn = INF;
+        child.dn = 0;
+        child.fixed = true;
+    }
+    else
+    {
+        // у защиты число доказательства - число её ответов: меньше ответов - ближе мат
+        MoveList replies;
+        pos.generateMoves(replies);
+        if (replies.size == 0)
+        {
+            bool mated = attacker && pos.inCheck();
+            child.pn = mated ? 0 : INF;
+            child.dn = mated ? INF : 0;
+            child.fixed = true;
+        }
+        else if (depth - 1 == 0)
+        {
+            child.pn = INF;
+            child.dn = 0;
+            child.fixed = true;
+        }
+        else if (attacker)
+            child.pn = static_cast<uint32_t>(replies.size);
+    }
+    pos.unmakeMove(child.move, undo);
+}
+
+void MateSolver::childNumbers(const Child& child, int depth, uint32_t& pn, uint32_t& dn, int& distance) const
+{
+    pn = child.pn;
+    dn = child.dn;
+    distance = 0;
+    if (!child.fixed && table[child.key & mask].key == child.key)
+        lookup(child.key, depth - 1, pn, dn, distance);
+}
+
+void MateSolver::search(bool attacker, int depth, uint32_t thresholdPn, uint32_t thresholdDn)
+{
+    ++nodes;
+    uint64_t key = pos.getKey();
+    MoveList list;
+    pos.generateMoves(list);
+    if (list.size == 0)
+    {
+        if (!attacker && pos.inCheck())
+            store(key, ANY_DEPTH, 0, INF, 0);
+        else
+            store(key, ANY_DEPTH, INF, 0, 0);
+        return;
+    }
+    if (depth == 0)
+    {
+        store(key, depth, INF, 0, 0);
+        return;
+    }
+
+    path.push_back(key);
+    Child children[256];
+    for (int i = 0; i < list.size; ++i)
+    {
+        children[i].move = list.moves[i];
+        expandChild(children[i], attacker, depth);
+    }
+
+    uint32_t pn = 0, dn = 0;
+    int distance = 0;
+    while (true)
+    {
+        // атакующему хватает одного доказанного хода (минимум pn), защите - одного опровержения (минимум dn)
+        uint32_t best = INF + 1, second = INF + 1;
+        int bestIndex = 0;
+        uint32_t bestPn = 0, bestDn = 0;
+        pn = attacker ? INF : 0;
+        dn = attacker ? 0 : INF;
+        distance = attacker ? ANY_DEPTH : 0;
+        for (int i = 0; i < list.size; ++i)
+        {
+            uint32_t childPn, childDn;
+            int childDistance;
+            childNumbers(children[i], depth, childPn, childDn, childDistance);
+
+            uint32_t value = attacker ? childPn : childDn;
+            if (value < best)
+            {
+                second = best;
+                best = value;
+                bestIndex = i;
+                bestPn = childPn;
+                bestDn = childDn;
+            }
+            else if (value < second)
+                second = value;
+
+            if (attacker)
+            {
+                pn = std::min(pn, childPn);
+                dn = saturatedAdd(dn, childDn, INF);
+                if (childPn == 0)
+                    distance = std::min(distance, childDistance + 1);
+            }
+            else
+            {
+                pn = saturatedAdd(pn, childPn, INF);
+                dn = std::min(dn, childDn);
+                distance = std::max(distance, childDistance + 1);
+            }
+        }
+
+        if (pn >= thresholdPn || dn >= thresholdDn || nodes >= maxNodes)
+            break;
+
+        uint32_t childThresholdPn, childThresholdDn;
+        if (attacker)
+        {
+            childThresholdPn = std::min(thresholdPn, saturatedAdd(second, 1, INF));
+            childThresholdDn = saturatedAdd(thresholdDn - dn, bestDn, INF);
+        }
+        else
+        {
+            childThresholdPn = saturatedAdd(thresholdPn - pn, bestPn, INF);
+            childThresholdDn = std::min(thresholdDn, saturatedAdd(second, 1, INF));
+        }
+
+        FastMove m = children[bestIndex].move;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        search(!attacker, depth - 1, childThresholdPn, childThresholdDn);
+        pos.unmakeMove(m, undo);
+    }
+    path.pop_back();
+
+    store(key, pn == 0 ? distance : depth, pn, dn, pn == 0 ? distance : 0);
+}
+
+// Главный вариант по таблице: быстрейший мат у атакующего, самая долгая защита у соперника
+std::vector<FastMove> MateSolver::extractLine(int depth)
+{
+    std::vector<FastMove> line;
+    std::vector<UndoInfo> undos;
+    bool attacker = true;
+    for (; depth > 0; --depth, attacker = !attacker)
+    {
+        MoveList list;
+        pos.generateMoves(list);
+        FastMove bestMove = NO_MOVE;
+        int bestDistance = 0;
+        for (FastMove m : list)
+        {
+            Child child { m, 0, 0, 0, false };
+            uint32_t pn, dn;
+            int distance;
+            expandChild(child, attacker, depth);
+            childNumbers(child, depth, pn, dn, distance);
+            if (pn != 0)
+                continue;
+            if (bestMove == NO_MOVE || (attacker ? distance < bestDistance : distance > bestDistance))
+            {
+                bestMove = m;
+                bestDistance = distance;
+            }
+        }
+        if (bestMove == NO_MOVE)
+            break;
+
+        line.push_back(bestMove);
+        undos.emplace_back();
+        pos.makeMove(bestMove, undos.back());
+    }
+
+    for (size_t i = line.size(); i-- > 0;)
+        pos.unmakeMove(line[i], undos[i]);
+    return line;
+}
+
+std::optional<MateResult> MateSolver::solve(const FastBoard& root, int maxPlies, uint64_t nodeLimit)
+{
+    clear();
+    pos = root;
+    nodes = 0;
+    maxNodes = nodeLimit;
+
+    for (int limit = 1; limit <= maxPlies; limit += 2)
+    {
+        path.clear();
+        search(true, limit, INF, INF);
+
+        uint32_t pn, dn;
+        int distance;
+        lookup(pos.getKey(), limit, pn, dn, distance);
+        if (pn == 0)
+        {
+            MateResult result;
+            result.plies = distance;
+            result.line = extractLine(distance);
+            result.nodes = nodes;
+            return result;
+        }
+        if (nodes >= maxNodes)
+            break;
+    }
+    return std::nullopt;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "FastBoard.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+struct MateResult
+{
+    int plies = 0;               // полуходов до мата, всегда нечётное
+    std::vector<FastMove> line;  // ходы атакующего и самая долгая защита
+    uint64_t nodes = 0;
+};
+
+// Поиск форсированного мата числами доказательства (df-pn): в узлах атакующего достаточно одного
+// доказанного хода, в узлах защиты нужны все. Перебор идёт в глубину по порогам, все узлы хранятся
+// в собственной хеш-таблице. Ограничение по полуходам увеличивается по шагам, поэтому найденный мат -
+// кратчайший.
+class MateSolver
+{
+public:
+    static constexpr uint64_t DEFAULT_NODES = 2000000;
+
+    explicit MateSolver(size_t hashMb = 16);
+
+    // Мат за сторону, которая ходит, не дальше maxPlies полуходов; nullopt - мата нет или не хватило узлов
+    std::optional<MateResult> solve(const FastBoard& pos, int maxPlies, uint64_t maxNodes = DEFAULT_NODES);
+
+private:
+    static constexpr uint32_t INF = 1u << 30;
+
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t pn;
+        uint32_t dn;
+        int16_t depth;   // сколько полуходов было в запасе при записи
+        int16_t distance; // для доказанных: полуходов до мата
+    };
+
+    // ход узла: ключ и начальные числа считаются один раз при раскрытии узла
+    struct Child
+    {
+        FastMove move;
+        uint64_t key;
+        uint32_t pn;
+        uint32_t dn;
+        bool fixed;      // повторение или конец партии - числа не зависят от таблицы
+    };
+
+    std::vector<Entry> table;
+    uint64_t mask = 0;
+    FastBoard pos;
+    std::vector<uint64_t> path;
+    uint64_t nodes = 0;
+    uint64_t maxNodes = 0;
+
+    void clear();
+    void lookup(uint64_t key, int depth, uint32_t& pn, uint32_t& dn, int& distance) const;
+    void store(uint64_t key, int depth, uint32_t pn, uint32_t dn, int distance);
+    void expandChild(Child& child, bool attacker, int depth);
+    void childNumbers(const Child& child, int depth, uint32_t& pn, uint32_t& dn, int& distance) const;
+    void search(bool attacker, int depth, uint32_t thresholdPn, uint32_t thresholdDn);
+    std::vector<FastMove> extractLine(int depth);
+};
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Векторные ядра собираются всегда, а выбираются по процессору при первом обращении:
+// бинарник без -march работает везде и всё равно считает на AVX2, где он есть
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNUE_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define NNUE_TARGET_AVX2 __attribute__((target("avx2")))
+#define NNUE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#include <intrin.h>
+// MSVC разрешает любые встроенные функции без /arch
+#define NNUE_TARGET_AVX2
+#define NNUE_TARGET_SSE41
+#endif
+#endif
+
+static size_t alignedSize(size_t bytes)
+{
+    return (bytes + 63) / 64 * 64;
+}
+
+NnueDelta NnueDelta::forMove(const FastBoard& pos, FastMove m)
+{
+    NnueDelta delta;
+    auto add = [&](int piece, int from, int to) {
+        delta.piece[delta.count] = piece;
+        delta.from[delta.count] = from;
+        delta.to[delta.count] = to;
+        ++delta.count;
+    };
+
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    int us = pos.sideToMove();
+    int piece = pos.pieceOn(from);
+
+    if (flag == FLAG_CASTLING)
+    {
+        int rookSq = pos.castlingRookSquare(m);
+        add(piece, from, to);
+        add(us * 6 + ROOK, rookSq, squareOf(fileOf(to) == 6 ? 5 : 3, rankOf(from)));
+        return delta;
+    }
+
+    if (flag == FLAG_EN_PASSANT)
+    {
+        int capSq = to + (us == SIDE_WHITE ? -8 : 8);
+        add(pos.pieceOn(capSq), capSq, -1);
+    }
+    else if (pos.pieceOn(to) >= 0)
+        add(pos.pieceOn(to), to, -1);
+
+    if (isPromotion(m))
+    {
+        add(piece, from, -1);
+        add(us * 6 + promotionType(m), -1, to);
+    }
+    else
+        add(piece, from, to);
+    return delta;
+}
+
+bool NnueDelta::movesKing(int side) const
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (piece[i] == side * 6 + KING)
+            return true;
+    }
+    return false;
+}
+
+int NnueNetwork::featureIndex(int side, int kingSq, int piece, int sq)
+{
+    // всё с точки зрения side: для чёрных доска отражается по горизонтали, свои фигуры - первые пять
+    int flip = side == SIDE_WHITE ? 0 : 56;
+    int pieceIndex = (FastBoard::pieceSide(piece) == side ? 0 : 5) + FastBoard::pieceType(piece);
+    return ((kingSq ^ flip) * 10 + pieceIndex) * 64 + (sq ^ flip);
+}
+
+size_t NnueNetwork::fileSize()
+{
+    return sizeof(Header)
+        + alignedSize(HALF_DIMS * sizeof(int16_t)) + alignedSize(static_cast<size_t>(FEATURES) * HALF_DIMS * sizeof(int16_t))
+        + alignedSize(L1 * sizeof(int32_t)) + alignedSize(L1 * 2 * HALF_DIMS)
+        + alignedSize(L2 * sizeof(int32_t)) + alignedSize(L2 * L1)
+        + alignedSize(sizeof(int32_t)) + alignedSize(L2);
+}
+
+bool NnueNetwork::load(const std::string& networkPath)
+{
+    file.close();
+    path = networkPath;
+
+    Header header;
+    bool ok = file.openReadOnly(path) && file.size() == fileSize();
+    if (ok)
+    {
+        std::memcpy(&header, static_cast<const MappedFile&>(file).data(), sizeof(Header));
+        ok = header.magic == MAGIC && header.features == FEATURES && header.halfDims == HALF_DIMS
+            && header.l1 == L1 && header.l2 == L2;
+    }
+    if (!ok)
+    {
+        std::cerr << "Cannot load network file: " << path << std::endl;
+        file.close();
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const MappedFile&>(file).data() + sizeof(Header);
+    auto take = [&data](size_t bytes) {
+        const uint8_t* section = data;
+        data += alignedSize(bytes);
+        return section;
+    };
+    ftBiases = reinterpret_cast<const int16_t*>(take(HALF_DIMS * sizeof(int16_t)));
+    ftWeights = reinterpret_cast<const int16_t*>(take(static_cast<size_t>(FEATURES) * HALF_DIMS * sizeof(int16_t)));
+    l1Biases = reinterpret_cast<const int32_t*>(take(L1 * sizeof(int32_t)));
+    l1Weights = reinterpret_cast<const int8_t*>(take(L1 * 2 * HALF_DIMS));
+    l2Biases = reinterpret_cast<const int32_t*>(take(L2 * sizeof(int32_t)));
+    l2Weights = reinterpret_cast<const int8_t*>(take(L2 * L1));
+    outBias = reinterpret_cast<const int32_t*>(take(sizeof(int32_t)));
+    outWeights = reinterpret_cast<const int8_t*>(take(L2));
+    return true;
+}
+
+// out = in - столбцы removed + столбцы added; out и in выровнены по 64 байтам
+static void updateColumnsScalar(int16_t* out, const int16_t* in, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount)
+{
+    const int dims = NnueNetwork::HALF_DIMS;
+    std::memmove(out, in, dims * sizeof(int16_t));
+    for (int r = 0; r < removedCount; ++r)
+    {
+        const int16_t* column = weights + removed[r] * dims;
+        for (int i = 0; i < dims; ++i)
+            out[i] -= column[i];
+    }
+    for (int a = 0; a < addedCount; ++a)
+    {
+        const int16_t* column = weights + added[a] * dims;
+        for (int i = 0; i < dims; ++i)
+            out[i] += column[i];
+    }
+}
+
+// Ограничение 0..127 и сжатие int16 -> uint8 (size кратен 32)
+static void clippedReluScalar(const int16_t* in, uint8_t* out, int size)
+{
+    for (int i = 0; i < size; ++i)
+        out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+}
+
+// Скалярное произведение uint8 входов на int8 веса (size кратен 32)
+static int32_t dotScalar(const uint8_t* input, const int8_t* weights, int size)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < size; ++i)
+        sum += input[i] * weights[i];
+    return sum;
+}
+
+// Скрытый слой: int8 веса, выход сдвигается на WEIGHT_SHIFT и ограничивается 0..127.
+// Своя копия на каждое ядро, чтобы dot встраивался в цикл
+static void hiddenLayerScalar(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, uint8_t* out, int outputs)
+{
+    for (int i = 0; i < outputs; ++i)
+    {
+        int32_t value = biases[i] + dotScalar(input, weights + i * inputs, inputs);
+        out[i] = static_cast<uint8_t>(std::clamp(value >> NnueNetwork::WEIGHT_SHIFT, 0, 127));
+    }
+}
+
+#ifdef NNUE_X86
+NNUE_TARGET_AVX2 static void updateColumnsAvx2(int16_t* out, const int16_t* in, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount)
+{
+    const int dims = NnueNetwork::HALF_DIMS;
+    for (int i = 0; i < dims; i += 16)
+    {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        for (int r = 0; r < removedCount; ++r)
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + removed[r] * dims + i)));
+        for (int a = 0; a < addedCount; ++a)
+            v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + added[a] * dims + i)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+}
+
+NNUE_TARGET_AVX2 static void clippedReluAvx2(const int16_t* in, uint8_t* out, int size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+        // packs переставляет 128-битные половины, permute возвращает порядок
+        __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+}
+
+NNUE_TARGET_AVX2 static int32_t dotAvx2(const uint8_t* input, const int8_t* weights, int size)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32)
+    {
+        __m256i product = _mm256_maddubs_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(input + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+
+NNUE_TARGET_AVX2 static void hiddenLayerAvx2(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, uint8_t* out, int outputs)
+{
+    for (int i = 0; i < outputs; ++i)
+    {
+        int32_t value = biases[i] + dotAvx2(input, weights + i * inputs, inputs);
+        out[i] = static_cast<uint8_t>(std::clamp(value >> NnueNetwork::WEIGHT_SHIFT, 0, 127));
+    }
+}
+
+NNUE_TARGET_SSE41 static void updateColumnsSse41(int16_t* out, const int16_t* in, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount)
+{
+    const int dims = NnueNetwork::HALF_DIMS;
+    for (int i = 0; i < dims; i += 8)
+    {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i));
+        for (int r = 0; r < removedCount; ++r)
+            v = _mm_sub_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + removed[r] * dims + i)));
+        for (int a = 0; a < addedCount; ++a)
+            v = _mm_add_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + added[a] * dims + i)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+}
+
+NNUE_TARGET_SSE41 static void clippedReluSse41(const int16_t* in, uint8_t* out, int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16)
+    {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+    }
+}
+
+NNUE_TARGET_SSE41 static int32_t dotSse41(const uint8_t* input, const int8_t* weights, int size)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16)
+    {
+        __m128i product = _mm_maddubs_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(input + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(product, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+NNUE_TARGET_SSE41 static void hiddenLayerSse41(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, uint8_t* out, int outputs)
+{
+    for (int i = 0; i < outputs; ++i)
+    {
+        int32_t value = biases[i] + dotSse41(input, weights + i * inputs, inputs);
+        out[i] = static_cast<uint8_t>(std::clamp(value >> NnueNetwork::WEIGHT_SHIFT, 0, 127));
+    }
+}
+#endif
+
+struct NnueKernels
+{
+    const char* name;
+    void (*updateColumns)(int16_t*, const int16_t*, const int16_t*, const int*, int, const int*, int);
+    void (*clippedRelu)(const int16_t*, uint8_t*, int);
+    void (*hiddenLayer)(const uint8_t*, int, const int8_t*, const int32_t*, uint8_t*, int);
+    int32_t (*dot)(const uint8_t*, const int8_t*, int);
+};
+
+#ifdef NNUE_X86
+static bool cpuHasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // AVX включён в ОС: процессор умеет и ОС сохраняет регистры ymm
+    bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osAvx && (info[1] & (1 << 5));
+#endif
+}
+
+static bool cpuHasSse41()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#endif
+}
+#endif
+
+static const NnueKernels& kernels()
+{
+    static const NnueKernels selected = []() {
+#ifdef NNUE_X86
+        if (cpuHasAvx2())
+            return NnueKernels{ "AVX2", updateColumnsAvx2, clippedReluAvx2, hiddenLayerAvx2, dotAvx2 };
+        if (cpuHasSse41())
+            return NnueKernels{ "SSE4.1", updateColumnsSse41, clippedReluSse41, hiddenLayerSse41, dotSse41 };
+#endif
+        return NnueKernels{ "scalar", updateColumnsScalar, clippedReluScalar, hiddenLayerScalar, dotScalar };
+    }();
+    return selected;
+}
+
+const char* NnueNetwork::simdName()
+{
+    return kernels().name;
+}
+
+void NnueNetwork::refresh(const FastBoard& pos, int side, NnueAccumulator& acc) const
+{
+    int features[32];
+    int count = 0;
+    int kingSq = pos.kingSquare(side);
+    Bitboard pieces = pos.occupied() & ~pos.piecesOfType(KING);
+    while (pieces && count < 32)
+    {
+        int sq = popLsb(pieces);
+        features[count++] = featureIndex(side, kingSq, pos.pieceOn(sq), sq);
+    }
+
+    // разделы файла выровнены по 64 байтам, смещения можно читать как выровненный вход
+    kernels().updateColumns(acc.values[side], ftBiases, ftWeights, features, count, nullptr, 0);
+    acc.computed[side] = true;
+}
+
+void NnueNetwork::update(const NnueAccumulator& prev, NnueAccumulator& next, const NnueDelta& delta, const FastBoard& pos, int side) const
+{
+    int added[3], removed[3];
+    int addedCount = 0, removedCount = 0;
+    int kingSq = pos.kingSquare(side);
+    for (int i = 0; i < delta.count; ++i)
+    {
+        if (FastBoard::pieceType(delta.piece[i]) == KING)
+            continue;
+        if (delta.from[i] >= 0)
+            removed[removedCount++] = featureIndex(side, kingSq, delta.piece[i], delta.from[i]);
+        if (delta.to[i] >= 0)
+            added[addedCount++] = featureIndex(side, kingSq, delta.piece[i], delta.to[i]);
+    }
+    kernels().updateColumns(next.values[side], prev.values[side], ftWeights, added, addedCount, removed, removedCount);
+    next.computed[side] = true;
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator& acc, int sideToMove) const
+{
+    // своя половина первой: сеть видит позицию глазами стороны, которая ходит
+    alignas(64) uint8_t input[2 * HALF_DIMS];
+    alignas(64) uint8_t hidden1[L1];
+    alignas(64) uint8_t hidden2[L2];
+    const NnueKernels& k = kernels();
+    k.clippedRelu(acc.values[sideToMove], input, HALF_DIMS);
+    k.clippedRelu(acc.values[sideToMove ^ 1], input + HALF_DIMS, HALF_DIMS);
+
+    k.hiddenLayer(input, 2 * HALF_DIMS, l1Weights, l1Biases, hidden1, L1);
+    k.hiddenLayer(hidden1, L1, l2Weights, l2Biases, hidden2, L2);
+    return (*outBias + k.dot(hidden2, outWeights, L2)) / OUTPUT_SCALE;
+}
\ No newline at end of file
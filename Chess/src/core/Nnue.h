@@ -0,0 +1,86 @@
+#pragma once
+#include "FastBoard.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+// Ширина первого слоя на одну сторону
+constexpr int NNUE_HALF_DIMS = 256;
+
+// Суммы первого слоя для обеих сторон. Пересчитываются только изменившиеся столбцы;
+// computed[side] = false - ещё не пересчитаны после хода
+struct alignas(64) NnueAccumulator
+{
+    int16_t values[2][NNUE_HALF_DIMS];
+    bool computed[2];
+};
+
+// Фигуры, переставленные одним ходом: фигура (side * 6 + type) уходит с from и появляется на to,
+// -1 - поля нет (взятие или превращение). Ход короля стороны требует полного пересчёта её половины.
+struct NnueDelta
+{
+    int count = 0;
+    int piece[3];
+    int from[3];
+    int to[3];
+
+    // Вызывается до makeMove: нужны фигуры на исходных полях
+    static NnueDelta forMove(const FastBoard& pos, FastMove m);
+    bool movesKing(int side) const;
+};
+
+// Нейросетевая оценка в духе NNUE. Входы HalfKP: (поле своего короля, фигура кроме королей, её поле)
+// с точки зрения каждой стороны, 40960 признаков -> 256 на сторону -> 32 -> 32 -> 1.
+// Файл сети (всё little-endian, разделы подряд, каждый кратен 64 байтам):
+//   Header (64 байта), int16 смещения[256], int16 веса[40960][256],
+//   int32 смещения[32], int8 веса[32][512], int32 смещения[32], int8 веса[32][32],
+//   int32 смещение (дополнено до 64 байт), int8 веса[32] (дополнено до 64 байт).
+// Веса не копируются: файл отображается в память и читается прямо со страниц ОС.
+class NnueNetwork
+{
+public:
+    static constexpr uint32_t MAGIC = 0x314E4E43; // "CNN1"
+    static constexpr int FEATURES = 64 * 10 * 64;
+    static constexpr int HALF_DIMS = NNUE_HALF_DIMS;
+    static constexpr int L1 = 32;
+    static constexpr int L2 = 32;
+    static constexpr int WEIGHT_SHIFT = 6;   // масштаб int8-весов скрытых слоёв
+    static constexpr int OUTPUT_SCALE = 16;  // выход сети / OUTPUT_SCALE = сантипешки
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t features;
+        uint32_t halfDims;
+        uint32_t l1;
+        uint32_t l2;
+        uint32_t reserved[11];
+    };
+
+    bool load(const std::string& path);
+    bool isLoaded() const { return file.isOpen(); }
+    const std::string& getPath() const { return path; }
+
+    void refresh(const FastBoard& pos, int side, NnueAccumulator& acc) const;
+    // next = prev + изменения хода; pos - позиция после хода
+    void update(const NnueAccumulator& prev, NnueAccumulator& next, const NnueDelta& delta, const FastBoard& pos, int side) const;
+    // В сантипешках с точки зрения стороны, которая ходит; обе половины должны быть пересчитаны
+    int evaluate(const NnueAccumulator& acc, int sideToMove) const;
+
+    static int featureIndex(int side, int kingSq, int piece, int sq);
+    static size_t fileSize();
+    // Ядро, выбранное по процессору при первом обращении: "AVX2", "SSE4.1" или "scalar"
+    static const char* simdName();
+
+private:
+    MappedFile file;
+    std::string path;
+    const int16_t* ftBiases = nullptr;
+    const int16_t* ftWeights = nullptr;
+    const int32_t* l1Biases = nullptr;
+    const int8_t* l1Weights = nullptr;
+    const int32_t* l2Biases = nullptr;
+    const int8_t* l2Weights = nullptr;
+    const int32_t* outBias = nullptr;
+    const int8_t* outWeights = nullptr;
+};
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "Pgn.h"
+#include <cctype>
+#include <sstream>
+
+PgnReader::PgnReader(std::istream& in)
+    : in(in)
+{
+}
+
+bool PgnReader::readLine(std::string& line)
+{
+    if (hasPending)
+    {
+        line = pendingLine;
+        hasPending = false;
+        return true;
+    }
+    if (!std::getline(in, line))
+        return false;
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+bool PgnReader::nextRaw(std::string& text)
+{
+    text.clear();
+    bool inMoves = false;
+    std::string line;
+
+    while (readLine(line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            continue;
+
+        bool isTag = line[start] == '[';
+        if (isTag && inMoves)
+        {
+            // началась следующая партия
+            pendingLine = line;
+            hasPending = true;
+            break;
+        }
+        if (!isTag)
+            inMoves = true;
+
+        text += line;
+        text += '\n';
+    }
+    return !text.empty();
+}
+
+bool PgnReader::next(PgnGame& game)
+{
+    std::string text;
+    while (nextRaw(text))
+    {
+        if (parse(text, game))
+            return true;
+    }
+    return false;
+}
+
+static bool isResultToken(const std::string& token)
+{
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+bool PgnReader::parse(const std::string& text, PgnGame& game)
+{
+    game.tags.clear();
+    game.moves.clear();
+    game.result = "*";
+
+    std::istringstream lines(text);
+    std::string line;
+    std::string movetext;
+
+    while (std::getline(lines, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line[start] == '[')
+        {
+            size_t nameEnd = line.find(' ', start);
+            size_t valueStart = line.find('"', start);
+            size_t valueEnd = line.rfind('"');
+            if (nameEnd != std::string::npos && valueStart != std::string::npos && valueEnd > valueStart)
+                game.tags[line.substr(start + 1, nameEnd - start - 1)] = line.substr(valueStart + 1, valueEnd - valueStart - 1);
+        }
+        else
+        {
+            movetext += line;
+            movetext += '\n';
+        }
+    }
+
+    // убираем комментарии и варианты
+    std::string clean;
+    int variationDepth = 0;
+    for (size_t i = 0; i < movetext.size(); ++i)
+    {
+        char c = movetext[i];
+        if (c == '{')
+        {
+            size_t end = movetext.find('}', i);
+            i = (end == std::string::npos) ? movetext.size() : end;
+            clean += ' ';
+        }
+        else if (c == ';')
+        {
+            size_t end = movetext.find('\n', i);
+            i = (end == std::string::npos) ? movetext.size() : end;
+            clean += ' ';
+        }
+        else if (c == '(')
+            ++variationDepth;
+        else if (c == ')')
+        {
+            if (variationDepth > 0)
+                --variationDepth;
+            clean += ' ';
+        }
+        else if (variationDepth == 0)
+            clean += c;
+    }
+
+    std::istringstream tokens(clean);
+    std::string token;
+    while (tokens >> token)
+    {
+        if (isResultToken(token))
+        {
+            game.result = token;
+            break;
+        }
+        if (token[0] == '$')
+            continue;
+
+        // номер хода может быть приклеен к ходу: "12.e4", "12...Nf6"
+        size_t pos = 0;
+        while (pos < token.size() && std::isdigit(static_cast<unsigned char>(token[pos])))
+            ++pos;
+        if (pos < token.size() && token[pos] == '.')
+        {
+            while (pos < token.size() && token[pos] == '.')
+                ++pos;
+            token = token.substr(pos);
+        }
+
+        if (!token.empty())
+            game.moves.push_back(token);
+    }
+
+    auto tag = game.tags.find("Result");
+    if (game.result == "*" && tag != game.tags.end() && isResultToken(tag->second))
+        game.result = tag->second;
+
+    return !game.moves.empty() || !game.tags.empty();
+}
+
+static std::string pieceFromLetter(char c)
+{
+    switch (c)
+    {
+    case 'N':
+        return "knight";
+    case 'B':
+        return "bishop";
+    case 'R':
+        return "rook";
+    case 'Q':
+        return "queen";
+    case 'K':
+        return "king";
+    default:
+        return "";
+    }
+}
+
+std::optional<Move> Pgn::sanToMove(const Board& board, const std::string& sanText)
+{
+    std::string san = sanText;
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+        san.pop_back();
+    if (san.empty())
+        return std::nullopt;
+
+    const auto& grid = board.getGrid();
+    Color color = board.getCurrentPlayer();
+    int homeY = (color == Color::White) ? 0 : 7;
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+    {
+        int toX = (san.size() == 3) ? 6 : 2;
+        for (int x = 0; x < 8; ++x)
+        {
+            const auto& piece = grid[homeY][x];
+            if (!piece || piece->getType() != "king" || piece->getColor() != color)
+                continue;
+            for (const auto& m : board.getSelectableMoves(Position(x, homeY)))
+            {
+                if (m.isCastling() && m.getTo().getX() == toX)
+                    return m;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string promotion;
+    size_t eq = san.find('=');
+    if (eq != std::string::npos && eq + 1 < san.size())
+    {
+        promotion = pieceFromLetter(san[eq + 1]);
+        san = san.substr(0, eq);
+    }
+    else if (san.size() > 2 && !pieceFromLetter(san.back()).empty() && std::isdigit(static_cast<unsigned char>(san[san.size() - 2])))
+    {
+        // форма без '=': "e8Q"
+        promotion = pieceFromLetter(san.back());
+        san.pop_back();
+    }
+
+    std::string type = "pawn";
+    size_t pos = 0;
+    if (!pieceFromLetter(san[0]).empty())
+    {
+        type = pieceFromLetter(san[0]);
+        pos = 1;
+    }
+
+    if (san.size() < pos + 2)
+        return std::nullopt;
+
+    Position to(san[san.size() - 2] - 'a', san[san.size() - 1] - '1');
+    if (!to.isValid())
+        return std::nullopt;
+
+    int fromFile = -1, fromRank = -1;
+    for (size_t i = pos; i + 2 < san.size(); ++i)
+    {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h')
+            fromFile = c - 'a';
+        else if (c >= '1' && c <= '8')
+            fromRank = c - '1';
+    }
+
+    for (int y = 0; y < 8; ++y)
+    {
+        if (fromRank != -1 && y != fromRank)
+            continue;
+        for (int x = 0; x < 8; ++x)
+        {
+            if (fromFile != -1 && x != fromFile)
+                continue;
+            const auto& piece = grid[y][x];
+            if (!piece || piece->getColor() != color || piece->getType() != type)
+                continue;
+
+            for (const auto& m : board.getSelectableMoves(Position(x, y)))
+            {
+                if (!(m.getTo() == to) || m.isCastling())
+                    continue;
+                if (m.isPromotion())
+                {
+                    if (promotion.empty())
+                        continue;
+                    Move promo(m.getFrom(), m.getTo(), false, true, false, promotion);
+                    if (board.isValidMove(promo))
+                        return promo;
+                    continue;
+                }
+                return m;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::string Pgn::moveToUci(const Move& move)
+{
+    std::string res;
+    res += static_cast<char>('a' + move.getFrom().getX());
+    res += static_cast<char>('1' + move.getFrom().getY());
+    res += static_cast<char>('a' + move.getTo().getX());
+    res += static_cast<char>('1' + move.getTo().getY());
+    std::string promo = move.getPromotionPiece();
+    if (!promo.empty())
+        res += (promo == "knight") ? 'n' : promo[0];
+    return res;
+}
\ No newline at end of file
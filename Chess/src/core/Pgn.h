@@ -0,0 +1,41 @@
+#pragma once
+#include "board.h"
+#include <istream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct PgnGame
+{
+    std::map<std::string, std::string> tags;
+    std::vector<std::string> moves; // SAN без номеров ходов, комментариев и вариантов
+    std::string result;             // "1-0", "0-1", "1/2-1/2" или "*"
+};
+
+// Потоковое чтение PGN: партии читаются по одной, файл целиком в память не загружается
+class PgnReader
+{
+    std::istream& in;
+    std::string pendingLine;
+    bool hasPending = false;
+
+    bool readLine(std::string& line);
+
+public:
+    explicit PgnReader(std::istream& in);
+
+    bool next(PgnGame& game);
+    // Текст следующей партии без разбора (для раздачи партий по потокам)
+    bool nextRaw(std::string& text);
+
+    static bool parse(const std::string& text, PgnGame& game);
+};
+
+class Pgn
+{
+public:
+    // Ход в SAN ("Nbd7", "exd6", "O-O", "e8=Q+") среди легальных ходов текущей позиции
+    static std::optional<Move> sanToMove(const Board& board, const std::string& san);
+    static std::string moveToUci(const Move& move);
+};
\ No newline at end of file
@@ -0,0 +1,655 @@
+#include "Search.h"
+#include "Evaluate.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Оценки мата в хеше хранятся относительно узла, а не корня
+static int scoreToTt(int score, int ply)
+{
+    if (score > Search::MATE_BOUND)
+        return score + ply;
+    if (score < -Search::MATE_BOUND)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTt(int score, int ply)
+{
+    if (score > Search::MATE_BOUND)
+        return score - ply;
+    if (score < -Search::MATE_BOUND)
+        return score + ply;
+    return score;
+}
+
+Search::Search()
+{
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+}
+
+void Search::setHashSize(size_t megabytes)
+{
+    tt.resize(megabytes);
+}
+
+void Search::clearHash()
+{
+    tt.clear();
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+}
+
+void Search::setTablebase(std::shared_ptr<const Tablebase> tb)
+{
+    tablebase = std::move(tb);
+}
+
+void Search::setParams(const SearchParams& searchParams)
+{
+    params = searchParams;
+}
+
+bool SearchParams::set(const std::string& name, const std::string& value)
+{
+    try
+    {
+        bool flag = value == "true" || value == "on" || value == "1";
+        if (name == "nullmove")
+            nullMove = flag;
+        else if (name == "lmr")
+            lateMoveReductions = flag;
+        else if (name == "futility")
+            futilityPruning = flag;
+        else if (name == "aspiration")
+            aspirationWindow = std::stoi(value);
+        else if (name == "fmargin")
+            futilityMargin = std::stoi(value);
+        else if (name == "rfmargin")
+            reverseFutilityMargin = std::stoi(value);
+        else
+            return false;
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void Search::setNetwork(std::shared_ptr<const NnueNetwork> nnue)
+{
+    network = std::move(nnue);
+    if (network && accumulators.empty())
+        accumulators.resize(MAX_PLY + 2);
+}
+
+void Search::setInfoCallback(std::function<void(const SearchInfo&)> callback)
+{
+    infoCallback = std::move(callback);
+}
+
+void Search::stop()
+{
+    stopped.store(true, std::memory_order_relaxed);
+}
+
+void Search::ponderHit()
+{
+    pondering.store(false, std::memory_order_relaxed);
+}
+
+void Search::clearStop(bool ponder)
+{
+    stopped.store(false, std::memory_order_relaxed);
+    pondering.store(ponder, std::memory_order_relaxed);
+}
+
+int Search::mateIn(int score)
+{
+    if (score > MATE_BOUND)
+        return (MATE - score + 1) / 2;
+    if (score < -MATE_BOUND)
+        return -(MATE + score) / 2;
+    return 0;
+}
+
+void Search::setupTime()
+{
+    TimeControl control;
+    if (!limits.infinite)
+    {
+        int side = pos.sideToMove();
+        control.remainingMs = limits.timeMs[side];
+        control.incrementMs = limits.incMs[side];
+        control.movesToGo = limits.movesToGo;
+        control.moveTimeMs = limits.moveTimeMs;
+    }
+    control.moveNumber = pos.getFullmoveNumber();
+    control.overheadMs = limits.moveOverheadMs;
+    timeManager.start(control);
+}
+
+void Search::checkLimits()
+{
+    if (limits.nodes && nodes >= limits.nodes)
+        stopped.store(true, std::memory_order_relaxed);
+    else if (timeManager.isLimited() && (nodes & 1023) == 0 && !pondering.load(std::memory_order_relaxed) && timeManager.hardExpired())
+        stopped.store(true, std::memory_order_relaxed);
+}
+
+SearchResult Search::run(const FastBoard& root, const SearchLimits& searchLimits, const std::vector<uint64_t>& gameHistory)
+{
+    pos = root;
+    limits = searchLimits;
+    setupTime();
+
+    tt.newSearch();
+    keys = gameHistory;
+    keys.push_back(pos.getKey());
+    nodes = 0;
+    std::memset(killers, 0, sizeof(killers));
+    if (network)
+    {
+        network->refresh(pos, SIDE_WHITE, accumulators[0]);
+        network->refresh(pos, SIDE_BLACK, accumulators[0]);
+    }
+    for (auto& side : history)
+    {
+        for (auto& from : side)
+        {
+            for (int& value : from)
+                value /= 8;
+        }
+    }
+
+    SearchResult result;
+    MoveList rootMoves;
+    pos.generateMoves(rootMoves);
+    int allowedMoves = 0;
+    for (FastMove m : rootMoves)
+    {
+        const auto& allowed = limits.searchMoves;
+        if (allowed.empty() || std::find(allowed.begin(), allowed.end(), m) != allowed.end())
+        {
+            if (result.bestMove == NO_MOVE)
+                result.bestMove = m;
+            ++allowedMoves;
+        }
+    }
+
+    int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    int lineCount = std::max(1, std::min(limits.multiPv, allowedMoves));
+    std::vector<int> scores(lineCount, 0);
+    int score = 0;
+    for (int depth = 1; depth <= maxDepth && result.bestMove != NO_MOVE; ++depth)
+    {
+        selDepth = 0;
+        excludedMoves.clear();
+        bool failedLow = false;
+        for (int line = 0; line < lineCount; ++line)
+        {
+            int delta = params.aspirationWindow;
+            int alpha = -INF, beta = INF;
+            if (depth >= 5 && delta > 0)
+            {
+                alpha = std::max(scores[line] - delta, -INF);
+                beta = std::min(scores[line] + delta, INF);
+            }
+
+            // окно вокруг прошлой оценки, при выходе за него - расширяем
+            while (true)
+            {
+                int value = negamax(alpha, beta, depth, 0, false);
+                if (stopped.load(std::memory_order_relaxed))
+                    break;
+                delta *= 2;
+                if (value <= alpha)
+                {
+                    alpha = std::max(value - delta, -INF);
+                    failedLow = failedLow || line == 0;
+                }
+                else if (value >= beta)
+                    beta = std::min(value + delta, INF);
+                else
+                {
+                    scores[line] = value;
+                    break;
+                }
+            }
+            if (stopped.load(std::memory_order_relaxed))
+                break;
+
+            if (line == 0)
+            {
+                score = scores[0];
+                result.bestMove = pv[0][0];
+                result.ponderMove = pvLength[0] > 1 ? pv[0][1] : NO_MOVE;
+                result.score = score;
+                result.depth = depth;
+            }
+
+            if (infoCallback)
+            {
+                SearchInfo info;
+                info.multiPv = line + 1;
+                info.depth = depth;
+                info.selDepth = std::max(selDepth, depth);
+                info.score = scores[line];
+                info.nodes = nodes;
+                info.timeMs = timeManager.elapsedMs();
+                info.hashfull = tt.hashfull();
+                info.pv.assign(pv[0], pv[0] + pvLength[0]);
+                infoCallback(info);
+            }
+            excludedMoves.push_back(pv[0][0]);
+        }
+        if (stopped.load(std::memory_order_relaxed))
+            break;
+
+        if (limits.mate > 0 && mateIn(score) > 0 && mateIn(score) <= limits.mate)
+            break;
+        // мат доказан с запасом глубины - дальше углубляться незачем
+        if (mateIn(score) != 0 && depth >= 2 * std::abs(mateIn(score)) + 10)
+            break;
+        timeManager.onIteration(depth, result.bestMove, score, failedLow);
+        if (timeManager.isLimited() && !pondering.load(std::memory_order_relaxed) && (timeManager.softExpired() || rootMoves.size == 1))
+            break;
+    }
+
+    // Syzygy знает только выигрыш, а не мат: пока перебор мата не видит, ход выбирают по .rtbz,
+    // иначе перебор может ходить по кругу до правила 50 ходов
+    if (tablebase && limits.searchMoves.empty() && mateIn(result.score) == 0 && pos.pieceCount() <= tablebase->getMaxPieces())
+    {
+        auto probe = tablebase->probe(pos, true);
+        if (probe && probe->wdl != 0 && probe->dtm < 0 && probe->dtz > 0)
+        {
+            if (auto move = tablebase->probeRoot(pos))
+            {
+                result.bestMove = *move;
+                result.ponderMove = NO_MOVE;
+            }
+        }
+    }
+
+    result.nodes = nodes;
+
+    // в режиме infinite и во время размышления bestmove отдаётся только после stop (или ponderhit)
+    while ((limits.infinite || pondering.load(std::memory_order_relaxed)) && !stopped.load(std::memory_order_relaxed))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pondering.store(false, std::memory_order_relaxed);
+    return result;
+}
+
+bool Search::isDraw() const
+{
+    if (pos.getHalfmoveClock() >= 100 || pos.isInsufficientMaterial())
+        return true;
+
+    // повторение в пределах необратимых ходов; внутри перебора хватает двукратного
+    int n = static_cast<int>(keys.size());
+    int limit = std::min(pos.getHalfmoveClock(), n - 1);
+    for (int i = 4; i <= limit; i += 2)
+    {
+        if (keys[n - 1 - i] == keys[n - 1])
+            return true;
+    }
+    return false;
+}
+
+void Search::scoreMoves(const MoveList& list, int* scores, FastMove ttMove, int ply) const
+{
+    for (int i = 0; i < list.size; ++i)
+    {
+        FastMove m = list.moves[i];
+        int to = moveTo(m);
+        if (m == ttMove)
+            scores[i] = 1 << 30;
+        else if (isPromotion(m) && promotionType(m) != QUEEN)
+            scores[i] = -(1 << 20);
+        else if (pos.isCapture(m) || isPromotion(m))
+        {
+            int victim = moveFlag(m) == FLAG_EN_PASSANT ? PAWN : pos.pieceOn(to) >= 0 ? FastBoard::pieceType(pos.pieceOn(to)) : -1;
+            int gain = (victim >= 0 ? Evaluator::pieceValue(victim) : 0) + (isPromotion(m) ? Evaluator::pieceValue(QUEEN) : 0);
+            scores[i] = (1 << 20) + gain * 8 - FastBoard::pieceType(pos.pieceOn(moveFrom(m)));
+        }
+        else if (m == killers[ply][0])
+            scores[i] = (1 << 19) + 1;
+        else if (m == killers[ply][1])
+            scores[i] = 1 << 19;
+        else
+            scores[i] = history[pos.sideToMove()][moveFrom(m)][to];
+    }
+}
+
+// Лучший из оставшихся ходов переставляется на позицию i
+static void pickMove(MoveList& list, int* scores, int i)
+{
+    int best = i;
+    for (int j = i + 1; j < list.size; ++j)
+    {
+        if (scores[j] > scores[best])
+            best = j;
+    }
+    std::swap(list.moves[i], list.moves[best]);
+    std::swap(scores[i], scores[best]);
+}
+
+void Search::updateQuietStats(FastMove m, int depth, int ply)
+{
+    if (killers[ply][0] != m)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = m;
+    }
+
+    int& value = history[pos.sideToMove()][moveFrom(m)][moveTo(m)];
+    value += depth * depth;
+    if (value > (1 << 18))
+    {
+        for (auto& side : history)
+        {
+            for (auto& from : side)
+            {
+                for (int& v : from)
+                    v /= 2;
+            }
+        }
+    }
+}
+
+// Ход в переборе: суммы сети для нового узла не считаются сразу, а помечаются устаревшими
+// и догоняются в evaluate() - в узлах, отсечённых до оценки, на них не тратится время
+void Search::makeMove(FastMove m, UndoInfo& undo, int ply)
+{
+    if (network)
+    {
+        deltas[ply + 1] = NnueDelta::forMove(pos, m);
+        accumulators[ply + 1].computed[SIDE_WHITE] = false;
+        accumulators[ply + 1].computed[SIDE_BLACK] = false;
+    }
+    pos.makeMove(m, undo);
+}
+
+void Search::makeNullMove(UndoInfo& undo, int ply)
+{
+    if (network)
+    {
+        deltas[ply + 1] = NnueDelta {};
+        accumulators[ply + 1].computed[SIDE_WHITE] = false;
+        accumulators[ply + 1].computed[SIDE_BLACK] = false;
+    }
+    pos.makeNullMove(undo);
+}
+
+int Search::evaluate(int ply)
+{
+    if (!network)
+        return Evaluator::evaluate(pos);
+
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; ++side)
+    {
+        if (accumulators[ply].computed[side])
+            continue;
+
+        // ищем ближайший посчитанный узел выше; после хода своего короля проще пересчитать заново
+        int from = ply;
+        while (from > 0 && !accumulators[from].computed[side] && !deltas[from].movesKing(side))
+            --from;
+        if (!accumulators[from].computed[side])
+        {
+            network->refresh(pos, side, accumulators[ply]);
+            continue;
+        }
+        for (int p = from + 1; p <= ply; ++p)
+            network->update(accumulators[p - 1], accumulators[p], deltas[p], pos, side);
+    }
+    return network->evaluate(accumulators[ply], pos.sideToMove());
+}
+
+int Search::negamax(int alpha, int beta, int depth, int ply, bool nullAllowed)
+{
+    pvLength[ply] = ply;
+    if (depth <= 0)
+        return quiesce(alpha, beta, ply);
+
+    ++nodes;
+    checkLimits();
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+
+    bool pvNode = beta - alpha > 1;
+    if (ply > 0)
+    {
+        if (isDraw())
+            return 0;
+        // мат короче уже найденного здесь не улучшить
+        alpha = std::max(alpha, -MATE + ply);
+        beta = std::min(beta, MATE - ply - 1);
+        if (alpha >= beta)
+            return alpha;
+    }
+    if (ply >= MAX_PLY)
+        return evaluate(ply);
+
+    bool inCheck = pos.inCheck();
+    if (inCheck)
+        ++depth;
+
+    uint64_t key = pos.getKey();
+    TtEntry entry;
+    FastMove ttMove = NO_MOVE;
+    if (tt.probe(key, entry))
+    {
+        ttMove = entry.move;
+        int ttScore = scoreFromTt(entry.score, ply);
+        if (ply > 0 && !pvNode && entry.depth >= depth
+            && (entry.bound == BOUND_EXACT
+                || (entry.bound == BOUND_LOWER && ttScore >= beta)
+                || (entry.bound == BOUND_UPPER && ttScore <= alpha)))
+            return ttScore;
+    }
+
+    // точная оценка по таблицам эндшпиля: dtm - полуходов до мата от этого узла
+    if (ply > 0 && tablebase && pos.pieceCount() <= tablebase->getMaxPieces())
+    {
+        if (auto probe = tablebase->probe(pos))
+        {
+            if (probe->dtm < 0)
+                return probe->wdl > 0 ? TB_WIN - ply : probe->wdl < 0 ? -TB_WIN + ply : 0;
+            if (probe->wdl > 0)
+                return MATE - ply - probe->dtm;
+            if (probe->wdl < 0)
+                return -MATE + ply + probe->dtm;
+            return 0;
+        }
+    }
+
+    int staticEval = inCheck ? -INF : evaluate(ply);
+    if (ply > 0 && !pvNode && !inCheck)
+    {
+        if (params.futilityPruning && depth <= 6 && staticEval - params.reverseFutilityMargin * depth >= beta && std::abs(beta) < MATE_BOUND)
+            return staticEval;
+
+        if (params.nullMove && nullAllowed && depth >= 3 && staticEval >= beta && pos.hasNonPawnMaterial(pos.sideToMove()))
+        {
+            int reduction = 3 + depth / 6;
+            UndoInfo undo;
+            makeNullMove(undo, ply);
+            keys.push_back(pos.getKey());
+            int value = -negamax(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+            keys.pop_back();
+            pos.unmakeNullMove(undo);
+            if (stopped.load(std::memory_order_relaxed))
+                return 0;
+            if (value >= beta)
+                return value >= MATE_BOUND ? beta : value;
+        }
+    }
+
+    MoveList list;
+    pos.generateMoves(list);
+    if (list.size == 0)
+        return inCheck ? -MATE + ply : 0;
+
+    int scores[256];
+    scoreMoves(list, scores, ttMove, ply);
+
+    int oldAlpha = alpha;
+    int bestScore = -INF;
+    FastMove bestMove = NO_MOVE;
+    int played = 0;
+    for (int i = 0; i < list.size; ++i)
+    {
+        pickMove(list, scores, i);
+        FastMove m = list.moves[i];
+        if (ply == 0 && !limits.searchMoves.empty()
+            && std::find(limits.searchMoves.begin(), limits.searchMoves.end(), m) == limits.searchMoves.end())
+            continue;
+        if (ply == 0 && std::find(excludedMoves.begin(), excludedMoves.end(), m) != excludedMoves.end())
+            continue;
+
+        bool quiet = !pos.isCapture(m) && !isPromotion(m);
+        bool killer = m == killers[ply][0] || m == killers[ply][1];
+        UndoInfo undo;
+        makeMove(m, undo, ply);
+        bool givesCheck = pos.inCheck();
+
+        // тихие ходы в безнадёжных узлах у горизонта не смотрим
+        if (params.futilityPruning && quiet && !pvNode && !inCheck && !givesCheck && played > 0 && bestScore > -MATE_BOUND && depth <= 3
+            && (staticEval + params.futilityMargin * (depth + 1) <= alpha || played >= 3 + 4 * depth))
+        {
+            pos.unmakeMove(m, undo);
+            continue;
+        }
+
+        keys.push_back(pos.getKey());
+        int value;
+        if (played == 0)
+            value = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+        else
+        {
+            int reduction = 0;
+            if (params.lateMoveReductions && quiet && !killer && depth >= 3 && played >= 3 && !inCheck && !givesCheck)
+            {
+                reduction = 1 + (played >= 8 ? 1 : 0) + (depth >= 8 ? 1 : 0) - (pvNode ? 1 : 0);
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
+            value = -negamax(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1, true);
+            if (value > alpha && reduction > 0)
+                value = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1, true);
+            if (value > alpha && value < beta)
+                value = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+        }
+        keys.pop_back();
+        pos.unmakeMove(m, undo);
+        ++played;
+
+        if (stopped.load(std::memory_order_relaxed))
+            return 0;
+
+        if (value > bestScore)
+        {
+            bestScore = value;
+            if (value > alpha)
+            {
+                alpha = value;
+                bestMove = m;
+                pv[ply][ply] = m;
+                for (int k = ply + 1; k < pvLength[ply + 1]; ++k)
+                    pv[ply][k] = pv[ply + 1][k];
+                pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+                if (value >= beta)
+                {
+                    if (quiet)
+                        updateQuietStats(m, depth, ply);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (played == 0)
+        return 0;
+
+    // в корне без части ходов лучший ход не настоящий - в хеш его не пишем
+    if (ply == 0 && !excludedMoves.empty())
+        return bestScore;
+
+    TtBound bound = bestScore >= beta ? BOUND_LOWER : alpha > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
+    tt.store(key, bestMove, scoreToTt(bestScore, ply), staticEval, depth, bound);
+    return bestScore;
+}
+
+int Search::quiesce(int alpha, int beta, int ply)
+{
+    ++nodes;
+    checkLimits();
+    if (stopped.load(std::memory_order_relaxed))
+        return 0;
+
+    selDepth = std::max(selDepth, ply);
+    if (isDraw())
+        return 0;
+    if (ply >= MAX_PLY)
+        return evaluate(ply);
+
+    bool inCheck = pos.inCheck();
+    int standPat = -INF;
+    if (!inCheck)
+    {
+        standPat = evaluate(ply);
+        if (standPat >= beta)
+            return standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    // под шахом смотрим все ответы, иначе только взятия и превращения
+    MoveList list;
+    if (inCheck)
+        pos.generateMoves(list);
+    else
+        pos.generateCaptures(list);
+    if (inCheck && list.size == 0)
+        return -MATE + ply;
+
+    int scores[256];
+    scoreMoves(list, scores, NO_MOVE, ply);
+
+    int bestScore = standPat;
+    for (int i = 0; i < list.size; ++i)
+    {
+        pickMove(list, scores, i);
+        FastMove m = list.moves[i];
+        if (!inCheck && !isPromotion(m))
+        {
+            int victim = moveFlag(m) == FLAG_EN_PASSANT ? PAWN : FastBoard::pieceType(pos.pieceOn(moveTo(m)));
+            if (standPat + Evaluator::pieceValue(victim) + 200 <= alpha)
+                continue;
+        }
+
+        UndoInfo undo;
+        makeMove(m, undo, ply);
+        keys.push_back(pos.getKey());
+        int value = -quiesce(-beta, -alpha, ply + 1);
+        keys.pop_back();
+        pos.unmakeMove(m, undo);
+
+        if (stopped.load(std::memory_order_relaxed))
+            return 0;
+
+        if (value > bestScore)
+        {
+            bestScore = value;
+            if (value > alpha)
+            {
+                alpha = value;
+                if (value >= beta)
+                    break;
+            }
+        }
+    }
+    return bestScore;
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+#include "FastBoard.h"
+#include "Nnue.h"
+#include "Tablebase.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Ограничения "go": нули и -1 означают отсутствие ограничения
+struct SearchLimits
+{
+    int depth = 0;
+    uint64_t nodes = 0;
+    int mate = 0;           // найти мат не более чем в N ходов
+    int moveTimeMs = 0;
+    int timeMs[2] = { -1, -1 };
+    int incMs[2] = { 0, 0 };
+    int movesToGo = 0;
+    int moveOverheadMs = 30;
+    bool infinite = false;
+    int multiPv = 1;        // сколько лучших ходов корня считать отдельными вариантами
+    std::vector<FastMove> searchMoves;
+};
+
+// Переключатели и пороги отсечений - чтобы сравнивать варианты перебора (sprt) без пересборки
+struct SearchParams
+{
+    bool nullMove = true;
+    bool lateMoveReductions = true;
+    bool futilityPruning = true;
+    int aspirationWindow = 25;
+    int futilityMargin = 100;
+    int reverseFutilityMargin = 80;
+
+    // Имена как в командной строке sprt: nullmove, lmr, futility, aspiration, fmargin, rfmargin
+    bool set(const std::string& name, const std::string& value);
+};
+
+struct SearchInfo
+{
+    int multiPv = 1;        // номер варианта, с единицы
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    int hashfull = 0;
+    std::vector<FastMove> pv;
+};
+
+struct SearchResult
+{
+    FastMove bestMove = NO_MOVE;
+    FastMove ponderMove = NO_MOVE;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+};
+
+// Альфа-бета с итеративным углублением (PVS, нулевой ход, сокращения поздних ходов),
+// форсированный перебор взятий, хеш-таблица и точные оценки по таблицам эндшпиля.
+// run() выполняется в вызывающем потоке, stop() можно вызвать из любого другого.
+class Search
+{
+public:
+    static constexpr int MAX_PLY = 128;
+    static constexpr int INF = 32001;
+    static constexpr int MATE = 32000;
+    // оценки выше - мат (по таблицам эндшпиля - до 255 полуходов от корня)
+    static constexpr int MATE_BOUND = MATE - 1000;
+    // выигрыш по Syzygy без расстояния до мата - ниже всех матовых оценок
+    static constexpr int TB_WIN = MATE_BOUND - 1 - MAX_PLY;
+
+    Search();
+
+    void setHashSize(size_t megabytes);
+    void clearHash();
+    void setTablebase(std::shared_ptr<const Tablebase> tablebase);
+    void setParams(const SearchParams& params);
+    // nullptr - оценка по параметрам EvalParams.h
+    void setNetwork(std::shared_ptr<const NnueNetwork> network);
+    // Вызывается после каждой завершённой итерации
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback);
+
+    // history - ключи позиций партии до pos, для распознавания повторений
+    SearchResult run(const FastBoard& pos, const SearchLimits& limits, const std::vector<uint64_t>& history = {});
+    void stop();
+    // Соперник сыграл ожидаемый ход: перебор становится обычным. Время размышления засчитывается,
+    // поэтому после долгого размышления ход отдаётся почти сразу
+    void ponderHit();
+    // Сбрасывает флаг остановки; вызывается до запуска потока поиска, чтобы ранний stop() не потерялся.
+    // ponder - перебор на времени соперника: лимиты времени действуют только после ponderHit()
+    void clearStop(bool ponder = false);
+
+    // Ходов до мата по оценке: > 0 - мы ставим мат, < 0 - нам, 0 - не мат
+    static int mateIn(int score);
+
+private:
+    FastBoard pos;
+    SearchLimits limits;
+    SearchParams params;
+    TranspositionTable tt;
+    std::shared_ptr<const Tablebase> tablebase;
+    std::shared_ptr<const NnueNetwork> network;
+    std::function<void(const SearchInfo&)> infoCallback;
+
+    std::atomic<bool> stopped { false };
+    std::atomic<bool> pondering { false };
+    uint64_t nodes = 0;
+    int selDepth = 0;
+    TimeManager timeManager;
+
+    std::vector<uint64_t> keys;
+    // ходы корня, уже ставшие вариантами на текущей глубине - следующий вариант ищется без них
+    std::vector<FastMove> excludedMoves;
+    FastMove pv[MAX_PLY + 1][MAX_PLY + 1];
+    int pvLength[MAX_PLY + 1];
+    FastMove killers[MAX_PLY + 1][2];
+    int history[2][64][64];
+
+    // суммы сети по глубине: accumulators[ply] - позиция в узле ply, deltas[ply] - ход, который к ней привёл
+    std::vector<NnueAccumulator> accumulators;
+    NnueDelta deltas[MAX_PLY + 2];
+
+    int negamax(int alpha, int beta, int depth, int ply, bool nullAllowed);
+    int quiesce(int alpha, int beta, int ply);
+    void makeMove(FastMove m, UndoInfo& undo, int ply);
+    void makeNullMove(UndoInfo& undo, int ply);
+    int evaluate(int ply);
+    void scoreMoves(const MoveList& list, int* scores, FastMove ttMove, int ply) const;
+    void updateQuietStats(FastMove m, int depth, int ply);
+    bool isDraw() const;
+    void setupTime();
+    void checkLimits();
+};
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "Stockfish.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
@@ -56,8 +58,8 @@ bool Stockfish::start()
         return false;
     }
 
-    // закрытие дескрипторов процесса и потока
-    CloseHandle(piProcInfo.hProcess);
+    // дескриптор процесса оставляем для проверки состояния, поток закрываем
+    hProcess = piProcInfo.hProcess;
     CloseHandle(piProcInfo.hThread);
     CloseHandle(hChildStd_OUT_Wr);
     CloseHandle(hChildStd_IN_Rd);
@@ -83,6 +85,26 @@ void Stockfish::stop()
         CloseHandle(hChildStd_OUT_Rd);
         hChildStd_OUT_Rd = NULL;
     }
+
+    // даём движку время завершиться, иначе убиваем процесс
+    if (hProcess)
+    {
+        if (WaitForSingleObject(hProcess, 500) != WAIT_OBJECT_0)
+            TerminateProcess(hProcess, 1);
+        CloseHandle(hProcess);
+        hProcess = NULL;
+    }
+}
+
+bool Stockfish::isAlive() const
+{
+    if (!hProcess || !hChildStd_IN_Wr || !hChildStd_OUT_Rd)
+        return false;
+
+    DWORD exitCode = 0;
+    if (!GetExitCodeProcess(hProcess, &exitCode))
+        return false;
+    return exitCode == STILL_ACTIVE;
 }
 
 void Stockfish::sendCommand(std::string cmd)
@@ -96,7 +118,7 @@ void Stockfish::sendCommand(std::string cmd)
     WriteFile(hChildStd_IN_Wr, cmd.c_str(), cmd.length(), &dwWritten, NULL);
 }
 
-std::string Stockfish::readResponse()
+std::string Stockfish::readResponse(int timeoutMs)
 {
     if (!hChildStd_OUT_Rd)
         return "";
@@ -104,15 +126,39 @@ std::string Stockfish::readResponse()
     CHAR chBuf[4096]; 
     std::string result;
 
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    bool stopSent = false;
+
     while (true)
     {
+        // не блокируемся на ReadFile, пока в трубе нет данных
+        DWORD dwAvail = 0;
+        if (!PeekNamedPipe(hChildStd_OUT_Rd, NULL, 0, NULL, &dwAvail, NULL))
+            break;
+
+        if (dwAvail == 0)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                // время вышло: просим движок остановиться и даём ему немного времени на bestmove
+                if (stopSent)
+                    break;
+                sendCommand("stop");
+                stopSent = true;
+                deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+            }
+            Sleep(1);
+            continue;
+        }
+
         // Если чтение не удалось — выход
-        if (!ReadFile(hChildStd_OUT_Rd, chBuf, 4096, &dwRead, NULL) || dwRead == 0)
+        if (!ReadFile(hChildStd_OUT_Rd, chBuf, std::min<DWORD>(dwAvail, 4096), &dwRead, NULL) || dwRead == 0)
             break;
 
-        // останавливаемся на найденном ходе
+        // останавливаемся на найденном ходе, но только когда его строка пришла целиком (с ponder-ходом)
         result.append(chBuf, dwRead);
-        if (result.find("bestmove") != std::string::npos)
+        size_t best = result.find("bestmove");
+        if (best != std::string::npos && result.find('\n', best) != std::string::npos)
             break;
     }
     return result;
@@ -135,25 +181,86 @@ std::string Stockfish::moveToString(const Move& move)
     return res;
 }
 
-std::string Stockfish::getBestMove(const std::string& fen)
+std::string Stockfish::getBestMove(const std::string& fen, int moveTimeMs)
+{
+    return analyse(fen, moveTimeMs).bestMove;
+}
+
+AnalysisResult Stockfish::analyse(const std::string& fen, int moveTimeMs)
 {
     std::string cmd = "position fen " + fen;
 
     sendCommand(cmd);
-    sendCommand("go movetime 1000"); // 1 секунда на поиск хода
+    sendCommand("go movetime " + std::to_string(moveTimeMs)); // время на поиск хода
 
-    std::string output = readResponse(); // ожидание ответа
+    std::string output = readResponse(moveTimeMs + 1000); // ожидание ответа с запасом
+    return parseResult(output);
+}
 
+void Stockfish::ponder(const std::string& fen, const std::string& expectedMove, int moveTimeMs)
+{
+    sendCommand("position fen " + fen + " moves " + expectedMove);
+    // movetime отсчитывается от go, поэтому после долгого размышления ход отдаётся сразу после ponderhit
+    sendCommand("go ponder movetime " + std::to_string(moveTimeMs));
+}
+
+AnalysisResult Stockfish::ponderHit(int moveTimeMs)
+{
+    sendCommand("ponderhit");
+    return parseResult(readResponse(moveTimeMs + 1000));
+}
+
+void Stockfish::cancelPonder()
+{
+    sendCommand("stop");
+    readResponse(1000);
+}
+
+AnalysisResult Stockfish::parseResult(const std::string& output)
+{
+    AnalysisResult result;
     size_t pos = output.find("bestmove");
-    if (pos != std::string::npos)
+    if (pos == std::string::npos)
+        return result;
+
+    std::string moveStr = output.substr(pos + 9, 5);
+    size_t space = moveStr.find(' ');
+    if (space != std::string::npos)
+        moveStr = moveStr.substr(0, space);
+    moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\n'), moveStr.end());
+    moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\r'), moveStr.end());
+    result.bestMove = moveStr;
+
+    // bestmove e2e4 ponder e7e5
+    std::string bestLine = output.substr(pos, output.find('\n', pos) - pos);
+    bestLine.erase(std::remove(bestLine.begin(), bestLine.end(), '\r'), bestLine.end());
+    std::istringstream bestTokens(bestLine);
+    std::string word;
+    while (bestTokens >> word)
     {
-        std::string moveStr = output.substr(pos + 9, 5);
-        size_t space = moveStr.find(' ');
-        if (space != std::string::npos)
-            moveStr = moveStr.substr(0, space);
-        moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\n'), moveStr.end());
-        moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\r'), moveStr.end());
-        return moveStr;
+        if (word == "ponder")
+            bestTokens >> result.ponderMove;
     }
-    return "";
+
+    // оценка и глубина - из последней строки info перед bestmove
+    size_t infoPos = output.rfind("info depth", pos);
+    if (infoPos != std::string::npos)
+    {
+        std::istringstream info(output.substr(infoPos, output.find('\n', infoPos) - infoPos));
+        std::string token;
+        while (info >> token)
+        {
+            if (token == "depth")
+                info >> result.depth;
+            else if (token == "score")
+            {
+                std::string type;
+                int value = 0;
+                info >> type >> value;
+                // мат в N ходов переводим в заведомо большую оценку
+                result.score = (type == "mate") ? (value > 0 ? 32000 - value : -32000 - value) : value;
+            }
+        }
+    }
+    return result;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include "AnalysisCache.h"
 #include "move.h"
 #include <string>
 #include <vector>
@@ -11,19 +12,31 @@ public:
     ~Stockfish();
 
     bool start();
-    std::string getBestMove(const std::string& fen);
+    std::string getBestMove(const std::string& fen, int moveTimeMs = 1000);
+    AnalysisResult analyse(const std::string& fen, int moveTimeMs);
+
+    // go ponder: перебор ответа на ожидаемый ход соперника expectedMove в позиции fen
+    void ponder(const std::string& fen, const std::string& expectedMove, int moveTimeMs);
+    // Ожидаемый ход сыгран: перебор становится обычным, ответ - как у analyse
+    AnalysisResult ponderHit(int moveTimeMs);
+    // Промах: перебор останавливается, его bestmove вычитывается и отбрасывается
+    void cancelPonder();
+
     void stop();
+    bool isAlive() const;
 
 private:
     std::string exePath;
 
     // Указатели на ресурсы
+    HANDLE hProcess = NULL; // Дескриптор процесса движка (для проверки, что он жив)
     HANDLE hChildStd_IN_Rd = NULL; // Чтение из трубы ввода (для дочернего процесса)
     HANDLE hChildStd_IN_Wr = NULL; // Запись в трубу ввода (пишет приложение)
     HANDLE hChildStd_OUT_Rd = NULL; // Чтение из трубы вывода (читает приложение)
     HANDLE hChildStd_OUT_Wr = NULL; // Запись в трубу вывода (пишет дочерний процесс)
 
     void sendCommand(std::string cmd);
-    std::string readResponse();
+    std::string readResponse(int timeoutMs);
+    static AnalysisResult parseResult(const std::string& output);
     std::string moveToString(const Move& move);
 };
\ No newline at end of file
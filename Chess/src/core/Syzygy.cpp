@@ -0,0 +1,677 @@
+#include "Syzygy.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint8_t WDL_MAGIC[4] = { 0x71, 0xE8, 0x23, 0x5D };
+static const uint8_t DTZ_MAGIC[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+static const char SYZYGY_LETTERS[] = "PNBRQK";
+
+// флаги блока данных
+static const uint8_t FLAG_STM = 1;
+static const uint8_t FLAG_MAPPED = 2;
+static const uint8_t FLAG_WIN_PLIES = 4;
+static const uint8_t FLAG_LOSS_PLIES = 8;
+static const uint8_t FLAG_WIDE = 16;
+static const uint8_t FLAG_SINGLE_VALUE = 128;
+
+static uint16_t readLe16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+static uint32_t readLe32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16)
+        | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint32_t readBe32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8)
+        | static_cast<uint32_t>(p[3]);
+}
+
+// Расстояние от диагонали a1-h8: > 0 - над ней
+static int offDiagonal(int sq) { return rankOf(sq) - fileOf(sq); }
+
+// Таблицы нумерации полей и сочетаний, общие для всех файлов Syzygy
+struct SyzygyMaps
+{
+    uint64_t binomial[SyzygyTable::MAX_PIECES][64] = {};
+    int mapPawns[64] = {};
+    uint64_t leadPawnIdx[SyzygyTable::MAX_PIECES][64] = {};
+    uint64_t leadPawnsSize[SyzygyTable::MAX_PIECES][4] = {};
+    int mapB1H1H7[64] = {};
+    int mapA1D1D4[64] = {};
+    int mapKK[10][64] = {};
+
+    SyzygyMaps()
+    {
+        for (int n = 0; n < 64; ++n)
+        {
+            binomial[0][n] = 1;
+            for (int k = 1; k < SyzygyTable::MAX_PIECES && k <= n; ++k)
+                binomial[k][n] = binomial[k - 1][n - 1] + (k < n ? binomial[k][n - 1] : 0);
+        }
+
+        int code = 0;
+        for (int sq = 0; sq < 64; ++sq)
+        {
+            if (offDiagonal(sq) < 0)
+                mapB1H1H7[sq] = code++;
+        }
+
+        // сначала поля под диагональю, потом сама диагональ a1-d4
+        code = 0;
+        std::vector<int> diagonal;
+        for (int sq = 0; sq <= squareOf(3, 3); ++sq)
+        {
+            if (fileOf(sq) > 3)
+                continue;
+            if (offDiagonal(sq) < 0)
+                mapA1D1D4[sq] = code++;
+            else if (offDiagonal(sq) == 0)
+                diagonal.push_back(sq);
+        }
+        for (int sq : diagonal)
+            mapA1D1D4[sq] = code++;
+
+        // пары королей: первый в треугольнике, второй не рядом; пары на диагонали нумеруются последними
+        code = 0;
+        std::vector<std::pair<int, int>> bothOnDiagonal;
+        for (int idx = 0; idx < 10; ++idx)
+        {
+            for (int s1 = 0; s1 <= squareOf(3, 3); ++s1)
+            {
+                if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != squareOf(1, 0)))
+                    continue;
+                for (int s2 = 0; s2 < 64; ++s2)
+                {
+                    if ((Attacks::king(s1) | squareBit(s1)) & squareBit(s2))
+                        continue;
+                    if (offDiagonal(s1) == 0 && offDiagonal(s2) > 0)
+                        continue;
+                    if (offDiagonal(s1) == 0 && offDiagonal(s2) == 0)
+                        bothOnDiagonal.emplace_back(idx, s2);
+                    else
+                        mapKK[idx][s2] = code++;
+                }
+            }
+        }
+        for (const auto& [idx, s2] : bothOnDiagonal)
+            mapKK[idx][s2] = code++;
+
+        // ведущая пешка: чем дальше от края и от второй горизонтали, тем меньше полей у остальных
+        int available = 47;
+        for (int count = 1; count <= 5; ++count)
+        {
+            for (int file = 0; file < 4; ++file)
+            {
+                uint64_t idx = 0;
+                for (int rank = 1; rank <= 6; ++rank)
+                {
+                    int sq = squareOf(file, rank);
+                    if (count == 1)
+                    {
+                        mapPawns[sq] = available--;
+                        mapPawns[sq ^ 7] = available--;
+                    }
+                    leadPawnIdx[count][sq] = idx;
+                    idx += binomial[count - 1][mapPawns[sq]];
+                }
+                leadPawnsSize[count][file] = idx;
+            }
+        }
+    }
+};
+
+static const SyzygyMaps& maps()
+{
+    static const SyzygyMaps instance;
+    return instance;
+}
+
+bool SyzygyTable::init(const std::string& directory, const std::string& tableName)
+{
+    size_t v = tableName.find('v');
+    if (v == std::string::npos || tableName[0] != 'K' || v + 1 >= tableName.size() || tableName[v + 1] != 'K')
+        return false;
+
+    name = tableName;
+    pieceCount = 2;
+    for (int s = 0; s < 2; ++s)
+    {
+        material[s].clear();
+        for (char c : s == 0 ? tableName.substr(1, v - 1) : tableName.substr(v + 2))
+        {
+            const char* p = std::strchr(SYZYGY_LETTERS, c);
+            if (!p || !c || c == 'K')
+                return false;
+            material[s].push_back(static_cast<int>(p - SYZYGY_LETTERS));
+        }
+        pieceCount += static_cast<int>(material[s].size());
+    }
+    if (pieceCount > MAX_PIECES)
+        return false;
+
+    auto count = [&](int side, int type) { return std::count(material[side].begin(), material[side].end(), type); };
+    pawns = count(SIDE_WHITE, PAWN) + count(SIDE_BLACK, PAWN) > 0;
+    bothSidesPawns = count(SIDE_WHITE, PAWN) > 0 && count(SIDE_BLACK, PAWN) > 0;
+    uniquePieces = false;
+    symmetric = true;
+    for (int type = PAWN; type < KING; ++type)
+    {
+        uniquePieces |= count(SIDE_WHITE, type) == 1 || count(SIDE_BLACK, type) == 1;
+        symmetric &= count(SIDE_WHITE, type) == count(SIDE_BLACK, type);
+    }
+
+    wdl.path = directory + "/" + name + ".rtbw";
+    dtz.path = directory + "/" + name + ".rtbz";
+    wdl.exists = static_cast<bool>(std::ifstream(wdl.path, std::ios::binary));
+    dtz.exists = static_cast<bool>(std::ifstream(dtz.path, std::ios::binary));
+    return wdl.exists;
+}
+
+bool SyzygyTable::load(File& file, bool isDtz)
+{
+    if (file.ready.load(std::memory_order_acquire))
+        return true;
+    if (!file.exists || file.failed.load(std::memory_order_acquire))
+        return false;
+
+    // первое обращение: отображаем и разбираем файл, остальные потоки ждут только здесь
+    std::lock_guard<std::mutex> lock(file.loadMutex);
+    if (file.ready.load(std::memory_order_relaxed))
+        return true;
+    if (file.failed.load(std::memory_order_relaxed))
+        return false;
+
+    if (!file.file.openReadOnly(file.path) || !parse(file, isDtz))
+    {
+        std::cerr << "Syzygy file is damaged: " << file.path << std::endl;
+        file.file.close();
+        file.failed.store(true, std::memory_order_release);
+        return false;
+    }
+    file.ready.store(true, std::memory_order_release);
+    return true;
+}
+
+bool SyzygyTable::parse(File& file, bool isDtz)
+{
+    const uint8_t* base = static_cast<const MappedFile&>(file.file).data();
+    size_t size = file.file.size();
+    if (size < 5 || size % 64 != 16 || std::memcmp(base, isDtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0)
+        return false;
+    const uint8_t* end = base + size;
+    const uint8_t* data = base + 4;
+
+    // флаги файла: 1 - у сторон разные данные, 2 - есть пешки
+    if (((*data & 1) != 0) == symmetric || ((*data & 2) != 0) != pawns)
+        return false;
+    ++data;
+
+    int sides = !isDtz && !symmetric ? 2 : 1;
+    int files = pawns ? 4 : 1;
+    for (int f = 0; f < files; ++f)
+    {
+        // порядок групп в индексе: младшие 4 бита - для белых, старшие - для чёрных
+        int order[2][2] = { { data[0] & 0xF, bothSidesPawns ? data[1] & 0xF : 0xF },
+                            { data[0] >> 4, bothSidesPawns ? data[1] >> 4 : 0xF } };
+        data += bothSidesPawns ? 2 : 1;
+        if (data + pieceCount > end)
+            return false;
+
+        for (int k = 0; k < pieceCount; ++k, ++data)
+        {
+            for (int i = 0; i < sides; ++i)
+                file.pairs[i][f].pieces[k] = i ? *data >> 4 : *data & 0xF;
+        }
+        for (int i = 0; i < sides; ++i)
+            setGroups(file.pairs[i][f], order[i], f);
+    }
+    data += (data - base) & 1;
+
+    for (int f = 0; f < files; ++f)
+    {
+        for (int i = 0; i < sides && data; ++i)
+            data = setSizes(file.pairs[i][f], data, end);
+    }
+    if (data && isDtz)
+        data = setDtzMap(file, base, data, end);
+    if (!data)
+        return false;
+
+    for (int f = 0; f < files; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            file.pairs[i][f].sparseIndex = data;
+            data += file.pairs[i][f].sparseCount * 6;
+        }
+    }
+    for (int f = 0; f < files; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            file.pairs[i][f].blockLength = data;
+            data += file.pairs[i][f].blockLengthCount * 2;
+        }
+    }
+    for (int f = 0; f < files; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            // блоки начинаются с границы 64 байт; у таблицы из одного значения блоков нет
+            if (file.pairs[i][f].blockCount)
+                data = base + ((data - base + 63) & ~static_cast<ptrdiff_t>(63));
+            file.pairs[i][f].data = data;
+            data += file.pairs[i][f].blockCount * file.pairs[i][f].blockSize;
+        }
+    }
+    return data <= end;
+}
+
+void SyzygyTable::setGroups(Pairs& d, const int* order, int tbFile) const
+{
+    // группы одинаковых фигур; первая - три уникальные фигуры, два короля или ведущие пешки
+    int n = 0;
+    int firstLen = pawns ? 0 : uniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < pieceCount; ++i)
+    {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+            d.groupLen[n]++;
+        else
+            d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    // множители групп в порядке из файла; пешки второй стороны стоят только на 48 полях
+    const SyzygyMaps& m = maps();
+    int next = bothSidesPawns ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (bothSidesPawns ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k)
+    {
+        if (k == order[0])
+        {
+            d.groupIdx[0] = idx;
+            idx *= pawns ? m.leadPawnsSize[d.groupLen[0]][tbFile] : uniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d.groupIdx[1] = idx;
+            idx *= m.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        }
+        else
+        {
+            d.groupIdx[next] = idx;
+            idx *= m.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+// Длина символа в значениях: лист дерева пар - одно значение, иначе сумма двух половин
+static int setSymLen(std::vector<uint8_t>& symLen, std::vector<bool>& visited, const uint8_t* btree, int sym)
+{
+    visited[sym] = true;
+    const uint8_t* lr = btree + 3 * sym;
+    int right = (lr[2] << 4) | (lr[1] >> 4);
+    if (right == 0xFFF)
+        return 0;
+
+    int left = ((lr[1] & 0xF) << 8) | lr[0];
+    if (left >= static_cast<int>(symLen.size()) || right >= static_cast<int>(symLen.size()))
+        return 0;
+    if (!visited[left])
+        symLen[left] = static_cast<uint8_t>(setSymLen(symLen, visited, btree, left));
+    if (!visited[right])
+        symLen[right] = static_cast<uint8_t>(setSymLen(symLen, visited, btree, right));
+    return symLen[left] + symLen[right] + 1;
+}
+
+const uint8_t* SyzygyTable::setSizes(Pairs& d, const uint8_t* data, const uint8_t* end) const
+{
+    if (data + 2 > end)
+        return nullptr;
+    d.flags = *data++;
+    if (d.flags & FLAG_SINGLE_VALUE)
+    {
+        // вся таблица - одно значение
+        d.blockCount = 0;
+        d.blockLengthCount = 0;
+        d.span = 0;
+        d.sparseCount = 0;
+        d.minSymLen = *data++;
+        return data;
+    }
+
+    if (data + 10 > end)
+        return nullptr;
+    uint64_t tbSize = d.groupIdx[std::find(d.groupLen, d.groupLen + MAX_PIECES, 0) - d.groupLen];
+    d.blockSize = 1ULL << *data++;
+    d.span = 1ULL << *data++;
+    d.sparseCount = (tbSize + d.span - 1) / d.span;
+    int padding = *data++;
+    d.blockCount = readLe32(data);
+    data += 4;
+    d.blockLengthCount = d.blockCount + static_cast<uint64_t>(padding);
+    int maxSymLen = *data++;
+    d.minSymLen = *data++;
+    if (d.minSymLen < 1 || maxSymLen < d.minSymLen || maxSymLen > 32)
+        return nullptr;
+    if (data + 2 * (maxSymLen - d.minSymLen + 1) + 2 > end)
+        return nullptr;
+
+    // канонический код Хаффмана: base64[i] - наименьший код длины minSymLen + i, выровненный влево
+    d.lowestSym = data;
+    d.base64.assign(maxSymLen - d.minSymLen + 1, 0);
+    for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; --i)
+        d.base64[i] = (d.base64[i + 1] + readLe16(d.lowestSym + 2 * i) - readLe16(d.lowestSym + 2 * (i + 1))) / 2;
+    for (size_t i = 0; i < d.base64.size(); ++i)
+        d.base64[i] <<= 64 - i - d.minSymLen;
+    data += d.base64.size() * 2;
+
+    if (data + 2 > end)
+        return nullptr;
+    d.symLen.assign(readLe16(data), 0);
+    data += 2;
+    d.btree = data;
+    if (data + d.symLen.size() * 3 > end)
+        return nullptr;
+
+    std::vector<bool> visited(d.symLen.size());
+    for (size_t sym = 0; sym < d.symLen.size(); ++sym)
+    {
+        if (!visited[sym])
+            d.symLen[sym] = static_cast<uint8_t>(setSymLen(d.symLen, visited, d.btree, static_cast<int>(sym)));
+    }
+    return data + d.symLen.size() * 3 + (d.symLen.size() & 1);
+}
+
+const uint8_t* SyzygyTable::setDtzMap(File& file, const uint8_t* base, const uint8_t* data, const uint8_t* end) const
+{
+    // значения DTZ в файле - номера в списках для выигрыша, проигрыша и их вариантов за правилом 50 ходов
+    file.map = data;
+    for (int f = 0; f < (pawns ? 4 : 1); ++f)
+    {
+        Pairs& d = file.pairs[0][f];
+        if (!(d.flags & FLAG_MAPPED))
+            continue;
+        if (d.flags & FLAG_WIDE)
+        {
+            data += (data - base) & 1;
+            for (int i = 0; i < 4; ++i)
+            {
+                if (data + 2 > end)
+                    return nullptr;
+                d.mapIdx[i] = static_cast<uint16_t>((data - file.map) / 2 + 1);
+                data += 2 * readLe16(data) + 2;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                if (data >= end)
+                    return nullptr;
+                d.mapIdx[i] = static_cast<uint16_t>(data - file.map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    data += (data - base) & 1;
+    return data <= end ? data : nullptr;
+}
+
+int SyzygyTable::decompress(const Pairs& d, uint64_t idx) const
+{
+    if (d.flags & FLAG_SINGLE_VALUE)
+        return d.minSymLen;
+
+    // опорная точка каждые span позиций: блок и смещение от середины отрезка
+    const uint8_t* sparse = d.sparseIndex + 6 * (idx / d.span);
+    uint32_t block = readLe32(sparse);
+    int64_t offset = readLe16(sparse + 4);
+    offset += static_cast<int64_t>(idx % d.span) - static_cast<int64_t>(d.span / 2);
+    while (offset < 0)
+        offset += readLe16(d.blockLength + 2 * --block) + 1;
+    while (offset > readLe16(d.blockLength + 2 * block))
+        offset -= readLe16(d.blockLength + 2 * block++) + 1;
+
+    // символы блока читаются с начала, пока не наберётся offset значений
+    const uint8_t* ptr = d.data + block * d.blockSize;
+    uint64_t buf64 = (static_cast<uint64_t>(readBe32(ptr)) << 32) | readBe32(ptr + 4);
+    ptr += 8;
+    int buf64Size = 64;
+    int sym;
+    while (true)
+    {
+        size_t len = 0;
+        while (len + 1 < d.base64.size() && buf64 < d.base64[len])
+            ++len;
+        sym = static_cast<int>((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+        sym += readLe16(d.lowestSym + 2 * len);
+        if (offset < d.symLen[sym] + 1)
+            break;
+        offset -= d.symLen[sym] + 1;
+        len += d.minSymLen;
+        buf64 <<= len;
+        buf64Size -= static_cast<int>(len);
+        if (buf64Size <= 32)
+        {
+            buf64Size += 32;
+            buf64 |= static_cast<uint64_t>(readBe32(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // спуск по дереву пар до одиночного значения
+    while (d.symLen[sym])
+    {
+        const uint8_t* lr = d.btree + 3 * sym;
+        int left = ((lr[1] & 0xF) << 8) | lr[0];
+        if (offset < d.symLen[left] + 1)
+            sym = left;
+        else
+        {
+            offset -= d.symLen[left] + 1;
+            sym = (lr[2] << 4) | (lr[1] >> 4);
+        }
+    }
+    const uint8_t* lr = d.btree + 3 * sym;
+    return ((lr[1] & 0xF) << 8) | lr[0];
+}
+
+bool SyzygyTable::encode(const File& file, bool isDtz, const FastBoard& pos, const Pairs*& pairs, uint64_t& idx) const
+{
+    const SyzygyMaps& m = maps();
+
+    // файл записан для белых из первой половины имени; иначе меняем цвета и отражаем доску.
+    // При равном материале хранится только ход белых
+    bool flip;
+    if (symmetric)
+        flip = pos.sideToMove() == SIDE_BLACK;
+    else
+    {
+        flip = false;
+        for (int type = PAWN; type < KING; ++type)
+        {
+            auto count = std::count(material[SIDE_WHITE].begin(), material[SIDE_WHITE].end(), type);
+            flip |= popCount(pos.pieces(SIDE_WHITE, type)) != count;
+        }
+    }
+    int flipSquares = flip ? 56 : 0;
+    int flipColor = flip ? 8 : 0;
+    int stm = pos.sideToMove() ^ (flip ? 1 : 0);
+
+    int squares[MAX_PIECES];
+    int codes[MAX_PIECES];
+    int size = 0;
+    int leadPawnsCount = 0;
+    int tbFile = 0;
+    Bitboard leadPawns = 0;
+    if (pawns)
+    {
+        // ведущие пешки - цвета первой фигуры в файле; из них берётся самая дальняя от края
+        int leadCode = file.pairs[0][0].pieces[0] ^ flipColor;
+        if ((leadCode & 7) != PAWN + 1)
+            return false;
+        leadPawns = pos.pieces(leadCode >> 3, PAWN);
+        for (Bitboard b = leadPawns; b;)
+            squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnsCount = size;
+        auto byMap = [&](int a, int b) { return m.mapPawns[a] < m.mapPawns[b]; };
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, byMap));
+        tbFile = std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    pairs = nullptr;
+    if (isDtz && (file.pairs[0][tbFile].flags & FLAG_STM) != stm && !(symmetric && !pawns))
+        return true;
+
+    for (Bitboard b = pos.occupied() & ~leadPawns; b;)
+    {
+        int sq = popLsb(b);
+        int piece = pos.pieceOn(sq);
+        squares[size] = sq ^ flipSquares;
+        codes[size++] = ((FastBoard::pieceType(piece) + 1) | (FastBoard::pieceSide(piece) << 3)) ^ flipColor;
+    }
+    if (size != pieceCount)
+        return false;
+
+    // фигуры в порядке из файла
+    const Pairs& d = file.pairs[isDtz ? 0 : stm][tbFile];
+    for (int i = leadPawnsCount; i < size - 1; ++i)
+    {
+        for (int j = i + 1; j < size; ++j)
+        {
+            if (d.pieces[i] == codes[j])
+            {
+                std::swap(codes[i], codes[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    if (fileOf(squares[0]) > 3)
+    {
+        for (int i = 0; i < size; ++i)
+            squares[i] ^= 7;
+    }
+
+    if (pawns)
+    {
+        idx = m.leadPawnIdx[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount, [&](int a, int b) { return m.mapPawns[a] < m.mapPawns[b]; });
+        for (int i = 1; i < leadPawnsCount; ++i)
+            idx += m.binomial[i][m.mapPawns[squares[i]]];
+    }
+    else
+    {
+        if (rankOf(squares[0]) > 3)
+        {
+            for (int i = 0; i < size; ++i)
+                squares[i] ^= 56;
+        }
+        // первая фигура вне диагонали a1-h8 должна оказаться под ней
+        for (int i = 0; i < d.groupLen[0]; ++i)
+        {
+            if (!offDiagonal(squares[i]))
+                continue;
+            if (offDiagonal(squares[i]) > 0)
+            {
+                for (int j = i; j < size; ++j)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        if (uniquePieces)
+        {
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0]))
+                idx = (m.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[1]))
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + m.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28 + (rankOf(squares[1]) - adjust1) * 28
+                    + m.mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6 + (rankOf(squares[1]) - adjust1) * 6
+                    + (rankOf(squares[2]) - adjust2);
+        }
+        else
+            idx = m.mapKK[m.mapA1D1D4[squares[0]]][squares[1]];
+    }
+
+    // остальные группы - сочетания полей, не занятых предыдущими группами
+    idx *= d.groupIdx[0];
+    int* groupSq = squares + d.groupLen[0];
+    bool remainingPawns = bothSidesPawns;
+    for (int next = 1; d.groupLen[next]; ++next)
+    {
+        std::stable_sort(groupSq, groupSq + d.groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; ++i)
+        {
+            int adjust = static_cast<int>(std::count_if(squares, groupSq, [&](int s) { return groupSq[i] > s; }));
+            n += m.binomial[i + 1][groupSq[i] - adjust - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        groupSq += d.groupLen[next];
+    }
+    pairs = &d;
+    return true;
+}
+
+bool SyzygyTable::read(File& file, bool isDtz, const FastBoard& pos, int wdlValue, int& value, bool& otherSide)
+{
+    otherSide = false;
+    const Pairs* pairs;
+    uint64_t idx;
+    if (!load(file, isDtz) || !encode(file, isDtz, pos, pairs, idx))
+        return false;
+    if (!pairs)
+    {
+        otherSide = true;
+        return true;
+    }
+
+    const Pairs& d = *pairs;
+    value = decompress(d, idx);
+    if (!isDtz)
+    {
+        value -= 2;
+        return true;
+    }
+
+    // DTZ: номер в списке значений, в ходах или полуходах в зависимости от флагов
+    static const int WDL_MAP[5] = { 1, 3, 0, 2, 0 };
+    if (d.flags & FLAG_MAPPED)
+    {
+        int mapIdx = d.mapIdx[WDL_MAP[wdlValue + 2]] + value;
+        value = d.flags & FLAG_WIDE ? readLe16(file.map + 2 * mapIdx) : file.map[mapIdx];
+    }
+    if ((wdlValue == WIN && !(d.flags & FLAG_WIN_PLIES)) || (wdlValue == LOSS && !(d.flags & FLAG_LOSS_PLIES))
+        || wdlValue == CURSED_WIN || wdlValue == BLESSED_LOSS)
+        value *= 2;
+    value += 1;
+    return true;
+}
+
+bool SyzygyTable::readWdl(const FastBoard& pos, int& value)
+{
+    bool otherSide;
+    return read(wdl, false, pos, 0, value, otherSide);
+}
+
+bool SyzygyTable::readDtz(const FastBoard& pos, int wdlValue, int& value, bool& otherSide)
+{
+    return read(dtz, true, pos, wdlValue, value, otherSide);
+}
\ No newline at end of file
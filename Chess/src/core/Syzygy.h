@@ -0,0 +1,98 @@
+#pragma once
+#include "FastBoard.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Одна таблица Syzygy: .rtbw (выигрыш/ничья/проигрыш с учётом правила 50 ходов) и, если есть, .rtbz
+// (расстояние до взятия или хода пешкой). Позиция переводится в индекс по группам одинаковых фигур:
+// без пешек первая группа приводится в треугольник a1-d1-d4, с пешками ведущая пешка - на вертикали a-d,
+// и у каждой такой вертикали свой блок данных. Значения сжаты рекурсивными парами с каноническим кодом
+// Хаффмана. Файл отображается в память при первом обращении, дальше чтение без блокировок.
+// Взятия в файлах не учтены (там, где лучше взять, записано что угодно), их перебирает Tablebase.
+class SyzygyTable
+{
+public:
+    static constexpr int MAX_PIECES = 7;
+
+    // Результат с точки зрения стороны, которая ходит
+    static constexpr int LOSS = -2;
+    static constexpr int BLESSED_LOSS = -1; // проигрыш, от которого спасает правило 50 ходов
+    static constexpr int DRAW = 0;
+    static constexpr int CURSED_WIN = 1;    // выигрыш, который не успеть за 50 ходов
+    static constexpr int WIN = 2;
+
+    // name - имя файла без расширения, например "KRPvKR"
+    bool init(const std::string& directory, const std::string& name);
+
+    const std::string& getName() const { return name; }
+    int getPieceCount() const { return pieceCount; }
+    // Фигуры белых и чёрных в порядке имени файла (по типам FastBoard, без королей)
+    const std::vector<int>& getMaterial(int side) const { return material[side]; }
+    bool hasDtz() const { return dtz.exists; }
+
+    // Значение из .rtbw для позиции этого материала; false - файл не читается
+    bool readWdl(const FastBoard& pos, int& value);
+    // Полуходы до обнуления счётчика из .rtbz; wdlValue - результат позиции с учётом взятий.
+    // otherSide - файл хранит только позиции, где ходит соперник, value не задано
+    bool readDtz(const FastBoard& pos, int wdlValue, int& value, bool& otherSide);
+
+private:
+    // Сжатые данные одной стороны для одной вертикали ведущей пешки
+    struct Pairs
+    {
+        uint8_t flags = 0;
+        int pieces[MAX_PIECES] = {}; // коды Syzygy: тип 1..6, у чёрных +8
+        int groupLen[MAX_PIECES + 1] = {};
+        uint64_t groupIdx[MAX_PIECES + 1] = {};
+        uint64_t blockSize = 0;
+        uint64_t span = 0;
+        uint32_t blockCount = 0;
+        uint64_t sparseCount = 0;
+        uint64_t blockLengthCount = 0;
+        int minSymLen = 0;
+        const uint8_t* lowestSym = nullptr;
+        std::vector<uint64_t> base64;
+        std::vector<uint8_t> symLen;
+        const uint8_t* btree = nullptr;
+        const uint8_t* sparseIndex = nullptr;
+        const uint8_t* blockLength = nullptr;
+        const uint8_t* data = nullptr;
+        uint16_t mapIdx[4] = {};
+    };
+
+    struct File
+    {
+        std::string path;
+        bool exists = false;
+        MappedFile file;
+        std::mutex loadMutex;
+        std::atomic<bool> ready { false };
+        std::atomic<bool> failed { false };
+        Pairs pairs[2][4];
+        const uint8_t* map = nullptr;
+    };
+
+    std::string name;
+    std::vector<int> material[2];
+    int pieceCount = 0;
+    bool pawns = false;
+    bool uniquePieces = false;
+    bool bothSidesPawns = false;
+    bool symmetric = false;
+    File wdl;
+    File dtz;
+
+    bool load(File& file, bool isDtz);
+    bool parse(File& file, bool isDtz);
+    void setGroups(Pairs& d, const int* order, int tbFile) const;
+    const uint8_t* setSizes(Pairs& d, const uint8_t* data, const uint8_t* end) const;
+    const uint8_t* setDtzMap(File& file, const uint8_t* base, const uint8_t* data, const uint8_t* end) const;
+    // Индекс позиции в файле; pairs = nullptr - .rtbz хранит только ход соперника
+    bool encode(const File& file, bool isDtz, const FastBoard& pos, const Pairs*& pairs, uint64_t& idx) const;
+    int decompress(const Pairs& d, uint64_t idx) const;
+    bool read(File& file, bool isDtz, const FastBoard& pos, int wdlValue, int& value, bool& otherSide);
+};
\ No newline at end of file
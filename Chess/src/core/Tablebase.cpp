@@ -0,0 +1,569 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static const char PIECE_LETTERS[] = "PNBRQK";
+
+// Треугольник a1-d1-d4: сюда симметриями доски переводится белый король в таблицах без пешек
+static const int TRIANGLE_SQUARES[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+static int triangleIndex(int sq)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        if (TRIANGLE_SQUARES[i] == sq)
+            return i;
+    }
+    return -1;
+}
+
+// Восемь симметрий доски: отражения по вертикали, горизонтали и диагонали a1-h8
+static int transformSquare(int t, int sq)
+{
+    int x = fileOf(sq), y = rankOf(sq);
+    if (t & 1)
+        x = 7 - x;
+    if (t & 2)
+        y = 7 - y;
+    if (t & 4)
+        std::swap(x, y);
+    return squareOf(x, y);
+}
+
+static int pieceFromLetter(char c)
+{
+    const char* p = std::strchr(PIECE_LETTERS, c);
+    return (p && c) ? static_cast<int>(p - PIECE_LETTERS) : -1;
+}
+
+bool TbLayout::init(const std::string& tableName)
+{
+    size_t v = tableName.find('v');
+    if (v == std::string::npos || tableName[0] != 'K' || v + 1 >= tableName.size() || tableName[v + 1] != 'K')
+        return false;
+
+    std::string white = tableName.substr(1, v - 1);
+    std::string black = tableName.substr(v + 2);
+    if (white.size() + black.size() + 2 > MAX_PIECES)
+        return false;
+
+    name = tableName;
+    count = 0;
+    pawns = false;
+    sides[count] = SIDE_WHITE;
+    types[count++] = KING;
+    sides[count] = SIDE_BLACK;
+    types[count++] = KING;
+    for (int s = 0; s < 2; ++s)
+    {
+        for (char c : (s == 0 ? white : black))
+        {
+            int type = pieceFromLetter(c);
+            if (type < 0 || type == KING)
+                return false;
+            sides[count] = s;
+            types[count++] = type;
+            pawns |= type == PAWN;
+        }
+    }
+
+    kingPairCount = (pawns ? 32 : 10) * 64;
+    entries = kingPairCount * 2;
+    for (int i = 2; i < count; ++i)
+        entries *= types[i] == PAWN ? 48 : 64;
+    return true;
+}
+
+uint64_t TbLayout::rawIndex(const int* squares, int stm) const
+{
+    int wk = squares[0];
+    int kingIdx = pawns ? (fileOf(wk) <= 3 ? rankOf(wk) * 4 + fileOf(wk) : -1) : triangleIndex(wk);
+    if (kingIdx < 0)
+        return NO_INDEX;
+
+    uint64_t idx = static_cast<uint64_t>(kingIdx) * 64 + squares[1];
+    for (int i = 2; i < count; ++i)
+    {
+        if (types[i] == PAWN)
+        {
+            if (rankOf(squares[i]) == 0 || rankOf(squares[i]) == 7)
+                return NO_INDEX;
+            idx = idx * 48 + (squares[i] - 8);
+        }
+        else
+            idx = idx * 64 + squares[i];
+    }
+    return idx * 2 + stm;
+}
+
+uint64_t TbLayout::index(const int* squares, int stm) const
+{
+    Bitboard used = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (used & squareBit(squares[i]))
+            return NO_INDEX;
+        used |= squareBit(squares[i]);
+    }
+
+    // пешки ходят только вперёд, поэтому для них допустимо лишь отражение слева направо
+    uint64_t best = NO_INDEX;
+    int transforms = pawns ? 2 : 8;
+    for (int t = 0; t < transforms; ++t)
+    {
+        int moved[MAX_PIECES];
+        for (int i = 0; i < count; ++i)
+            moved[i] = transformSquare(t, squares[i]);
+        // одинаковые фигуры неразличимы: упорядочиваем их поля
+        for (int i = 2; i + 1 < count; ++i)
+        {
+            if (sides[i] == sides[i + 1] && types[i] == types[i + 1] && moved[i] > moved[i + 1])
+                std::swap(moved[i], moved[i + 1]);
+        }
+        best = std::min(best, rawIndex(moved, stm));
+    }
+    return best;
+}
+
+void TbLayout::decode(uint64_t idx, int* squares, int& stm) const
+{
+    stm = static_cast<int>(idx % 2);
+    idx /= 2;
+    for (int i = count - 1; i >= 2; --i)
+    {
+        if (types[i] == PAWN)
+        {
+            squares[i] = static_cast<int>(idx % 48) + 8;
+            idx /= 48;
+        }
+        else
+        {
+            squares[i] = static_cast<int>(idx % 64);
+            idx /= 64;
+        }
+    }
+    squares[1] = static_cast<int>(idx % 64);
+    idx /= 64;
+    squares[0] = pawns ? squareOf(static_cast<int>(idx % 4), static_cast<int>(idx / 4)) : TRIANGLE_SQUARES[idx];
+}
+
+// Сторона слабее: меньше фигур, при равенстве - младшие фигуры
+static bool isWeaker(const std::vector<int>& a, const std::vector<int>& b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size();
+    return a < b;
+}
+
+static std::string sideLetters(const std::vector<int>& types)
+{
+    std::string res = "K";
+    for (int type : types)
+        res += PIECE_LETTERS[type];
+    return res;
+}
+
+std::string TbLayout::materialName(const FastBoard& pos, bool& flipped)
+{
+    std::vector<int> material[2];
+    for (int s = 0; s < 2; ++s)
+    {
+        for (int type = QUEEN; type >= PAWN; --type)
+        {
+            for (int n = popCount(pos.pieces(s, type)); n > 0; --n)
+                material[s].push_back(type);
+        }
+    }
+    return materialName(material[SIDE_WHITE], material[SIDE_BLACK], flipped);
+}
+
+std::string TbLayout::materialName(std::vector<int> white, std::vector<int> black, bool& flipped)
+{
+    std::sort(white.rbegin(), white.rend());
+    std::sort(black.rbegin(), black.rend());
+    flipped = isWeaker(white, black);
+    const auto& strong = flipped ? black : white;
+    const auto& weak = flipped ? white : black;
+    return sideLetters(strong) + "v" + sideLetters(weak);
+}
+
+std::vector<std::string> TbLayout::allNames(int maxPieces)
+{
+    // наборы фигур одной стороны (без короля), по убыванию ценности
+    std::vector<std::vector<int>> sets = { {} };
+    for (int a = QUEEN; a >= PAWN; --a)
+    {
+        sets.push_back({ a });
+        for (int b = a; b >= PAWN; --b)
+            sets.push_back({ a, b });
+    }
+
+    struct Item
+    {
+        std::string name;
+        int pieces;
+        int pawns;
+    };
+    std::vector<Item> items;
+    for (const auto& white : sets)
+    {
+        for (const auto& black : sets)
+        {
+            int pieces = static_cast<int>(white.size() + black.size()) + 2;
+            if (pieces == 2 || pieces > std::min(maxPieces, MAX_PIECES) || isWeaker(white, black))
+                continue;
+            int pawnCount = static_cast<int>(std::count(white.begin(), white.end(), PAWN) + std::count(black.begin(), black.end(), PAWN));
+            items.push_back({ sideLetters(white) + "v" + sideLetters(black), pieces, pawnCount });
+        }
+    }
+
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.pieces != b.pieces ? a.pieces < b.pieces : a.pawns < b.pawns;
+    });
+
+    std::vector<std::string> names;
+    for (const auto& item : items)
+        names.push_back(item.name);
+    return names;
+}
+
+std::string Tablebase::fileName(const std::string& directory, const std::string& name)
+{
+    return directory + "/" + name + ".ctb";
+}
+
+std::optional<TbProbe> Tablebase::decodeValue(uint8_t value)
+{
+    if (value == DRAW)
+        return TbProbe { 0, 0 };
+    if (value < LOSS_BASE)
+        return TbProbe { 1, value };
+    if (value == INVALID)
+        return std::nullopt;
+    return TbProbe { -1, value - LOSS_BASE };
+}
+
+Tablebase::Tablebase(const std::string& directory)
+{
+    for (const auto& name : TbLayout::allNames(TbLayout::MAX_PIECES))
+    {
+        auto table = std::make_unique<Table>();
+        table->path = fileName(directory, name);
+        if (!table->layout.init(name))
+            continue;
+        if (!std::ifstream(table->path, std::ios::binary))
+            continue;
+
+        maxPieces = std::max(maxPieces, table->layout.getPieceCount());
+        tables[name] = std::move(table);
+    }
+
+    // Syzygy регистрируются и при наличии .ctb: после взятия перебор по ним ищет таблицу меньшего материала
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() != ".rtbw")
+            continue;
+        auto table = std::make_unique<SyzygyTable>();
+        if (!table->init(directory, entry.path().stem().string()))
+            continue;
+
+        bool flipped;
+        std::string name = TbLayout::materialName(table->getMaterial(SIDE_WHITE), table->getMaterial(SIDE_BLACK), flipped);
+        maxPieces = std::max(maxPieces, table->getPieceCount());
+        syzygyTables[name] = std::move(table);
+    }
+}
+
+const uint8_t* Tablebase::load(Table& table)
+{
+    const uint8_t* values = table.values.load(std::memory_order_acquire);
+    if (values || table.failed.load(std::memory_order_acquire))
+        return values;
+
+    // первое обращение: отображаем файл, остальные потоки ждут только здесь
+    std::lock_guard<std::mutex> lock(table.loadMutex);
+    values = table.values.load(std::memory_order_relaxed);
+    if (values || table.failed.load(std::memory_order_relaxed))
+        return values;
+
+    Header header;
+    bool ok = table.file.openReadOnly(table.path) && table.file.size() >= sizeof(Header);
+    if (ok)
+    {
+        const uint8_t* data = static_cast<const MappedFile&>(table.file).data();
+        std::memcpy(&header, data, sizeof(Header));
+        ok = header.magic == MAGIC && header.entries == table.layout.size()
+            && table.file.size() >= sizeof(Header) + header.entries
+            && std::strncmp(header.name, table.layout.getName().c_str(), sizeof(header.name)) == 0;
+        if (ok)
+            values = data + sizeof(Header);
+    }
+
+    if (!ok)
+    {
+        std::cerr << "Tablebase file is damaged: " << table.path << std::endl;
+        table.file.close();
+        table.failed.store(true, std::memory_order_release);
+        return nullptr;
+    }
+    table.values.store(values, std::memory_order_release);
+    return values;
+}
+
+std::optional<TbProbe> Tablebase::probe(const FastBoard& pos, bool withDtz) const
+{
+    int pieces = pos.pieceCount();
+    if ((pieces > maxPieces && pieces > 2) || pos.getCastlingRights())
+        return std::nullopt;
+    if (pieces == 2)
+        return TbProbe { 0, 0 };
+
+    // .ctb строятся без права взятия на проходе, Syzygy перебирает такое взятие сама
+    int ep = pos.getEpSquare();
+    bool epCapture = ep >= 0 && (Attacks::pawn(pos.sideToMove() ^ 1, ep) & pos.pieces(pos.sideToMove(), PAWN));
+
+    bool flipped;
+    std::string name = TbLayout::materialName(pos, flipped);
+    auto it = tables.find(name);
+    if (it == tables.end() || epCapture)
+    {
+        if (syzygyTables.count(name))
+            return probeSyzygy(pos, withDtz);
+        return std::nullopt;
+    }
+    Table& table = *it->second;
+    const uint8_t* values = load(table);
+    if (!values)
+        return std::nullopt;
+
+    int squares[TbLayout::MAX_PIECES];
+    Bitboard used = 0;
+    for (int i = 0; i < table.layout.getPieceCount(); ++i)
+    {
+        int side = table.layout.getPieceSide(i) ^ (flipped ? 1 : 0);
+        Bitboard bb = pos.pieces(side, table.layout.getPieceType(i)) & ~used;
+        int sq = lsb(bb);
+        used |= squareBit(sq);
+        squares[i] = flipped ? sq ^ 56 : sq;
+    }
+
+    uint64_t idx = table.layout.index(squares, pos.sideToMove() ^ (flipped ? 1 : 0));
+    if (idx == TbLayout::NO_INDEX)
+        return std::nullopt;
+    return decodeValue(values[idx]);
+}
+
+std::optional<FastMove> Tablebase::probeRoot(const FastBoard& root) const
+{
+    FastBoard pos = root;
+    MoveList list;
+    pos.generateMoves(list);
+
+    std::optional<FastMove> best;
+    int bestScore = 0;
+    for (FastMove m : list)
+    {
+        bool zeroing = pos.isCapture(m) || FastBoard::pieceType(pos.pieceOn(moveFrom(m))) == PAWN;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        auto result = probe(pos, true);
+        pos.unmakeMove(m, undo);
+        if (!result)
+            return std::nullopt;
+
+        // оценка для нас: выигрыш быстрее лучше, проигрыш дольше лучше.
+        // Без мата в таблице (Syzygy) считаем полуходы до взятия или хода пешкой, такой ход - сразу
+        int distance = result->dtm >= 0 ? result->dtm : zeroing ? 1 : result->dtz + 1;
+        int score = result->wdl < 0 ? 10000 - distance : result->wdl > 0 ? -10000 + distance : 0;
+        if (!best || score > bestScore)
+        {
+            best = m;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// DTZ хода, который сам обнуляет счётчик: выигрыш за один полуход, за правилом 50 ходов - за 101
+static int dtzBeforeZeroing(int wdl)
+{
+    switch (wdl)
+    {
+    case SyzygyTable::WIN:
+        return 1;
+    case SyzygyTable::CURSED_WIN:
+        return 101;
+    case SyzygyTable::BLESSED_LOSS:
+        return -101;
+    case SyzygyTable::LOSS:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+static int sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+static bool isZeroing(const FastBoard& pos, FastMove m)
+{
+    return pos.isCapture(m) || FastBoard::pieceType(pos.pieceOn(moveFrom(m))) == PAWN;
+}
+
+std::optional<TbProbe> Tablebase::probeSyzygy(const FastBoard& root, bool withDtz) const
+{
+    FastBoard pos = root;
+    MoveList list;
+    pos.generateMoves(list);
+    // мат и пат известны без таблиц
+    if (list.size == 0)
+        return TbProbe { pos.inCheck() ? -1 : 0, 0 };
+
+    bool zeroingBest;
+    auto wdl = syzygyWdl(pos, false, zeroingBest);
+    if (!wdl)
+        return std::nullopt;
+
+    TbProbe result { *wdl == SyzygyTable::WIN ? 1 : *wdl == SyzygyTable::LOSS ? -1 : 0, -1 };
+    if (withDtz && result.wdl != 0)
+    {
+        if (auto dtz = syzygyDtz(pos))
+            result.dtz = std::abs(*dtz);
+    }
+    return result;
+}
+
+std::optional<int> Tablebase::syzygyTableWdl(const FastBoard& pos) const
+{
+    if (pos.pieceCount() == 2)
+        return SyzygyTable::DRAW;
+
+    bool flipped;
+    auto it = syzygyTables.find(TbLayout::materialName(pos, flipped));
+    int value;
+    if (it == syzygyTables.end() || !it->second->readWdl(pos, value))
+        return std::nullopt;
+    return value;
+}
+
+std::optional<int> Tablebase::syzygyWdl(FastBoard& pos, bool checkZeroing, bool& zeroingBest) const
+{
+    zeroingBest = false;
+    MoveList list;
+    pos.generateMoves(list);
+
+    int best = SyzygyTable::LOSS;
+    int searched = 0;
+    for (FastMove m : list)
+    {
+        if (!pos.isCapture(m) && (!checkZeroing || !isZeroing(pos, m)))
+            continue;
+
+        ++searched;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        bool unused;
+        auto value = syzygyWdl(pos, false, unused);
+        pos.unmakeMove(m, undo);
+        if (!value)
+            return std::nullopt;
+
+        if (-*value > best)
+        {
+            best = -*value;
+            if (best >= SyzygyTable::WIN)
+            {
+                zeroingBest = true;
+                return best;
+            }
+        }
+    }
+
+    // если перебраны все ходы, таблица не нужна: там может быть записано что угодно
+    bool noMoreMoves = searched > 0 && searched == list.size;
+    int value = best;
+    if (!noMoreMoves)
+    {
+        auto stored = syzygyTableWdl(pos);
+        if (!stored)
+            return std::nullopt;
+        value = *stored;
+    }
+
+    if (best >= value)
+    {
+        zeroingBest = best > SyzygyTable::DRAW || noMoreMoves;
+        return best;
+    }
+    return value;
+}
+
+std::optional<int> Tablebase::syzygyDtz(FastBoard& pos) const
+{
+    bool zeroingBest;
+    auto wdl = syzygyWdl(pos, true, zeroingBest);
+    if (!wdl)
+        return std::nullopt;
+    if (*wdl == SyzygyTable::DRAW)
+        return 0;
+    if (zeroingBest)
+        return dtzBeforeZeroing(*wdl);
+
+    bool flipped;
+    auto it = syzygyTables.find(TbLayout::materialName(pos, flipped));
+    if (it == syzygyTables.end() || !it->second->hasDtz())
+        return std::nullopt;
+
+    int dtz;
+    bool otherSide;
+    if (!it->second->readDtz(pos, *wdl, dtz, otherSide))
+        return std::nullopt;
+    if (!otherSide)
+        return (dtz + (*wdl == SyzygyTable::CURSED_WIN || *wdl == SyzygyTable::BLESSED_LOSS ? 100 : 0)) * sign(*wdl);
+
+    // .rtbz хранит только ход соперника: лучший ответ на ход вперёд
+    MoveList list;
+    pos.generateMoves(list);
+    int minDtz = 0xFFFF;
+    for (FastMove m : list)
+    {
+        bool zeroing = isZeroing(pos, m);
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        std::optional<int> value;
+        if (zeroing)
+        {
+            bool unused;
+            if (auto after = syzygyWdl(pos, false, unused))
+                value = -dtzBeforeZeroing(*after);
+        }
+        else if (auto after = syzygyDtz(pos))
+            value = -*after;
+
+        bool mates = false;
+        if (value && *value == 1 && pos.inCheck())
+        {
+            MoveList replies;
+            pos.generateMoves(replies);
+            mates = replies.size == 0;
+        }
+        pos.unmakeMove(m, undo);
+        if (!value)
+            return std::nullopt;
+
+        int dtz = *value;
+        if (mates)
+            minDtz = 1;
+        if (!zeroing)
+            dtz += sign(dtz);
+        if (dtz < minDtz && sign(dtz) == sign(*wdl))
+            minDtz = dtz;
+    }
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
\ No newline at end of file
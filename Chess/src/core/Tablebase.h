@@ -0,0 +1,126 @@
+#pragma once
+#include "FastBoard.h"
+#include "MappedFile.h"
+#include "Syzygy.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Результат с точки зрения стороны, которая ходит: wdl = 1/0/-1, dtm - полуходов до мата.
+// Syzygy мата не знает: там dtm = -1, dtz - полуходов до взятия или хода пешкой (0, если не запрошен
+// или нет .rtbz), а выигрыш, который не успеть за 50 ходов, считается ничьей
+struct TbProbe
+{
+    int wdl;
+    int dtm;
+    int dtz = 0;
+};
+
+// Раскладка таблицы эндшпиля, например "KQvKR": фигуры по порядку (белый король, чёрный король,
+// остальные белые, остальные чёрные), размер и индекс позиции с учётом симметрий доски.
+class TbLayout
+{
+public:
+    static constexpr uint64_t NO_INDEX = ~0ULL;
+    static constexpr int MAX_PIECES = 4;
+
+    bool init(const std::string& name);
+
+    const std::string& getName() const { return name; }
+    uint64_t size() const { return entries; }
+    uint64_t kingPairs() const { return kingPairCount; }
+    uint64_t entriesPerKingPair() const { return entries / kingPairCount; }
+    int getPieceCount() const { return count; }
+    int getPieceSide(int i) const { return sides[i]; }
+    int getPieceType(int i) const { return types[i]; }
+    bool hasPawns() const { return pawns; }
+
+    // Канонический индекс (минимум по симметриям) или NO_INDEX для невозможной расстановки
+    uint64_t index(const int* squares, int stm) const;
+    // Обратное преобразование без канонизации
+    void decode(uint64_t idx, int* squares, int& stm) const;
+
+    // Имя таблицы для материала позиции; flipped - таблица записана для сильнейшей стороны белыми
+    static std::string materialName(const FastBoard& pos, bool& flipped);
+    // То же по фигурам сторон без королей
+    static std::string materialName(std::vector<int> white, std::vector<int> black, bool& flipped);
+    // Все таблицы до maxPieces фигур в порядке зависимостей (взятия и превращения ведут в уже готовые)
+    static std::vector<std::string> allNames(int maxPieces);
+
+private:
+    std::string name;
+    int count = 0;
+    int sides[MAX_PIECES] = {};
+    int types[MAX_PIECES] = {};
+    bool pawns = false;
+    uint64_t kingPairCount = 0;
+    uint64_t entries = 0;
+
+    uint64_t rawIndex(const int* squares, int stm) const;
+};
+
+// Таблицы WDL+DTM в собственном формате .ctb, созданные tbgen, и таблицы Syzygy (.rtbw/.rtbz) до 7 фигур
+// для материала, которого нет в .ctb. При создании только проверяется, какие файлы есть;
+// файл отображается в память при первом обращении к таблице, дальше probe не берёт блокировок.
+// Безопасен из любого числа потоков (перебор, сервер).
+class Tablebase
+{
+public:
+    static constexpr uint32_t MAGIC = 0x31425443; // "CTB1"
+    static constexpr uint8_t DRAW = 0;
+    static constexpr uint8_t LOSS_BASE = 128;
+    static constexpr uint8_t INVALID = 255;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t pieces;
+        char name[16];
+        uint64_t entries;
+    };
+
+    explicit Tablebase(const std::string& directory = "tb");
+
+    // withDtz - для Syzygy читать ещё и .rtbz; это дороже, перебору хватает wdl
+    std::optional<TbProbe> probe(const FastBoard& pos, bool withDtz = false) const;
+    // Лучший ход по таблицам: самый быстрый мат (для Syzygy - обнуление счётчика 50 ходов),
+    // при проигрыше - самое долгое сопротивление
+    std::optional<FastMove> probeRoot(const FastBoard& pos) const;
+    size_t getTableCount() const { return tables.size() + syzygyTables.size(); }
+    int getMaxPieces() const { return maxPieces; }
+
+    static std::string fileName(const std::string& directory, const std::string& name);
+    static std::optional<TbProbe> decodeValue(uint8_t value);
+
+private:
+    struct Table
+    {
+        TbLayout layout;
+        std::string path;
+        MappedFile file;
+        std::mutex loadMutex;
+        std::atomic<const uint8_t*> values { nullptr };
+        std::atomic<bool> failed { false };
+    };
+
+    // набор таблиц не меняется после конструктора, поэтому поиск в map не требует блокировок
+    std::map<std::string, std::unique_ptr<Table>> tables;
+    std::map<std::string, std::unique_ptr<SyzygyTable>> syzygyTables;
+    int maxPieces = 0;
+
+    static const uint8_t* load(Table& table);
+
+    std::optional<TbProbe> probeSyzygy(const FastBoard& root, bool withDtz) const;
+    // Значение из .rtbw без перебора; KvK - ничья
+    std::optional<int> syzygyTableWdl(const FastBoard& pos) const;
+    // Результат Syzygy -2..2 с перебором взятий (checkZeroing - и ходов пешкой);
+    // zeroingBest - лучший ход обнуляет счётчик, и .rtbz для позиции не нужен
+    std::optional<int> syzygyWdl(FastBoard& pos, bool checkZeroing, bool& zeroingBest) const;
+    // Полуходы до обнуления счётчика со знаком результата, с учётом правила 50 ходов как в .rtbz
+    std::optional<int> syzygyDtz(FastBoard& pos) const;
+};
\ No newline at end of file
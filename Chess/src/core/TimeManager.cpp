@@ -0,0 +1,82 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+void TimeManager::start(const TimeControl& control)
+{
+    startTime = std::chrono::steady_clock::now();
+    optimumMs = maximumMs = softMs = 0;
+    lastBestMove = NO_MOVE;
+    lastScore = 0;
+    stableIterations = 0;
+    instability = 0;
+
+    if (control.moveTimeMs > 0)
+    {
+        optimumMs = maximumMs = softMs = std::max(1, control.moveTimeMs - control.overheadMs);
+        return;
+    }
+    if (control.remainingMs < 0)
+        return;
+
+    // до контроля - сколько осталось; без него - примерная длина оставшейся партии по номеру хода
+    int64_t available = std::max(1, control.remainingMs - control.overheadMs);
+    int movesLeft = control.movesToGo > 0 ? std::min(control.movesToGo, 50) : std::clamp(50 - control.moveNumber / 2, 20, 50);
+    int64_t optimum = available / movesLeft + control.incrementMs * 3 / 4;
+
+    // жёсткий срок - не больше трети остатка (перед контролем - почти весь) и пяти обычных долей
+    int64_t reserve = control.movesToGo == 1 ? available * 4 / 5 : available / 3;
+    maximumMs = std::max<int64_t>(1, std::min(reserve, optimum * 5));
+    optimumMs = std::max<int64_t>(1, std::min(optimum, maximumMs));
+    softMs = optimumMs;
+}
+
+void TimeManager::onIteration(int depth, FastMove bestMove, int score, bool failedLow)
+{
+    bool changed = lastBestMove != NO_MOVE && bestMove != lastBestMove;
+    stableIterations = changed ? 0 : stableIterations + 1;
+    instability = instability * 0.5 + (changed ? 1.0 : 0.0);
+    int drop = lastBestMove != NO_MOVE ? lastScore - score : 0;
+    lastBestMove = bestMove;
+    lastScore = score;
+
+    // фиксированное время на ход не двигаем; на малой глубине оценки и ходы слишком шумные
+    if (optimumMs == maximumMs || depth < 5)
+        return;
+
+    double factor = 1.0 + instability;
+    if (failedLow || drop > 20)
+        factor *= 1.0 + std::clamp(drop, 30, 120) / 120.0;
+    if (stableIterations >= 6)
+        factor *= 0.5;
+    softMs = std::clamp<int64_t>(static_cast<int64_t>(optimumMs * factor), 1, maximumMs);
+}
+
+bool TimeManager::isLimited() const
+{
+    return maximumMs > 0;
+}
+
+bool TimeManager::softExpired() const
+{
+    return softMs > 0 && elapsedMs() >= softMs;
+}
+
+bool TimeManager::hardExpired() const
+{
+    return maximumMs > 0 && elapsedMs() >= maximumMs;
+}
+
+int64_t TimeManager::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int64_t TimeManager::getOptimumMs() const
+{
+    return optimumMs;
+}
+
+int64_t TimeManager::getMaximumMs() const
+{
+    return maximumMs;
+}
\ No newline at end of file
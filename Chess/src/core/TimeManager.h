@@ -0,0 +1,50 @@
+#pragma once
+#include "FastBoard.h"
+#include <chrono>
+#include <cstdint>
+
+// Условия на ход: нули и -1 означают отсутствие ограничения
+struct TimeControl
+{
+    int remainingMs = -1;   // на часах стороны, которая ходит
+    int incrementMs = 0;
+    int movesToGo = 0;      // ходов до контроля; 0 - всё время до конца партии
+    int moveTimeMs = 0;     // фиксированное время на ход
+    int moveNumber = 1;
+    int overheadMs = 30;    // запас на передачу хода и задержки интерфейса
+};
+
+// Распределение времени на ход. Мягкий срок - после него не начинается новая итерация,
+// жёсткий - перебор прерывается. Мягкий срок растёт, когда оценка падает или лучший ход
+// меняется, и сокращается, когда лучший ход много итераций подряд один и тот же.
+// Отсчёт идёт по монотонным часам с момента start().
+class TimeManager
+{
+public:
+    void start(const TimeControl& control);
+
+    // Итерация завершена; failedLow - в ней оценка корня падала ниже окна
+    void onIteration(int depth, FastMove bestMove, int score, bool failedLow);
+
+    bool isLimited() const;
+    bool softExpired() const;
+    bool hardExpired() const;
+
+    int64_t elapsedMs() const;
+    // Время на ход без поправок - для внешнего движка, который сам итерации не сообщает
+    int64_t getOptimumMs() const;
+    int64_t getMaximumMs() const;
+
+private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    TimePoint startTime;
+    int64_t optimumMs = 0;
+    int64_t maximumMs = 0;
+    int64_t softMs = 0;
+
+    FastMove lastBestMove = NO_MOVE;
+    int lastScore = 0;
+    int stableIterations = 0;
+    double instability = 0;
+};
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+// Упаковка данных: ход (16) | оценка (16) | статическая оценка (16) | глубина (8) | граница (2) | поколение (6)
+static uint64_t pack(FastMove move, int score, int eval, int depth, TtBound bound, uint8_t generation)
+{
+    return static_cast<uint64_t>(move)
+        | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+        | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32
+        | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+        | static_cast<uint64_t>(bound) << 56
+        | static_cast<uint64_t>(generation & 63) << 58;
+}
+
+static int unpackDepth(uint64_t data) { return static_cast<int8_t>(data >> 48); }
+static TtBound unpackBound(uint64_t data) { return static_cast<TtBound>((data >> 56) & 3); }
+static uint8_t unpackGeneration(uint64_t data) { return static_cast<uint8_t>(data >> 58); }
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    // степень двойки, чтобы индекс брался маской
+    size_t count = 1;
+    size_t limit = std::max<size_t>(megabytes, 1) * 1024 * 1024 / sizeof(Slot);
+    while (count * 2 <= limit)
+        count *= 2;
+
+    slots.reset(new Slot[count]);
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (uint64_t i = 0; i <= mask; ++i)
+    {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TtEntry& entry) const
+{
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || unpackBound(data) == BOUND_NONE)
+        return false;
+
+    entry.move = static_cast<FastMove>(data & 0xFFFF);
+    entry.score = static_cast<int16_t>(data >> 16);
+    entry.eval = static_cast<int16_t>(data >> 32);
+    entry.depth = unpackDepth(data);
+    entry.bound = unpackBound(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, FastMove move, int score, int eval, int depth, TtBound bound)
+{
+    Slot& slot = slots[key & mask];
+    uint64_t old = slot.data.load(std::memory_order_relaxed);
+    bool sameKey = (slot.check.load(std::memory_order_relaxed) ^ old) == key;
+
+    // глубокие записи текущего поиска не затираем мелкими
+    if (sameKey || bound == BOUND_EXACT || unpackGeneration(old) != (generation & 63) || depth + 3 >= unpackDepth(old))
+    {
+        if (sameKey && move == NO_MOVE)
+            move = static_cast<FastMove>(old & 0xFFFF);
+        uint64_t data = pack(move, score, eval, depth, bound, generation);
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used = 0;
+    uint64_t sample = std::min<uint64_t>(1000, mask + 1);
+    for (uint64_t i = 0; i < sample; ++i)
+    {
+        uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+        if (unpackBound(data) != BOUND_NONE && unpackGeneration(data) == (generation & 63))
+            ++used;
+    }
+    return static_cast<int>(used * 1000 / sample);
+}
\ No newline at end of file
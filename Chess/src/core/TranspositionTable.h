@@ -0,0 +1,51 @@
+#pragma once
+#include "FastBoard.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+enum TtBound : uint8_t
+{
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT
+};
+
+struct TtEntry
+{
+    FastMove move;
+    int score;
+    int eval;
+    int depth;
+    TtBound bound;
+};
+
+// Хеш-таблица перебора. Запись - два 64-битных слова (ключ xor данные и данные), поэтому
+// её можно читать и писать из нескольких потоков без блокировок: порванная запись не пройдёт проверку ключа.
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);
+    void clear();
+    // Новый поиск: записи прошлых поисков вытесняются в первую очередь
+    void newSearch();
+
+    bool probe(uint64_t key, TtEntry& entry) const;
+    void store(uint64_t key, FastMove move, int score, int eval, int depth, TtBound bound);
+    // Заполненность в промилле для "info hashfull"
+    int hashfull() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask = 0;
+    uint8_t generation = 0;
+};
\ No newline at end of file
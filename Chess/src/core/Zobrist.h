@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Хеш позиции в раскладке Polyglot: 12 * 64 ключа фигур, 4 рокировки, 8 вертикалей взятия на проходе, очередь хода.
+// Счётчики ходов из FEN в ключ не входят, поэтому перестановки ходов дают один и тот же ключ.
+class Zobrist
+{
+public:
+    static constexpr int PIECE_OFFSET = 0;
+    static constexpr int CASTLE_OFFSET = 768;
+    static constexpr int EN_PASSANT_OFFSET = 772;
+    static constexpr int TURN_OFFSET = 780;
+    static constexpr int KEYS_COUNT = 781;
+
+    // Вид фигуры Polyglot: чёрная пешка = 0, белая пешка = 1, ..., белый король = 11
+    static int pieceKind(char fenPiece);
+    static uint64_t pieceKey(int kind, int x, int y);
+
+    // 0 - если FEN не разобран
+    static uint64_t hashFen(const std::string& fen);
+
+    // Таблица Random64 из Polyglot, KEYS_COUNT ключей: книги совпадают со сторонними инструментами
+    static const uint64_t* keys();
+};
\ No newline at end of file
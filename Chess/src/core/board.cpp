@@ -1,4 +1,8 @@
 #include "board.h"
+#include "FastBoard.h"
+#include "MateSolver.h"
+#include "Tablebase.h"
+#include "Zobrist.h"
 
 Board::Board(std::unique_ptr<GameMode> game_mode, float startTimeSeconds, float inc)
     : game_mode(std::move(game_mode))
@@ -83,7 +87,8 @@ GameStatus Board::getGameStatus() const
     return (game_mode->isCheckmate(grid, current_player, getLastMove())
                || game_mode->isStalemate(grid, current_player, getLastMove())
                || clock->isTimeUp()
-               || isThreefoldRepetition())
+               || isThreefoldRepetition()
+               || isTablebaseDraw())
         ? GameStatus::END_GAME
         : game_mode->isInCheck(grid, current_player, getLastMove()) ? GameStatus::CHECK
                                                                     : GameStatus::IN_GAME;
@@ -131,6 +136,11 @@ void Board::updateClock()
     clock->update();
 }
 
+void Board::setClockTimes(float whiteSeconds, float blackSeconds)
+{
+    clock->setTimes(whiteSeconds, blackSeconds);
+}
+
 float Board::getBlackTime() const
 {
     return clock->getBlackTime();
@@ -141,6 +151,11 @@ float Board::getWhiteTime() const
     return clock->getWhiteTime();
 }
 
+float Board::getIncrement() const
+{
+    return clock->getIncrement();
+}
+
 bool Board::isTimeUp() const
 {
     return clock->isTimeUp();
@@ -288,6 +303,44 @@ std::string Board::getFen() const
     return ss.str();
 }
 
+uint64_t Board::getKey() const
+{
+    return Zobrist::hashFen(getFenBoardPart());
+}
+
+void Board::setTablebase(std::shared_ptr<const Tablebase> tablebase)
+{
+    this->tablebase = std::move(tablebase);
+}
+
+bool Board::isTablebaseDraw() const
+{
+    if (!tablebase)
+        return false;
+
+    // FEN разбираем только когда фигур достаточно мало для таблиц
+    int pieces = 0;
+    for (const auto& row : grid)
+        pieces += static_cast<int>(std::count_if(row.begin(), row.end(), [](const auto& p) { return p != nullptr; }));
+    if (pieces > tablebase->getMaxPieces() && pieces > 2)
+        return false;
+
+    FastBoard pos;
+    if (!pos.setFen(getFen()))
+        return false;
+    auto result = tablebase->probe(pos);
+    return result && result->wdl == 0;
+}
+
+std::optional<MateResult> findMate(const Board& board, int maxPlies, uint64_t maxNodes)
+{
+    FastBoard pos;
+    if (!pos.setFen(board.getFen()))
+        return std::nullopt;
+    MateSolver solver;
+    return solver.solve(pos, maxPlies, maxNodes);
+}
+
 bool Board::isThreefoldRepetition() const
 {
     if (position_history.empty())
@@ -1,15 +1,20 @@
 #pragma once
 #include "Clock.h"
+#include "MateSolver.h"
 #include "game_mode.h"
 #include "move.h"
 #include "pieces.h"
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
 
+class Tablebase;
+
 enum class GameStatus
 {
     END_GAME,
@@ -25,6 +30,7 @@ class Board
     std::vector<std::string> position_history;
     Color current_player;
     std::unique_ptr<Clock> clock;
+    std::shared_ptr<const Tablebase> tablebase;
 
 public:
     Board(std::unique_ptr<GameMode> game_mode, float startTimeSeconds, float inc);
@@ -43,14 +49,23 @@ public:
     const std::vector<std::string>& getPromotionTypes() const;
     const std::vector<std::vector<std::unique_ptr<Piece>>>& getGrid() const;
     void updateClock();
+    void setClockTimes(float whiteSeconds, float blackSeconds);
     float getBlackTime() const;
     float getWhiteTime() const;
+    float getIncrement() const;
     bool isTimeUp() const;
     void timeStop();
     std::string getFen() const;
+    uint64_t getKey() const;
 
     bool isThreefoldRepetition() const;
+    // Ничья по таблицам эндшпиля; без таблиц всегда false
+    bool isTablebaseDraw() const;
+    void setTablebase(std::shared_ptr<const Tablebase> tablebase);
     std::string getFenBoardPart() const;
 
     friend std::ostream& operator<<(std::ostream& os, const Board& board);
-};
\ No newline at end of file
+};
+
+// Форсированный мат за сторону, которая ходит (df-pn на битбордах), не дальше maxPlies полуходов
+std::optional<MateResult> findMate(const Board& board, int maxPlies, uint64_t maxNodes = MateSolver::DEFAULT_NODES);
\ No newline at end of file
@@ -255,33 +255,35 @@ void Fischer::initializeBoard(Piece::board_type& board)
     pf.registration<Bishop>("bishop");
     pf.registration<Queen>("queen");
     pf.registration<King>("king");
-    srand(seed ? seed : static_cast<unsigned int>(time(0)));
+    //  :  seed      
+    std::mt19937 rng(seed ? static_cast<unsigned int>(seed) : std::random_device {}());
     for (int i = 0; i < 8; i++)
     {
         board[1][i] = pf.create("pawn", Color::White, Position(i, 1));
         board[6][i] = pf.create("pawn", Color::Black, Position(i, 6));
     }
     std::vector<int> positions = { 0, 1, 2, 3, 4, 5, 6, 7 };
-    int kingPosition = 1 + rand() % 6;
-    int firstRookPosition = rand() % kingPosition;
-    int secondRookPosition = kingPosition + 1 + (rand() % (7 - kingPosition));
+    int kingPosition = 1 + rng() % 6;
+    int firstRookPosition = rng() % kingPosition;
+    int secondRookPosition = kingPosition + 1 + (rng() % (7 - kingPosition));
     positions.erase(
         std::remove_if(positions.begin(), positions.end(), [kingPosition, firstRookPosition, secondRookPosition](int x) {
             return x == kingPosition || x == firstRookPosition || x == secondRookPosition;
         }),
         positions.end());
-    int firstBishopPosition = positions[rand() % 5];
-    int secondBishopPosition = positions[rand() % 5];
+    int firstBishopPosition = positions[rng() % 5];
+    int secondBishopPosition = positions[rng() % 5];
     while (secondBishopPosition % 2 == firstBishopPosition % 2)
-        secondBishopPosition = positions[rand() % 5];
+        secondBishopPosition = positions[rng() % 5];
     positions.erase(
         std::remove_if(positions.begin(), positions.end(), [firstBishopPosition, secondBishopPosition](int x) {
             return x == firstBishopPosition || x == secondBishopPosition;
         }),
         positions.end());
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(positions.begin(), positions.end(), g);
+    // - : std::shuffle       ,
+    //        seed     
+    for (size_t i = positions.size() - 1; i > 0; --i)
+        std::swap(positions[i], positions[rng() % (i + 1)]);
 
     int queenPosition = positions[0];
     int firstKnightPosition = positions[1];
@@ -1,20 +1,34 @@
 #include "game_controller.h"
 #include "graphic/sfml_graphics.h"
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 
+// Баннер мата: короткие маты и небольшой бюджет, чтобы проверка успевала между ходами
+static const int MATE_BANNER_PLIES = 7;
+static const uint64_t MATE_BANNER_NODES = 50000;
+
+// Время движка на ход: по часам партии, но не больше прежней секунды; запас - на трубы и кадр интерфейса
+static const int AI_MAX_MOVE_TIME_MS = 1000;
+static const int AI_OVERHEAD_MS = 100;
+static const int AI_DEADLINE_MARGIN_MS = 1000;
+
+// Фоновый анализ: число вариантов и собственный хеш
+static const int ANALYSIS_LINES = 3;
+static const size_t ANALYSIS_HASH_MB = 32;
+
 GameController::GameController(std::unique_ptr<Board> board,
     std::shared_ptr<IGraphicsInterface> graphics,
     std::unique_ptr<INetworkInterface> network,
-    std::unique_ptr<Stockfish> stockfish,
+    std::shared_ptr<EnginePool> enginePool,
     Color controllerColor)
     : board(std::move(board))
     , graphics(std::move(graphics))
     , network(std::move(network))
-    , stockfish(std::move(stockfish))
+    , enginePool(std::move(enginePool))
     , playerColor(controllerColor)
     , isNetworkGame(this->network != nullptr)
-    , isAIGame(this->stockfish != nullptr)
+    , isAIGame(this->enginePool != nullptr)
     , state(ControllerState::None)
     , aiThinking(false)
 {
@@ -25,24 +39,37 @@ GameController::GameController(std::unique_ptr<Board> board,
 
     if (isAIGame)
     {
-        if (!this->stockfish->start())
+        if (!this->enginePool->start())
         {
-            std::cerr << "Failed to start Stockfish!" << std::endl;
+            std::cerr << "Failed to start engine pool!" << std::endl;
             isAIGame = false;
         }
     }
+
+    // шкала оценки - только в локальных партиях и против компьютера
+    if (!isNetworkGame)
+    {
+        analysis = std::make_shared<AnalysisService>(ANALYSIS_LINES, ANALYSIS_HASH_MB);
+        analysis->setPosition(this->board->getFen());
+        analysisPly = this->board->getHistory().size();
+        this->graphics->setAnalysis(analysis);
+    }
 }
 
 GameController::~GameController()
 {
-    if (isAIGame && stockfish)
-    {
-        stockfish->stop();
-    }
+    // графика живёт дольше контроллера - поток анализа останавливается вместе с ним
+    if (analysis)
+        graphics->setAnalysis(nullptr);
+
     if (aiThread.joinable())
     {
         aiThread.join();
     }
+
+    // пул переживает партию - движок, думающий на чужом времени, возвращаем
+    if (isAIGame)
+        enginePool->cancelPonder();
 }
 
 void GameController::setOnGameEnd(std::function<void(void)> onGameEnd)
@@ -50,6 +77,11 @@ void GameController::setOnGameEnd(std::function<void(void)> onGameEnd)
     this->onGameEnd = onGameEnd;
 }
 
+void GameController::setBook(std::shared_ptr<Book> book)
+{
+    this->book = std::move(book);
+}
+
 void GameController::update()
 {
     if (afterEnd)
@@ -64,11 +96,18 @@ void GameController::update()
         return;
     }
 
-    if (board->isTimeUp())
+    // с часами сервера о конце времени скажет он, с учётом задержки сети
+    bool serverClock = isNetworkGame && network && network->hasServerClock();
+    if (board->isTimeUp() && !serverClock)
         gameEnd();
 
     board->updateClock();
     graphics->drawBoard(*board, board->getCurrentPlayer());
+    updateMateBanner();
+    updateAnalysis();
+
+    if (isNetworkGame && network)
+        updateConnectionBanner();
 
     if (isNetworkGame && network && network->isConnected())
     {
@@ -80,58 +119,41 @@ void GameController::update()
 
         Move receivedMove = network->receiveMove();
 
-        if (receivedMove.isValid())
+        if (receivedMove.isValid() && state == ControllerState::OpponentTurn)
         {
-            if (state == ControllerState::OpponentTurn)
+            if (applyNetworkMove(receivedMove))
+            {
+                state = ControllerState::None;
+                showOpponentMove(receivedMove);
+            }
+            else
             {
-                std::vector<Move> legalMoves = board->getSelectableMoves(receivedMove.getFrom());
-                bool moveFound = false;
+                gameEnd(playerColor, " (incorrect data from opponent)");
+            }
+        }
 
-                for (const auto& m : legalMoves)
+        // после возврата в партию ходы, сделанные соперником за время обрыва, догоняются разом
+        std::vector<Move> missedMoves;
+        if (network->receiveMissedMoves(missedMoves) && !afterEnd)
+        {
+            bool caughtUp = true;
+            for (const Move& m : missedMoves)
+            {
+                if (!applyNetworkMove(m))
                 {
-                    if (m == receivedMove)
-                    {
-                        if (m.isPromotion())
-                        {
-                            if (m.getPromotionPiece() == receivedMove.getPromotionPiece())
-                            {
-                                board->makeMove(m);
-                                moveFound = true;
-                                break;
-                            }
-                        }
-                        else
-                        {
-                            board->makeMove(m);
-                            moveFound = true;
-                            break;
-                        }
-                    }
+                    caughtUp = false;
+                    break;
                 }
+            }
 
-                if (moveFound)
-                {
-                    graphics->clearHighlights();
-                    graphics->setCellTypeHl(receivedMove.getFrom(), Highlight::LAST_POS);
-                    graphics->setCellTypeHl(receivedMove.getTo(), Highlight::CURRENT_POS);
-
-                    state = ControllerState::None;
-
-                    GameStatus gst = board->getGameStatus();
-                    if (gst == GameStatus::END_GAME)
-                    {
-                        gameEnd();
-                    }
-                    else if (gst == GameStatus::CHECK)
-                    {
-                        Position kingPos = board->findPiece("king", board->getCurrentPlayer());
-                        graphics->setCellTypeHl(kingPos, Highlight::CHECK_POS);
-                    }
-                }
-                else
-                {
-                    gameEnd(playerColor, " (incorrect data from opponent)");
-                }
+            if (!caughtUp)
+            {
+                gameEnd(playerColor, " (incorrect data from opponent)");
+            }
+            else if (!missedMoves.empty())
+            {
+                state = board->getCurrentPlayer() == playerColor ? ControllerState::None : ControllerState::OpponentTurn;
+                showOpponentMove(missedMoves.back());
             }
         }
 
@@ -140,37 +162,58 @@ void GameController::update()
             gameEnd(playerColor, " (opponent resign)");
             return;
         }
+
+        std::string drawReason;
+        if (network->isDrawAdjudicated(drawReason))
+        {
+            gameEnd(std::nullopt, drawReason);
+            return;
+        }
+
+        // поправка приходит следом за ходом, поэтому ложится на уже переключённые часы
+        int whiteMs, blackMs;
+        if (network->receiveClock(whiteMs, blackMs))
+            board->setClockTimes(whiteMs / 1000.f, blackMs / 1000.f);
+
+        Color loser;
+        if (network->isFlagged(loser))
+        {
+            gameEnd(loser == Color::White ? Color::Black : Color::White, " (time)");
+            return;
+        }
     }
 
     if (isAIGame && !aiThinking && aiThread.joinable())
     {
         aiThread.join();
-        if (!aiBestMoveStr.empty())
+        // пока человек думает, движок считает ответ на ожидаемый ход
+        if (!aiBestMoveStr.empty() && applyAIMove(aiBestMoveStr) && !afterEnd && !aiPonderMoveStr.empty())
         {
-            Move m = stringToMove(aiBestMoveStr);
-            if (m.isValid())
-            {
-                if (board->makeMove(m))
-                {
-                    graphics->clearHighlights();
-                    graphics->setCellTypeHl(m.getFrom(), Highlight::LAST_POS);
-                    graphics->setCellTypeHl(m.getTo(), Highlight::CURRENT_POS);
-
-                    GameStatus gst = board->getGameStatus();
-                    if (gst == GameStatus::END_GAME)
-                        gameEnd();
-                    else if (gst == GameStatus::CHECK)
-                    {
-                        Position kingPos = board->findPiece("king", board->getCurrentPlayer());
-                        graphics->setCellTypeHl(kingPos, Highlight::CHECK_POS);
-                    }
-                }
-            }
+            Color aiColor = board->getCurrentPlayer() == Color::White ? Color::Black : Color::White;
+            if (enginePool->startPonder(board->getFen(), aiPonderMoveStr, aiMoveTimeMs(aiColor)))
+                ponderPly = board->getHistory().size();
         }
         aiBestMoveStr = "";
+        aiPonderMoveStr = "";
         state = ControllerState::None;
     }
 
+    if (isAIGame && !aiThinking && state == ControllerState::OpponentTurn && book)
+    {
+        // ход из книги отвечается сразу, без движка
+        if (auto bookMove = book->probe(*board))
+        {
+            Move m = stringToMove(*bookMove);
+            if (m.isValid() && board->isValidMove(m))
+            {
+                enginePool->cancelPonder();
+                applyAIMove(*bookMove);
+                state = ControllerState::None;
+                return;
+            }
+        }
+    }
+
     if (isAIGame && !aiThinking && state == ControllerState::OpponentTurn)
     {
         state = ControllerState::OpponentTurn;
@@ -178,23 +221,171 @@ void GameController::update()
         if (aiThread.joinable())
             aiThread.join();
 
+        // ход человека сравнивается с ожидаемым, только если после размышления он был единственным
+        const auto& history = board->getHistory();
+        std::string playedMove = history.size() == ponderPly + 1 ? moveToString(history.back()) : "";
+
         std::string currentFen = board->getFen();
-        aiThread = std::thread([this, currentFen]() {
-            this->aiThreadFunc(currentFen);
+        int moveTimeMs = aiMoveTimeMs(board->getCurrentPlayer());
+        aiThread = std::thread([this, currentFen, playedMove, moveTimeMs]() {
+            this->aiThreadFunc(currentFen, playedMove, moveTimeMs);
         });
     }
 }
 
-void GameController::aiThreadFunc(std::string fen)
+bool GameController::applyNetworkMove(const Move& move)
+{
+    for (const auto& m : board->getSelectableMoves(move.getFrom()))
+    {
+        if (m == move && (!m.isPromotion() || m.getPromotionPiece() == move.getPromotionPiece()))
+            return board->makeMove(m);
+    }
+    return false;
+}
+
+void GameController::showOpponentMove(const Move& move)
+{
+    graphics->clearHighlights();
+    graphics->setCellTypeHl(move.getFrom(), Highlight::LAST_POS);
+    graphics->setCellTypeHl(move.getTo(), Highlight::CURRENT_POS);
+
+    GameStatus gst = board->getGameStatus();
+    if (gst == GameStatus::END_GAME)
+    {
+        gameEnd();
+    }
+    else if (gst == GameStatus::CHECK)
+    {
+        Position kingPos = board->findPiece("king", board->getCurrentPlayer());
+        graphics->setCellTypeHl(kingPos, Highlight::CHECK_POS);
+    }
+}
+
+void GameController::updateConnectionBanner()
+{
+    // ходить можно и без связи: ход уйдёт на сервер после возврата
+    bool reconnecting = network->isReconnecting();
+    if (reconnecting == reconnectBannerShown)
+        return;
+    reconnectBannerShown = reconnecting;
+
+    if (reconnecting)
+        graphics->showMessage("Reconnecting...");
+    else if (network->isConnected())
+        graphics->hideMessage();
+    else
+        graphics->showMessage("Connection lost");
+}
+
+bool GameController::applyAIMove(const std::string& moveStr)
+{
+    Move m = stringToMove(moveStr);
+    if (!m.isValid() || !board->makeMove(m))
+        return false;
+
+    graphics->clearHighlights();
+    graphics->setCellTypeHl(m.getFrom(), Highlight::LAST_POS);
+    graphics->setCellTypeHl(m.getTo(), Highlight::CURRENT_POS);
+
+    GameStatus gst = board->getGameStatus();
+    if (gst == GameStatus::END_GAME)
+        gameEnd();
+    else if (gst == GameStatus::CHECK)
+    {
+        Position kingPos = board->findPiece("king", board->getCurrentPlayer());
+        graphics->setCellTypeHl(kingPos, Highlight::CHECK_POS);
+    }
+    return true;
+}
+
+void GameController::updateMateBanner()
+{
+    // в сетевой партии подсказка была бы нечестной
+    if (isNetworkGame)
+        return;
+
+    size_t ply = board->getHistory().size();
+    if (mateCheck.valid() && mateCheck.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        auto mate = mateCheck.get();
+        if (mate && ply == mateCheckPly)
+        {
+            std::string side = board->getCurrentPlayer() == Color::White ? "White" : "Black";
+            graphics->showMessage(side + " mates in " + std::to_string((mate->plies + 1) / 2));
+            mateBannerShown = true;
+        }
+    }
+
+    if (ply == mateCheckPly || mateCheck.valid())
+        return;
+
+    if (mateBannerShown)
+    {
+        graphics->hideMessage();
+        mateBannerShown = false;
+    }
+    mateCheckPly = ply;
+    std::string fen = board->getFen();
+    mateCheck = std::async(std::launch::async, [fen]() -> std::optional<MateResult> {
+        FastBoard pos;
+        if (!pos.setFen(fen))
+            return std::nullopt;
+        MateSolver solver(4);
+        return solver.solve(pos, MATE_BANNER_PLIES, MATE_BANNER_NODES);
+    });
+}
+
+void GameController::updateAnalysis()
 {
-    if (stockfish)
+    size_t ply = board->getHistory().size();
+    if (!analysis || ply == analysisPly)
+        return;
+
+    analysisPly = ply;
+    analysis->setPosition(board->getFen());
+}
+
+int GameController::aiMoveTimeMs(Color side) const
+{
+    TimeControl control;
+    float remaining = side == Color::White ? board->getWhiteTime() : board->getBlackTime();
+    control.remainingMs = static_cast<int>(remaining * 1000);
+    control.incrementMs = static_cast<int>(board->getIncrement() * 1000);
+    control.moveNumber = static_cast<int>(board->getHistory().size() / 2 + 1);
+    control.overheadMs = AI_OVERHEAD_MS;
+
+    TimeManager timeManager;
+    timeManager.start(control);
+    return static_cast<int>(std::min<int64_t>(timeManager.getOptimumMs(), AI_MAX_MOVE_TIME_MS));
+}
+
+void GameController::aiThreadFunc(std::string fen, std::string playedMove, int moveTimeMs)
+{
+    if (enginePool)
     {
-        std::string move = stockfish->getBestMove(fen);
-        aiBestMoveStr = move;
+        // при попадании ответ уже почти готов, при промахе размышление отменяется
+        auto result = enginePool->finishPonder(playedMove);
+        if (!result)
+            result = enginePool->analyse(fen, moveTimeMs, std::chrono::milliseconds(moveTimeMs + AI_DEADLINE_MARGIN_MS));
+        aiBestMoveStr = result ? result->bestMove : "";
+        aiPonderMoveStr = result ? result->ponderMove : "";
     }
     aiThinking = false;
 }
 
+std::string GameController::moveToString(const Move& move)
+{
+    std::string res;
+    res += static_cast<char>('a' + move.getFrom().getX());
+    res += static_cast<char>('1' + move.getFrom().getY());
+    res += static_cast<char>('a' + move.getTo().getX());
+    res += static_cast<char>('1' + move.getTo().getY());
+    std::string promo = move.getPromotionPiece();
+    if (!promo.empty())
+        res += promo == "knight" ? 'n' : promo[0];
+    return res;
+}
+
 Move GameController::stringToMove(std::string moveStr)
 {
     if (moveStr.length() < 4)
@@ -377,5 +568,5 @@ void GameController::gameEnd(std::optional<Color> winner, const std::string& rea
     if (winner.has_value())
         graphics->showMessage((winner == Color::White ? "White win!" : "Black win!") + reason);
     else
-        graphics->showMessage("Draw");
+        graphics->showMessage("Draw" + reason);
 }
\ No newline at end of file
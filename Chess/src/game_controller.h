@@ -1,10 +1,15 @@
 #pragma once
-#include "core/Stockfish.h"
+#include "core/AnalysisService.h"
+#include "core/Book.h"
+#include "core/EnginePool.h"
+#include "core/MateSolver.h"
+#include "core/TimeManager.h"
 #include "core/board.h"
 #include "game_interfaces.h"
 #include <algorithm>
 #include <atomic>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -24,7 +29,8 @@ private:
     std::unique_ptr<Board> board;
     std::shared_ptr<IGraphicsInterface> graphics;
     std::unique_ptr<INetworkInterface> network;
-    std::unique_ptr<Stockfish> stockfish;
+    std::shared_ptr<EnginePool> enginePool;
+    std::shared_ptr<Book> book;
 
     bool isNetworkGame;
     bool isAIGame;
@@ -39,22 +45,46 @@ private:
     std::thread aiThread;
     std::atomic<bool> aiThinking;
     std::string aiBestMoveStr;
+    //   :   ,      
+    std::string aiPonderMoveStr;
+    size_t ponderPly = 0;
 
     //  ,   
     Color playerColor;
 
-    void aiThreadFunc(std::string fen);
+    //        ;     
+    std::future<std::optional<MateResult>> mateCheck;
+    size_t mateCheckPly = 0;
+    bool mateBannerShown = false;
+
+    //       ;    
+    std::shared_ptr<AnalysisService> analysis;
+    size_t analysisPly = 0;
+
+    //  "Reconnecting...",        
+    bool reconnectBannerShown = false;
+
+    void aiThreadFunc(std::string fen, std::string playedMove, int moveTimeMs);
+    int aiMoveTimeMs(Color side) const;
+    bool applyAIMove(const std::string& moveStr);
+    void updateMateBanner();
+    void updateAnalysis();
+    void updateConnectionBanner();
+    //    :     ; false -   
+    bool applyNetworkMove(const Move& move);
+    void showOpponentMove(const Move& move);
 
 public:
     GameController(std::unique_ptr<Board> board,
         std::shared_ptr<IGraphicsInterface> graphics,
         std::unique_ptr<INetworkInterface> network = nullptr,
-        std::unique_ptr<Stockfish> stockfish = nullptr,
+        std::shared_ptr<EnginePool> enginePool = nullptr,
         Color controllerColor = Color::White);
 
     ~GameController(); //     
 
     void setOnGameEnd(std::function<void(void)> onGameEnd);
+    void setBook(std::shared_ptr<Book> book);
     void update();
     void resign();
     void onClick(int x, int y);
@@ -62,4 +92,5 @@ public:
 private:
     void gameEnd(std::optional<Color> winner = std::nullopt, const std::string& reason = "");
     Move stringToMove(std::string moveStr);
+    static std::string moveToString(const Move& move);
 };
\ No newline at end of file
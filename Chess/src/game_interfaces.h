@@ -3,6 +3,9 @@
 #include "core/position.h"
 #include "core/board.h"
 #include <functional>
+#include <memory>
+
+class AnalysisService;
 
 enum class Highlight
 {
@@ -24,6 +27,9 @@ public:
     virtual void showPromotionSelector(Color color, std::function<void(std::string)> callback, const std::vector<std::string>& promotionTypes) = 0;
     virtual void setCellTypeHl(Position pos, Highlight hl) = 0;
     virtual void showMessage(const std::string& message) = 0;
+    virtual void hideMessage() = 0;
+    // nullptr - шкала оценки и варианты анализа не показываются
+    virtual void setAnalysis(std::shared_ptr<const AnalysisService> analysis) = 0;
     virtual void setOnResign(std::function<void()> callback) = 0;
     virtual void hidePromotionSelector() = 0;
 
@@ -40,6 +46,21 @@ public:
 
     virtual void sendGameOver() = 0; 
     virtual bool isPeerResigned() = 0; 
+    // Сервер присудил ничью (таблицы эндшпиля, повторение, правило 50 ходов, недостаточный материал);
+    // reason - пояснение к сообщению о ничьей
+    virtual bool isDrawAdjudicated(std::string& reason) = 0;
+
+    // Часы партии ведёт сервер: свои часы клиента только показывают время между его поправками
+    virtual bool hasServerClock() = 0;
+    // Остаток времени сторон от сервера после последнего хода, мс; false - новой поправки нет
+    virtual bool receiveClock(int& whiteMs, int& blackMs) = 0;
+    // Сервер зафиксировал, что у loser кончилось время
+    virtual bool isFlagged(Color& loser) = 0;
+
+    // Связь оборвалась, и клиент пытается вернуться в партию; isConnected() в это время true
+    virtual bool isReconnecting() = 0;
+    // После возврата: ходы соперника, пропущенные за время обрыва, все сразу; false - таких нет
+    virtual bool receiveMissedMoves(std::vector<Move>& moves) = 0;
 
     virtual ~INetworkInterface() = default;
 };
\ No newline at end of file
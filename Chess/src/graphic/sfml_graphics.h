@@ -1,8 +1,10 @@
 #pragma once
+#include "../core/AnalysisService.h"
 #include "../game_interfaces.h"
 #include "ResourceManager.h"
 #include "button.h"
 #include <SFML/Graphics.hpp>
+#include <cmath>
 #include <functional>
 #include <iomanip>
 #include <sstream>
@@ -32,6 +34,12 @@ class SFMLGraphics : public IGraphicsInterface
     std::unique_ptr<Button> resignButton;
     std::function<void()> onResignCallback;
 
+    //  :    ,     
+    std::shared_ptr<const AnalysisService> analysis;
+    AnalysisSnapshot analysisSnapshot;
+    int evalScore = 0;
+    int analysisRows = 0;
+
     Color viewColor;
 
     std::function<void(Position)> onSquareClickCallback;
@@ -103,6 +111,96 @@ class SFMLGraphics : public IGraphicsInterface
         window.draw(text);
     }
 
+    static std::string formatEval(int score, int precision)
+    {
+        int mate = Search::mateIn(score);
+        if (mate != 0)
+            return (mate > 0 ? "M" : "-M") + std::to_string(std::abs(mate));
+
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(precision) << std::showpos << score / 100.0;
+        return ss.str();
+    }
+
+    void updateAnalysis()
+    {
+        AnalysisSnapshot fresh;
+        if (!analysis->read(fresh))
+            return;
+        analysisSnapshot = fresh;
+        if (fresh.lineCount > 0)
+            evalScore = fresh.lines[0].score;
+        analysisRows = std::max(analysisRows, fresh.lineCount);
+    }
+
+    void drawEvalBar()
+    {
+        float width = boardArea.size.x * 0.04f;
+        float gap = boardArea.size.x * 0.015f;
+        sf::Vector2f barPos(boardArea.position.x - gap - width, boardArea.position.y);
+        sf::Vector2f barSize(width, boardArea.size.y);
+
+        //  :  -  ,     
+        int mate = Search::mateIn(evalScore);
+        float share = mate > 0 ? 1.0f : mate < 0 ? 0.0f : 1.0f / (1.0f + std::pow(10.0f, -evalScore / 400.0f));
+
+        sf::RectangleShape back(barSize);
+        back.setPosition(barPos);
+        back.setFillColor(sf::Color(40, 40, 40));
+        back.setOutlineColor(sf::Color::White);
+        back.setOutlineThickness(2.0f);
+        window.draw(back);
+
+        //     
+        float whiteHeight = barSize.y * share;
+        bool whiteBottom = viewColor == Color::White;
+        sf::RectangleShape white(sf::Vector2f(width, whiteHeight));
+        white.setPosition(sf::Vector2f(barPos.x, whiteBottom ? barPos.y + barSize.y - whiteHeight : barPos.y));
+        white.setFillColor(sf::Color(235, 235, 235));
+        window.draw(white);
+
+        //    ,  
+        const sf::Font* font = resourceManager.getFont("main_font");
+        unsigned int charSize = static_cast<unsigned int>(width * 0.35f);
+        sf::Text text(*font, formatEval(evalScore, 1), std::max(charSize, 8u));
+        bool whiteBetter = evalScore >= 0;
+        text.setFillColor(whiteBetter ? sf::Color::Black : sf::Color::White);
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setOrigin(bounds.getCenter());
+        bool atBottom = whiteBetter == whiteBottom;
+        float margin = bounds.size.y + 4.0f;
+        text.setPosition(sf::Vector2f(barPos.x + width / 2.0f, atBottom ? barPos.y + barSize.y - margin : barPos.y + margin));
+        window.draw(text);
+    }
+
+    //     ;     
+    void drawAnalysisLines(unsigned int charSize, float lineSpacing)
+    {
+        const sf::Font* font = resourceManager.getFont("main_font");
+        float top = historyArea.position.y + historyArea.size.y - analysisRows * lineSpacing - 5.0f;
+
+        sf::RectangleShape separator(sf::Vector2f(historyArea.size.x, 1.0f));
+        separator.setPosition(sf::Vector2f(historyArea.position.x, top - 2.0f));
+        separator.setFillColor(sf::Color::White);
+        window.draw(separator);
+
+        for (int i = 0; i < analysisSnapshot.lineCount; ++i)
+        {
+            const AnalysisSnapshot::Line& line = analysisSnapshot.lines[i];
+            std::string content = formatEval(line.score, 2) + " " + line.text;
+
+            sf::Text text(*font, content, charSize);
+            while (text.getLocalBounds().size.x > historyArea.size.x - 20.0f && content.find(' ') != std::string::npos)
+            {
+                content.erase(content.rfind(' '));
+                text.setString(content);
+            }
+            text.setFillColor(sf::Color(200, 230, 255));
+            text.setPosition(sf::Vector2f(historyArea.position.x + 10.0f, top + i * lineSpacing));
+            window.draw(text);
+        }
+    }
+
     std::string posToString(Position pos)
     {
         if (!pos.isValid())
@@ -281,6 +379,8 @@ public:
 
         float lineSpacing = charSize * 1.2f;
         int maxLines = static_cast<int>(historyArea.size.y / lineSpacing);
+        if (analysis)
+            maxLines = std::max(0, maxLines - analysisRows);
 
         int startIdx = 0;
         if (history.size() > maxLines)
@@ -300,6 +400,9 @@ public:
                 historyArea.position.y + (i - startIdx) * lineSpacing + 5.0f));
             window.draw(text);
         }
+
+        if (analysis && analysisRows > 0)
+            drawAnalysisLines(charSize, lineSpacing);
     }
 
     void drawClock(float time, sf::FloatRect rectArea, const sf::Texture* bgTex)
@@ -420,6 +523,12 @@ public:
             }
         }
 
+        if (analysis)
+        {
+            updateAnalysis();
+            drawEvalBar();
+        }
+
         drawHistoryList(board.getHistory());
 
         resignButton->draw(window);
@@ -500,4 +609,17 @@ public:
         currentMessage = message;
         isMessageVisible = true;
     }
+
+    void hideMessage() override
+    {
+        isMessageVisible = false;
+    }
+
+    void setAnalysis(std::shared_ptr<const AnalysisService> service) override
+    {
+        analysis = std::move(service);
+        analysisSnapshot = AnalysisSnapshot {};
+        evalScore = 0;
+        analysisRows = 0;
+    }
 };
\ No newline at end of file
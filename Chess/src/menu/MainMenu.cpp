@@ -129,6 +129,8 @@ void MainMenu::initButtons()
     {
         createLabel(0.5f, 0.4f, "Connecting to server...", 40);
         createLabel(0.5f, 0.5f, "Waiting for opponent...", 30);
+        if (!waitingRoomCode.empty())
+            createLabel(0.5f, 0.6f, "Room code: " + waitingRoomCode, 36);
 
         setupButtons.push_back(createBtn({ 0.35f, 0.7f }, { 0.3f, 0.1f }, "CANCEL", [this]() {
             if (onCancelConnect) onCancelConnect(); }, sf::Color(255, 100, 100)));
@@ -260,13 +262,22 @@ void MainMenu::createSetupButtons(sf::Vector2u winSize)
     float nextRow = customRow + 0.10f;
     if (currentConfig.opponentType == OpponentType::Network)
     {
-        createLabel(0.3f, nextRow + labelYOffset, "Server IP:");
+        createLabel(0.15f, nextRow + labelYOffset, "Server IP:");
         auto ipInput = std::make_unique<InputBox>(
-            sf::Vector2f(winSize.x * 0.45f, winSize.y * nextRow),
+            sf::Vector2f(winSize.x * 0.3f, winSize.y * nextRow),
             sf::Vector2f(winSize.x * 0.25f, winSize.y * 0.06f),
             *font, currentConfig.serverIp, true, 15);
         ipInput->setOnChange([this](std::string val) { currentConfig.serverIp = val; });
         inputBoxes.push_back(std::move(ipInput));
+
+        // Пустой код - сервер создаст комнату и покажет её код для приглашения соперника
+        createLabel(0.58f, nextRow + labelYOffset, "Room code:");
+        auto roomInput = std::make_unique<InputBox>(
+            sf::Vector2f(winSize.x * 0.73f, winSize.y * nextRow),
+            sf::Vector2f(winSize.x * 0.15f, winSize.y * 0.06f),
+            *font, currentConfig.roomCode, false, 6);
+        roomInput->setOnChange([this](std::string val) { currentConfig.roomCode = val; });
+        inputBoxes.push_back(std::move(roomInput));
         nextRow += 0.1f;
     }
     else
@@ -590,9 +601,19 @@ void MainMenu::draw()
     }
 }
 
+void MainMenu::setRoomCode(const std::string& code)
+{
+    if (code == waitingRoomCode)
+        return;
+    waitingRoomCode = code;
+    if (currentScreen == MenuScreen::Connecting)
+        initButtons();
+}
+
 void MainMenu::showConnectionWait()
 {
     currentScreen = MenuScreen::Connecting;
+    waitingRoomCode.clear();
     initButtons();
     startRandomAnimation();
 }
@@ -38,6 +38,7 @@ struct GameConfig
     float incrementSeconds = 5.0f;
     int seed = 0;
     std::string serverIp = "127.0.0.1";
+    std::string roomCode; // пусто - создать новую комнату, иначе войти по коду приглашения
 };
 
 enum class MenuScreen
@@ -93,6 +94,8 @@ class MainMenu
     bool animFlag;
     bool secondActorActive;
 
+    std::string waitingRoomCode;
+
 public:
     MainMenu(sf::RenderWindow& win, ResourceManager& rm);
 
@@ -111,6 +114,8 @@ public:
     MenuScreen getCurrentScreen() const { return currentScreen; }
 
     void setErrorMessage(const std::string& message);
+    // Код комнаты на экране ожидания соперника
+    void setRoomCode(const std::string& code);
 
 private:
     void initButtons();
@@ -2,6 +2,13 @@
 #include "PacketType.h"
 #include <iostream>
 
+// Старый сервер на приветствие не отвечает: ждёт остаток огромного "пакета" или отключает нас
+static const sf::Time HANDSHAKE_TIMEOUT = sf::seconds(2);
+// Попытка возврата идёт в фоне; сервер держит место минуту
+static const sf::Time RESUME_CONNECT_TIMEOUT = sf::seconds(1);
+static const sf::Time RESUME_RETRY_INTERVAL = sf::seconds(2);
+static const sf::Time RESUME_GIVE_UP = sf::seconds(60);
+
 NetworkClient::NetworkClient()
 {
     socket.setBlocking(false);
@@ -9,45 +16,308 @@ NetworkClient::NetworkClient()
 
 NetworkClient::~NetworkClient()
 {
+    joinResumeAttempt();
     socket.disconnect();
 }
 
 bool NetworkClient::connect(const std::string& ip, unsigned short port)
 {
+    joinResumeAttempt();
     peerResignedFlag = false;
-    socket.setBlocking(true);
+    serverClock = false;
+    clockPending = false;
+    flaggedSide = -1;
+    sessionToken.clear();
+    moveLog.clear();
+    missedMoves.clear();
+    resuming = false;
+    {
+        std::lock_guard<std::mutex> lock(roomMutex);
+        roomCode.clear();
+        lastError.clear();
+    }
+    input.clear();
+    output.clear();
+    received.clear();
+    connected = false;
 
     auto resolvedIp = sf::IpAddress::resolve(ip);
-    if (resolvedIp)
+    if (!resolvedIp || !openSocket(*resolvedIp, port))
+        return false;
+    serverAddress = resolvedIp;
+    serverPort = port;
+
+    protocol = WireProtocol::Compact;
+    if (!negotiate())
+    {
+        std::cout << "Server does not support the compact protocol, reconnecting." << std::endl;
+        socket.disconnect();
+        protocol = WireProtocol::Legacy;
+        if (!openSocket(*resolvedIp, port))
+            return false;
+    }
+
+    connected = true;
+    socket.setBlocking(false);
+    return true;
+}
+
+bool NetworkClient::openSocket(const sf::IpAddress& address, unsigned short port, sf::Time timeout)
+{
+    socket.setBlocking(true);
+    return socket.connect(address, port, timeout) == sf::Socket::Status::Done;
+}
+
+bool NetworkClient::negotiate()
+{
+    uint8_t hello[HELLO_SIZE];
+    writeHello(hello, COMPACT_VERSION);
+    if (socket.send(hello, HELLO_SIZE) != sf::Socket::Status::Done)
+        return false;
+
+    sf::SocketSelector selector;
+    selector.add(socket);
+
+    uint8_t reply[HELLO_SIZE];
+    std::size_t got = 0;
+    while (got < HELLO_SIZE)
+    {
+        if (!selector.wait(HANDSHAKE_TIMEOUT))
+            return false;
+        std::size_t count = 0;
+        if (socket.receive(reply + got, HELLO_SIZE - got, count) != sf::Socket::Status::Done)
+            return false;
+        got += count;
+    }
+    uint8_t version = readHello(reply);
+    // сервер старше RESUME_VERSION вернуть в партию не сможет
+    return version != 0 && (!resuming || version >= RESUME_VERSION);
+}
+
+WireProtocol NetworkClient::getProtocol() const
+{
+    return protocol;
+}
+
+bool NetworkClient::send(const WireMessage& message)
+{
+    if (!connected)
+        return false;
+
+    if (!appendFrames(protocol, &message, 1, output))
+        return false;
+    return flush();
+}
+
+bool NetworkClient::flush()
+{
+    if (output.empty())
+        return true;
+
+    // неблокирующий сокет берёт сколько влезет, остаток дошлёт следующий кадр
+    std::size_t sent = 0;
+    sf::Socket::Status status = socket.send(output.data(), output.size(), sent);
+    if (status == sf::Socket::Status::Disconnected || status == sf::Socket::Status::Error)
+    {
+        connectionLost();
+        return false;
+    }
+    output.erase(output.begin(), output.begin() + sent);
+    return true;
+}
+
+bool NetworkClient::receive(WireMessage& message)
+{
+    while (received.empty())
     {
-        if (socket.connect(*resolvedIp, port) == sf::Socket::Status::Done)
+        uint8_t buffer[4096];
+        std::size_t count = 0;
+        sf::Socket::Status status = socket.receive(buffer, sizeof(buffer), count);
+        if (status == sf::Socket::Status::Disconnected || status == sf::Socket::Status::Error)
+        {
+            connectionLost();
+            return false;
+        }
+        if (status != sf::Socket::Status::Done)
+            return false;
+        input.insert(input.end(), buffer, buffer + count);
+
+        // в одном компактном кадре бывает несколько сообщений
+        std::size_t offset = 0;
+        while (true)
         {
-            connected = true;
-            socket.setBlocking(false);
-            return true;
+            std::size_t length = frameLength(protocol, input.data() + offset, input.size() - offset);
+            if (length == 0)
+                break;
+            if (length == FRAME_MALFORMED)
+            {
+                connected = false;
+                return false;
+            }
+
+            FrameReader reader(protocol, input.data() + offset, length);
+            WireMessage next;
+            while (reader.next(next))
+            {
+                if (!handleControlMessage(next))
+                    received.push_back(next);
+            }
+            if (reader.failed())
+            {
+                connected = false;
+                return false;
+            }
+            offset += length;
         }
+        input.erase(input.begin(), input.begin() + offset);
     }
 
+    message = std::move(received.front());
+    received.pop_front();
+    return true;
+}
+
+bool NetworkClient::handleControlMessage(const WireMessage& message)
+{
+    switch (message.type)
+    {
+    case PacketType::Ping:
+    {
+        // отвечаем сразу: по нему сервер меряет задержку и возвращает её на наши часы
+        WireMessage pong(PacketType::Pong);
+        pong.stamp = message.stamp;
+        send(pong);
+        return true;
+    }
+    case PacketType::ClockSync:
+        serverClock = true;
+        clockPending = true;
+        clockMs[0] = message.clockMs[0];
+        clockMs[1] = message.clockMs[1];
+        return true;
+    case PacketType::Flag:
+        std::cout << "Server flagged " << (message.result == 0 ? "White" : "Black") << " on time." << std::endl;
+        flaggedSide = message.result;
+        return true;
+    case PacketType::SessionToken:
+        sessionToken = message.text;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void NetworkClient::connectionLost()
+{
     connected = false;
-    return false;
+    if (sessionToken.empty() || resuming)
+        return;
+    std::cout << "Connection lost, trying to resume the game." << std::endl;
+    resuming = true;
+    sinceDrop.restart();
+    nextResumeAttempt = sf::Time::Zero;
 }
 
-void NetworkClient::sendGameConfig(Color color, int timeMinutes, int incrementSeconds, int gameType, int seed)
+bool NetworkClient::tryResume()
 {
-    if (!connected)
+    if (resumeThread.joinable())
+    {
+        // ещё подключается: кадр отрисовки не ждёт
+        if (!resumeAttemptDone.load(std::memory_order_acquire))
+            return false;
+        resumeThread.join();
+        if (!resumeAttemptOk)
+            socket.disconnect();
+    }
+    else
+    {
+        if (sinceDrop.getElapsedTime() > RESUME_GIVE_UP)
+        {
+            std::cout << "Could not resume the game." << std::endl;
+            resuming = false;
+            return false;
+        }
+        if (sinceDrop.getElapsedTime() < nextResumeAttempt || !serverAddress)
+            return false;
+        nextResumeAttempt = sinceDrop.getElapsedTime() + RESUME_RETRY_INTERVAL;
+
+        resumeAttemptOk = false;
+        resumeAttemptDone = false;
+        resumeThread = std::thread([this]() {
+            socket.disconnect();
+            input.clear();
+            output.clear();
+            protocol = WireProtocol::Compact;
+            resumeAttemptOk = openSocket(*serverAddress, serverPort, RESUME_CONNECT_TIMEOUT) && negotiate();
+            resumeAttemptDone.store(true, std::memory_order_release);
+        });
+        return false;
+    }
+    if (!resumeAttemptOk)
+        return false;
+
+    connected = true;
+    resuming = false;
+    socket.setBlocking(false);
+
+    // сервер ответит пропущенными ходами или числом ходов меньше нашего
+    WireMessage request(PacketType::Resume);
+    request.text = sessionToken;
+    request.ply = static_cast<uint32_t>(moveLog.size());
+    send(request);
+    std::cout << "Reconnected, resuming the game." << std::endl;
+    return true;
+}
+
+void NetworkClient::handleResume(const WireMessage& message)
+{
+    if (message.ply > moveLog.size())
         return;
 
-    sf::Packet packet;
-    int colorInt = (color == Color::White) ? 0 : 1;
+    // наши ходы, пропавшие вместе со старым соединением: сервер их ещё ждёт
+    for (size_t i = message.ply; i < moveLog.size(); ++i)
+    {
+        WireMessage move(PacketType::Move);
+        move.move = moveLog[i];
+        send(move);
+    }
+    moveLog.insert(moveLog.end(), message.moves.begin(), message.moves.end());
+    missedMoves.insert(missedMoves.end(), message.moves.begin(), message.moves.end());
+}
+
+void NetworkClient::createRoom()
+{
+    send(WireMessage(PacketType::CreateRoom));
+}
+
+void NetworkClient::joinRoom(const std::string& code)
+{
+    WireMessage message(PacketType::JoinRoom);
+    message.text = code;
+    send(message);
+}
+
+std::string NetworkClient::getRoomCode() const
+{
+    std::lock_guard<std::mutex> lock(roomMutex);
+    return roomCode;
+}
 
-    packet << static_cast<int>(PacketType::GameConfig)
-           << colorInt
-           << timeMinutes
-           << incrementSeconds
-           << gameType
-           << seed;
+std::string NetworkClient::getLastError() const
+{
+    std::lock_guard<std::mutex> lock(roomMutex);
+    return lastError;
+}
 
-    socket.send(packet);
+void NetworkClient::sendGameConfig(Color color, int timeMinutes, int incrementSeconds, int gameType, int seed)
+{
+    WireMessage message(PacketType::GameConfig);
+    message.config.colorInt = (color == Color::White) ? 0 : 1;
+    message.config.timeMinutes = timeMinutes;
+    message.config.incrementSeconds = incrementSeconds;
+    message.config.gameTypeInt = gameType;
+    message.config.seed = seed;
+    send(message);
 }
 
 bool NetworkClient::waitForStart(Color& assignedColor, int& timeMinutes, int& incrementSeconds, int& gameType, int& seed)
@@ -56,39 +326,42 @@ bool NetworkClient::waitForStart(Color& assignedColor, int& timeMinutes, int& in
         return false;
 
     socket.setBlocking(true);
+    flush();
 
     bool gameStarted = false;
 
     while (!gameStarted)
     {
-        sf::Packet packet;
-        sf::Socket::Status status = socket.receive(packet);
-
-        if (status == sf::Socket::Status::Disconnected)
+        WireMessage message;
+        if (!receive(message))
         {
-            return false;
+            if (!connected)
+                return false;
+            continue;
         }
 
-        if (status == sf::Socket::Status::Done)
+        if (message.type == PacketType::GameConfig)
         {
-            int typeInt;
-            if (packet >> typeInt)
-            {
-                PacketType type = static_cast<PacketType>(typeInt);
-
-                if (type == PacketType::GameConfig)
-                {
-                    int colorInt;
-                    if (packet >> colorInt >> timeMinutes >> incrementSeconds >> gameType >> seed)
-                    {
-                        assignedColor = (colorInt == 0) ? Color::White : Color::Black;
-                    }
-                }
-                else if (type == PacketType::StartGame)
-                {
-                    gameStarted = true;
-                }
-            }
+            assignedColor = (message.config.colorInt == 0) ? Color::White : Color::Black;
+            timeMinutes = message.config.timeMinutes;
+            incrementSeconds = message.config.incrementSeconds;
+            gameType = message.config.gameTypeInt;
+            seed = message.config.seed;
+        }
+        else if (message.type == PacketType::StartGame)
+        {
+            gameStarted = true;
+        }
+        else if (message.type == PacketType::RoomJoined)
+        {
+            std::lock_guard<std::mutex> lock(roomMutex);
+            roomCode = message.text;
+        }
+        else if (message.type == PacketType::RoomError || message.type == PacketType::Disconnect)
+        {
+            std::lock_guard<std::mutex> lock(roomMutex);
+            lastError = (message.type == PacketType::RoomError) ? message.text : "Game mode mismatch";
+            return false;
         }
     }
 
@@ -98,13 +371,15 @@ bool NetworkClient::waitForStart(Color& assignedColor, int& timeMinutes, int& in
 
 void NetworkClient::sendMove(const Move& move)
 {
+    // ход, сделанный без связи, уйдёт после возврата
+    moveLog.push_back(move);
     if (!connected)
         return;
 
-    sf::Packet packet;
-    packet << static_cast<int>(PacketType::Move) << move;
-    
-    if (socket.send(packet) != sf::Socket::Status::Done)
+    WireMessage message(PacketType::Move);
+    message.move = move;
+
+    if (!send(message))
     {
         std::cout << "Warning: Failed to send move packet." << std::endl;
     }
@@ -112,40 +387,48 @@ void NetworkClient::sendMove(const Move& move)
 
 Move NetworkClient::receiveMove()
 {
-    if (!connected)
+    if (!connected && (!resuming || !tryResume()))
+        return Move();
+    if (!flush())
         return Move();
 
-    sf::Packet packet;
-    sf::Socket::Status status = socket.receive(packet);
-
-    if (status == sf::Socket::Status::Done)
+    WireMessage message;
+    while (receive(message))
     {
-        int typeInt;
-        if (packet >> typeInt)
+        if (message.type == PacketType::Move)
         {
-            PacketType type = static_cast<PacketType>(typeInt);
-
-            if (type == PacketType::Move)
-            {
-                Move move;
-                if (packet >> move)
-                    return move;
-            }
-            else if (type == PacketType::GameOver)
-            {
-                std::cout << "Received GameOver signal." << std::endl;
-                peerResignedFlag = true;
-            }
-            else if (type == PacketType::Disconnect)
-            {
-                std::cout << "Opponent disconnected." << std::endl;
-                connected = false;
-            }
+            moveLog.push_back(message.move);
+            return message.move;
+        }
+        else if (message.type == PacketType::Resume)
+        {
+            // следующие ходы ждут, пока игра заберёт пропущенные
+            handleResume(message);
+            return Move();
+        }
+        else if (message.type == PacketType::RoomError)
+        {
+            std::cout << "Server refused: " << message.text << std::endl;
+            connected = false;
+            break;
+        }
+        else if (message.type == PacketType::GameOver)
+        {
+            std::cout << "Received GameOver signal." << std::endl;
+            peerResignedFlag = true;
+        }
+        else if (message.type == PacketType::Adjudication)
+        {
+            std::cout << "Server adjudicated a draw." << std::endl;
+            drawAdjudicatedFlag = true;
+            drawReason = static_cast<DrawReason>(message.result);
+        }
+        else if (message.type == PacketType::Disconnect)
+        {
+            std::cout << "Opponent disconnected." << std::endl;
+            connected = false;
+            break;
         }
-    }
-    else if (status == sf::Socket::Status::Disconnected)
-    {
-        connected = false;
     }
 
     return Move();
@@ -153,16 +436,27 @@ Move NetworkClient::receiveMove()
 
 bool NetworkClient::isConnected()
 {
-    return connected;
+    // пока идёт возврат, партия продолжается: переподключением управляет receiveMove
+    return connected || resuming;
+}
+
+bool NetworkClient::isReconnecting()
+{
+    return resuming;
+}
+
+bool NetworkClient::receiveMissedMoves(std::vector<Move>& moves)
+{
+    if (missedMoves.empty())
+        return false;
+    moves.swap(missedMoves);
+    missedMoves.clear();
+    return true;
 }
 
 void NetworkClient::sendGameOver()
 {
-    if (!connected)
-        return;
-    sf::Packet packet;
-    packet << static_cast<int>(PacketType::GameOver);
-    socket.send(packet);
+    send(WireMessage(PacketType::GameOver));
 }
 
 bool NetworkClient::isPeerResigned()
@@ -175,8 +469,65 @@ bool NetworkClient::isPeerResigned()
     return false;
 }
 
+bool NetworkClient::isDrawAdjudicated(std::string& reason)
+{
+    if (!drawAdjudicatedFlag)
+        return false;
+
+    drawAdjudicatedFlag = false;
+    switch (drawReason)
+    {
+    case DrawReason::Repetition:
+        reason = " (repetition)";
+        break;
+    case DrawReason::FiftyMoves:
+        reason = " (fifty-move rule)";
+        break;
+    case DrawReason::InsufficientMaterial:
+        reason = " (insufficient material)";
+        break;
+    default:
+        reason = " (tablebase)";
+        break;
+    }
+    return true;
+}
+
+bool NetworkClient::hasServerClock()
+{
+    return serverClock;
+}
+
+bool NetworkClient::receiveClock(int& whiteMs, int& blackMs)
+{
+    if (!clockPending)
+        return false;
+    clockPending = false;
+    whiteMs = clockMs[0];
+    blackMs = clockMs[1];
+    return true;
+}
+
+bool NetworkClient::isFlagged(Color& loser)
+{
+    if (flaggedSide < 0)
+        return false;
+    loser = (flaggedSide == 0) ? Color::White : Color::Black;
+    flaggedSide = -1;
+    return true;
+}
+
 void NetworkClient::disconnect()
 {
+    joinResumeAttempt();
     connected = false;
+    resuming = false;
     socket.disconnect();
+}
+
+void NetworkClient::joinResumeAttempt()
+{
+    // попытка сама кончится за время подключения и приветствия
+    if (resumeThread.joinable())
+        resumeThread.join();
 }
\ No newline at end of file
@@ -1,21 +1,85 @@
 #pragma once
 #include "../game_interfaces.h"
 #include "PacketType.h"
+#include "Protocol.h"
 #include "../core/move.h"
 #include <SFML/Network.hpp>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 class NetworkClient : public INetworkInterface
 {
     sf::TcpSocket socket;
     bool connected = false;
     bool peerResignedFlag = false;
+    bool drawAdjudicatedFlag = false;
+    DrawReason drawReason = DrawReason::Tablebase;
+
+    // Часы сервера: последний ещё не взятый ClockSync и сторона, у которой упал флаг
+    bool serverClock = false;
+    bool clockPending = false;
+    int clockMs[2] = { 0, 0 };
+    int flaggedSide = -1;
+
+    // Возврат после обрыва: токен места от сервера, все ходы партии, известные клиенту,
+    // и ходы соперника, присланные сервером, но ещё не взятые игрой
+    std::optional<sf::IpAddress> serverAddress;
+    unsigned short serverPort = 0;
+    std::string sessionToken;
+    std::vector<Move> moveLog;
+    std::vector<Move> missedMoves;
+    bool resuming = false;
+    sf::Clock sinceDrop;
+    sf::Time nextResumeAttempt;
+    // Попытка возврата подключается в своём потоке, чтобы не держать отрисовку.
+    // Пока она идёт, socket, input, output и protocol трогает только этот поток
+    std::thread resumeThread;
+    std::atomic<bool> resumeAttemptDone{ false };
+    bool resumeAttemptOk = false;
+
+    mutable std::mutex roomMutex;
+    std::string roomCode;
+    std::string lastError;
+
+    // Compact, если сервер ответил на приветствие, Legacy - для старых серверов
+    WireProtocol protocol = WireProtocol::Legacy;
+    // Недошедший кадр и разобранные, но ещё не прочитанные сообщения
+    std::vector<uint8_t> input;
+    std::deque<WireMessage> received;
+    // Кадры, которые сокет ещё не принял
+    std::vector<uint8_t> output;
+
+    bool openSocket(const sf::IpAddress& address, unsigned short port, sf::Time timeout = sf::Time::Zero);
+    bool negotiate();
+    bool send(const WireMessage& message);
+    bool flush();
+    // Следующее сообщение сервера; в неблокирующем режиме false - пока ничего не пришло
+    bool receive(WireMessage& message);
+    // Ping, ClockSync, Flag и SessionToken обрабатываются сразу; false - сообщение не из них
+    bool handleControlMessage(const WireMessage& message);
+    // Связь оборвалась: с токеном места партия не кончена, receiveMove пытается в неё вернуться
+    void connectionLost();
+    bool tryResume();
+    void joinResumeAttempt();
+    void handleResume(const WireMessage& message);
 
 public:
     NetworkClient();
     virtual ~NetworkClient();
 
     bool connect(const std::string& ip, unsigned short port);
+    WireProtocol getProtocol() const;
+
+    void createRoom();
+    void joinRoom(const std::string& code);
+    std::string getRoomCode() const;
+    std::string getLastError() const;
 
     void sendGameConfig(Color color, int timeMinutes, int incrementSeconds, int gameType, int seed);
     bool waitForStart(Color& assignedColor, int& timeMinutes, int& incrementSeconds, int& gameType, int& seed);
@@ -25,5 +89,11 @@ public:
     bool isConnected() override;
     void sendGameOver() override;
     bool isPeerResigned() override;
+    bool isDrawAdjudicated(std::string& reason) override;
+    bool hasServerClock() override;
+    bool receiveClock(int& whiteMs, int& blackMs) override;
+    bool isFlagged(Color& loser) override;
+    bool isReconnecting() override;
+    bool receiveMissedMoves(std::vector<Move>& moves) override;
     void disconnect();
 };
\ No newline at end of file
@@ -6,5 +6,27 @@ enum class PacketType
     StartGame = 1,
     GameConfig = 2,
     GameOver = 3,
-    Disconnect = 4
+    Disconnect = 4,
+    Adjudication = 5, // партия завершена сервером вничью, причина - DrawReason (int)
+    CreateRoom = 6,   // новая комната с кодом приглашения
+    JoinRoom = 7,     // вход в комнату по коду (string)
+    RoomJoined = 8,   // ответ сервера: код комнаты игрока (string)
+    RoomError = 9,    // комната не найдена или заполнена (string), соединение закрывается
+    Spectate = 10,    // наблюдение за партией по коду комнаты (string)
+    Snapshot = 11,    // зрителю: начальная позиция (FEN) и все ходы партии, дальше - ходы по одному
+    Ping = 12,        // от сервера: метка времени, клиент сразу возвращает её в Pong
+    Pong = 13,
+    ClockSync = 14,   // от сервера: остаток времени белых и чёрных в мс, после каждого хода
+    Flag = 15,        // от сервера: у стороны (0 - белые) кончилось время, партия окончена
+    SessionToken = 16, // от сервера при старте: ключ места игрока для Resume (string)
+    Resume = 17        // возврат после обрыва: клиент - токен и число своих ходов, сервер - недостающие ходы
+};
+
+// Причина ничьей в Adjudication. Старые клиенты причину не читают и любую такую ничью показывают как ничью по таблицам
+enum class DrawReason
+{
+    Tablebase = 0,
+    Repetition = 1,
+    FiftyMoves = 2,
+    InsufficientMaterial = 3
 };
\ No newline at end of file
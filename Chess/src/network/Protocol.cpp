@@ -0,0 +1,502 @@
+#include "Protocol.h"
+#include <SFML/Network/Packet.hpp>
+#include <algorithm>
+#include <cstring>
+
+static const uint8_t HELLO_MAGIC[3] = { 0xC5, 'C', 'P' };
+static const size_t LEGACY_HEADER_SIZE = 4;
+// Длина кадра до 64 КБ укладывается в 3 байта varint
+static const size_t MAX_VARINT_HEADER = 3;
+// Фигура превращения в компактном ходе, 0 - нет превращения
+static const char* const PROMOTION_NAMES[] = { "", "knight", "bishop", "rook", "queen" };
+static const int PROMOTION_COUNT = 5;
+
+void writeHello(uint8_t* out, uint8_t version)
+{
+    std::memcpy(out, HELLO_MAGIC, sizeof(HELLO_MAGIC));
+    out[3] = version;
+}
+
+uint8_t readHello(const uint8_t* data)
+{
+    return std::memcmp(data, HELLO_MAGIC, sizeof(HELLO_MAGIC)) == 0 ? data[3] : 0;
+}
+
+bool isHelloStart(uint8_t firstByte)
+{
+    return firstByte == HELLO_MAGIC[0];
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Ход в 2 байтах (little-endian): откуда (6) | куда (6) | превращение (3) | рокировка (1).
+// Взятие на проходе не передаётся - получатель находит ход среди своих легальных
+static uint16_t packMove(const Move& move)
+{
+    int from = move.getFrom().getY() * 8 + move.getFrom().getX();
+    int to = move.getTo().getY() * 8 + move.getTo().getX();
+    int promo = 0;
+    if (move.isPromotion())
+    {
+        for (int i = 1; i < PROMOTION_COUNT; ++i)
+        {
+            if (move.getPromotionPiece() == PROMOTION_NAMES[i])
+                promo = i;
+        }
+    }
+    return static_cast<uint16_t>((from & 63) | ((to & 63) << 6) | (promo << 12) | (move.isCastling() ? 1 << 15 : 0));
+}
+
+// Список ходов: число и ходы по 2 байта
+static void putMoves(std::vector<uint8_t>& out, const std::vector<Move>& moves)
+{
+    putVarint(out, static_cast<uint32_t>(moves.size()));
+    for (const Move& move : moves)
+    {
+        uint16_t bits = packMove(move);
+        out.push_back(static_cast<uint8_t>(bits));
+        out.push_back(static_cast<uint8_t>(bits >> 8));
+    }
+}
+
+size_t frameLength(WireProtocol protocol, const uint8_t* data, size_t size)
+{
+    uint32_t length = 0;
+    size_t header = 0;
+
+    if (protocol == WireProtocol::Compact)
+    {
+        while (true)
+        {
+            if (header == size)
+                return 0;
+            if (header == MAX_VARINT_HEADER)
+                return FRAME_MALFORMED;
+            uint8_t byte = data[header];
+            length |= static_cast<uint32_t>(byte & 0x7F) << (7 * header);
+            ++header;
+            if (!(byte & 0x80))
+                break;
+        }
+    }
+    else
+    {
+        if (size < LEGACY_HEADER_SIZE)
+            return 0;
+        length = (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+        header = LEGACY_HEADER_SIZE;
+    }
+
+    if (length > MAX_FRAME_SIZE)
+        return FRAME_MALFORMED;
+    if (size - header < length)
+        return 0;
+    return header + length;
+}
+
+static void appendLegacy(const WireMessage& message, std::vector<uint8_t>& out)
+{
+    sf::Packet packet;
+    packet << static_cast<int>(message.type);
+    switch (message.type)
+    {
+    case PacketType::Move:
+        packet << message.move;
+        break;
+    case PacketType::GameConfig:
+        packet << message.config.colorInt << message.config.timeMinutes << message.config.incrementSeconds
+               << message.config.gameTypeInt << message.config.seed;
+        break;
+    case PacketType::Adjudication:
+    case PacketType::Flag:
+        packet << message.result;
+        break;
+    case PacketType::Ping:
+    case PacketType::Pong:
+        packet << message.stamp;
+        break;
+    case PacketType::ClockSync:
+        packet << message.clockMs[0] << message.clockMs[1];
+        break;
+    case PacketType::JoinRoom:
+    case PacketType::RoomJoined:
+    case PacketType::RoomError:
+    case PacketType::Spectate:
+    case PacketType::SessionToken:
+        packet << message.text;
+        break;
+    case PacketType::Snapshot:
+    case PacketType::Resume:
+        packet << message.text;
+        if (message.type == PacketType::Resume)
+            packet << static_cast<int>(message.ply);
+        packet << static_cast<int>(message.moves.size());
+        for (const Move& move : message.moves)
+            packet << move;
+        break;
+    default:
+        break;
+    }
+
+    uint32_t length = static_cast<uint32_t>(packet.getDataSize());
+    out.push_back(static_cast<uint8_t>(length >> 24));
+    out.push_back(static_cast<uint8_t>(length >> 16));
+    out.push_back(static_cast<uint8_t>(length >> 8));
+    out.push_back(static_cast<uint8_t>(length));
+    const uint8_t* data = static_cast<const uint8_t*>(packet.getData());
+    out.insert(out.end(), data, data + length);
+}
+
+static void appendCompact(const WireMessage& message, std::vector<uint8_t>& out)
+{
+    out.push_back(static_cast<uint8_t>(message.type));
+    switch (message.type)
+    {
+    case PacketType::Move:
+    {
+        uint16_t bits = packMove(message.move);
+        out.push_back(static_cast<uint8_t>(bits));
+        out.push_back(static_cast<uint8_t>(bits >> 8));
+        break;
+    }
+    case PacketType::GameConfig:
+        out.push_back(static_cast<uint8_t>(message.config.colorInt));
+        putVarint(out, static_cast<uint32_t>(message.config.timeMinutes));
+        putVarint(out, static_cast<uint32_t>(message.config.incrementSeconds));
+        out.push_back(static_cast<uint8_t>(message.config.gameTypeInt));
+        putVarint(out, static_cast<uint32_t>(message.config.seed));
+        break;
+    case PacketType::Adjudication:
+        putVarint(out, static_cast<uint32_t>(message.result));
+        break;
+    case PacketType::Flag:
+        out.push_back(static_cast<uint8_t>(message.result));
+        break;
+    case PacketType::Ping:
+    case PacketType::Pong:
+        putVarint(out, message.stamp);
+        break;
+    case PacketType::ClockSync:
+        putVarint(out, static_cast<uint32_t>(std::max(0, message.clockMs[0])));
+        putVarint(out, static_cast<uint32_t>(std::max(0, message.clockMs[1])));
+        break;
+    case PacketType::JoinRoom:
+    case PacketType::RoomJoined:
+    case PacketType::RoomError:
+    case PacketType::Spectate:
+    case PacketType::SessionToken:
+        putVarint(out, static_cast<uint32_t>(message.text.size()));
+        out.insert(out.end(), message.text.begin(), message.text.end());
+        break;
+    case PacketType::Snapshot:
+        putVarint(out, static_cast<uint32_t>(message.text.size()));
+        out.insert(out.end(), message.text.begin(), message.text.end());
+        putMoves(out, message.moves);
+        break;
+    case PacketType::Resume:
+        putVarint(out, static_cast<uint32_t>(message.text.size()));
+        out.insert(out.end(), message.text.begin(), message.text.end());
+        putVarint(out, message.ply);
+        putMoves(out, message.moves);
+        break;
+    default:
+        break;
+    }
+}
+
+static void putFrameHeader(std::vector<uint8_t>& out, size_t bodyStart)
+{
+    uint32_t length = static_cast<uint32_t>(out.size() - bodyStart);
+    uint8_t header[MAX_VARINT_HEADER];
+    size_t headerSize = 0;
+    do
+    {
+        header[headerSize] = static_cast<uint8_t>(length & 0x7F);
+        length >>= 7;
+        if (length)
+            header[headerSize] |= 0x80;
+        ++headerSize;
+    } while (length && headerSize < MAX_VARINT_HEADER);
+    out.insert(out.begin() + bodyStart, header, header + headerSize);
+}
+
+bool appendFrames(WireProtocol protocol, const WireMessage* messages, size_t count, std::vector<uint8_t>& out)
+{
+    size_t start = out.size();
+    if (protocol != WireProtocol::Compact)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t frameStart = out.size();
+            appendLegacy(messages[i], out);
+            if (out.size() - frameStart - LEGACY_HEADER_SIZE > MAX_FRAME_SIZE)
+            {
+                out.resize(start);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // длина становится известна после тела: заголовок вставляется перед ним
+    size_t bodyStart = out.size();
+    for (size_t i = 0; i < count; ++i)
+        appendCompact(messages[i], out);
+    if (out.size() - bodyStart <= MAX_FRAME_SIZE)
+    {
+        putFrameHeader(out, bodyStart);
+        return true;
+    }
+
+    // вместе не помещаются - по кадру на сообщение; получатель разбирает их в том же порядке
+    out.resize(start);
+    for (size_t i = 0; i < count; ++i)
+    {
+        bodyStart = out.size();
+        appendCompact(messages[i], out);
+        if (out.size() - bodyStart > MAX_FRAME_SIZE)
+        {
+            out.resize(start);
+            return false;
+        }
+        putFrameHeader(out, bodyStart);
+    }
+    return true;
+}
+
+FrameReader::FrameReader(WireProtocol protocol, const uint8_t* frame, size_t length)
+    : protocol(protocol)
+    , data(frame)
+    , size(length)
+{
+    if (protocol == WireProtocol::Compact)
+    {
+        while (pos < size && (data[pos] & 0x80))
+            ++pos;
+        ++pos;
+    }
+    else
+    {
+        pos = LEGACY_HEADER_SIZE;
+    }
+}
+
+bool FrameReader::readByte(uint8_t& value)
+{
+    if (pos >= size)
+        return false;
+    value = data[pos++];
+    return true;
+}
+
+bool FrameReader::readVarint(uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte;
+        if (!readByte(byte))
+            return false;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool FrameReader::readText(std::string& text)
+{
+    uint32_t length;
+    if (!readVarint(length) || length > size - pos)
+        return false;
+    text.assign(reinterpret_cast<const char*>(data + pos), length);
+    pos += length;
+    return true;
+}
+
+bool FrameReader::readMove(Move& move)
+{
+    uint8_t low, high;
+    if (!readByte(low) || !readByte(high))
+        return false;
+    uint16_t bits = static_cast<uint16_t>(low | (high << 8));
+    int from = bits & 63, to = (bits >> 6) & 63, promo = (bits >> 12) & 7;
+    if (promo >= PROMOTION_COUNT)
+        return false;
+    move = Move(Position(from & 7, from >> 3), Position(to & 7, to >> 3),
+        (bits >> 15) != 0, promo != 0, false, PROMOTION_NAMES[promo]);
+    return true;
+}
+
+bool FrameReader::readMoves(std::vector<Move>& moves)
+{
+    uint32_t count;
+    if (!readVarint(count) || count > (size - pos) / 2)
+        return false;
+    moves.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        moves.emplace_back();
+        if (!readMove(moves.back()))
+            return false;
+    }
+    return true;
+}
+
+bool FrameReader::next(WireMessage& message)
+{
+    if (broken || pos >= size)
+        return false;
+    if (protocol != WireProtocol::Compact)
+        return nextLegacy(message);
+
+    // остальные поля не сбрасываются: на горячем пути (ходы) это лишние копирования строк
+    uint8_t type;
+    readByte(type);
+    message.type = static_cast<PacketType>(type);
+
+    bool ok = true;
+    switch (message.type)
+    {
+    case PacketType::Move:
+        ok = readMove(message.move);
+        break;
+    case PacketType::GameConfig:
+    {
+        uint8_t color, gameType;
+        uint32_t minutes, increment, seed;
+        ok = readByte(color) && readVarint(minutes) && readVarint(increment) && readByte(gameType) && readVarint(seed);
+        if (!ok)
+            break;
+        message.config.colorInt = color;
+        message.config.timeMinutes = static_cast<int>(minutes);
+        message.config.incrementSeconds = static_cast<int>(increment);
+        message.config.gameTypeInt = gameType;
+        message.config.seed = static_cast<int>(seed);
+        break;
+    }
+    case PacketType::Adjudication:
+    {
+        uint32_t result;
+        ok = readVarint(result);
+        if (ok)
+            message.result = static_cast<int>(result);
+        break;
+    }
+    case PacketType::Flag:
+    {
+        uint8_t side;
+        ok = readByte(side) && side < 2;
+        if (ok)
+            message.result = side;
+        break;
+    }
+    case PacketType::Ping:
+    case PacketType::Pong:
+        ok = readVarint(message.stamp);
+        break;
+    case PacketType::ClockSync:
+    {
+        uint32_t white, black;
+        ok = readVarint(white) && readVarint(black);
+        if (!ok)
+            break;
+        message.clockMs[0] = static_cast<int>(white);
+        message.clockMs[1] = static_cast<int>(black);
+        break;
+    }
+    case PacketType::JoinRoom:
+    case PacketType::RoomJoined:
+    case PacketType::RoomError:
+    case PacketType::Spectate:
+    case PacketType::SessionToken:
+        ok = readText(message.text);
+        break;
+    case PacketType::Snapshot:
+        ok = readText(message.text) && readMoves(message.moves);
+        break;
+    case PacketType::Resume:
+        ok = readText(message.text) && readVarint(message.ply) && readMoves(message.moves);
+        break;
+    case PacketType::StartGame:
+    case PacketType::GameOver:
+    case PacketType::Disconnect:
+    case PacketType::CreateRoom:
+        break;
+    default:
+        // длина неизвестного сообщения неизвестна - дальше кадр не разобрать
+        ok = false;
+        break;
+    }
+
+    broken = !ok;
+    return ok;
+}
+
+// В кадре sf::Packet одно сообщение. Пакет с недостающими полями пропускается, как и раньше
+bool FrameReader::nextLegacy(WireMessage& message)
+{
+    sf::Packet packet;
+    packet.append(data + pos, size - pos);
+    pos = size;
+
+    int typeInt;
+    if (!(packet >> typeInt))
+        return false;
+    message = WireMessage(static_cast<PacketType>(typeInt));
+
+    switch (message.type)
+    {
+    case PacketType::Move:
+        return static_cast<bool>(packet >> message.move);
+    case PacketType::GameConfig:
+        return static_cast<bool>(packet >> message.config.colorInt >> message.config.timeMinutes
+            >> message.config.incrementSeconds >> message.config.gameTypeInt >> message.config.seed);
+    case PacketType::Adjudication:
+        packet >> message.result;
+        return true;
+    case PacketType::Flag:
+        return static_cast<bool>(packet >> message.result);
+    case PacketType::Ping:
+    case PacketType::Pong:
+        return static_cast<bool>(packet >> message.stamp);
+    case PacketType::ClockSync:
+        return static_cast<bool>(packet >> message.clockMs[0] >> message.clockMs[1]);
+    case PacketType::JoinRoom:
+    case PacketType::RoomJoined:
+    case PacketType::RoomError:
+    case PacketType::Spectate:
+    case PacketType::SessionToken:
+        return static_cast<bool>(packet >> message.text);
+    case PacketType::Snapshot:
+    case PacketType::Resume:
+    {
+        int ply = 0;
+        int count = 0;
+        if (!(packet >> message.text))
+            return false;
+        if (message.type == PacketType::Resume && (!(packet >> ply) || ply < 0))
+            return false;
+        if (!(packet >> count) || count < 0)
+            return false;
+        message.ply = static_cast<uint32_t>(ply);
+        message.moves.assign(static_cast<size_t>(std::min(count, static_cast<int>(MAX_FRAME_SIZE))), Move());
+        for (Move& move : message.moves)
+        {
+            if (!(packet >> move))
+                return false;
+        }
+        return true;
+    }
+    default:
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include "../core/move.h"
+#include "PacketType.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Форматы сообщений между клиентом и сервером:
+//  Legacy  - sf::Packet: кадр с 4-байтовой длиной, каждое поле - int32, ход - 31 байт;
+//  Compact - кадр с длиной-varint и несколькими сообщениями подряд: тип - 1 байт, ход - 2 байта.
+// Компактный протокол включается приветствием сразу после соединения. Старый клиент начинает
+// с длины sf::Packet (старший байт всегда 0) и остаётся на Legacy; старый сервер на приветствие
+// не отвечает, и новый клиент переподключается со старым форматом.
+enum class WireProtocol : uint8_t
+{
+    Unknown, // приветствие ещё не разобрано
+    Legacy,
+    Compact
+};
+
+constexpr uint8_t COMPACT_VERSION = 3;
+// С этой версии клиент понимает Ping, ClockSync и Flag, и часы партии может вести сервер
+constexpr uint8_t CLOCK_VERSION = 2;
+// С этой версии клиент получает SessionToken и после обрыва может вернуться в партию через Resume
+constexpr uint8_t RESUME_VERSION = 3;
+constexpr size_t HELLO_SIZE = 4;
+// Не больше, чем нужно самому длинному сообщению; всё длиннее - испорченный поток
+constexpr size_t MAX_FRAME_SIZE = 64 * 1024;
+// frameLength: кадр длиннее MAX_FRAME_SIZE или заголовок испорчен
+constexpr size_t FRAME_MALFORMED = static_cast<size_t>(-1);
+
+// Настройки партии из GameConfig
+struct RoomConfig
+{
+    int colorInt = 0; // 0 - White, 1 - Black
+    int timeMinutes = 10;
+    int incrementSeconds = 0;
+    int gameTypeInt = 0;
+    int seed = 0;
+};
+
+// Разобранное сообщение; какие поля заполнены, зависит от типа
+struct WireMessage
+{
+    PacketType type = PacketType::Disconnect;
+    Move move;          // Move
+    RoomConfig config;  // GameConfig
+    int result = 0;     // Adjudication; сторона в Flag
+    uint32_t stamp = 0; // Ping, Pong
+    uint32_t ply = 0;   // Resume: сколько ходов партии уже есть у клиента, перед moves
+    int clockMs[2] = { 0, 0 }; // ClockSync: белые, чёрные
+    std::string text;   // JoinRoom, RoomJoined, RoomError, Spectate, SessionToken; FEN в Snapshot, токен в Resume
+    std::vector<Move> moves; // Snapshot, Resume
+
+    WireMessage() = default;
+    explicit WireMessage(PacketType type)
+        : type(type)
+    {
+    }
+};
+
+// Приветствие: 0xC5 'C' 'P' и версия. Сервер отвечает тем же с версией, на которой договорились
+void writeHello(uint8_t* out, uint8_t version);
+// Версия из приветствия; 0 - это не приветствие
+uint8_t readHello(const uint8_t* data);
+// Первый байт потока от клиента, по которому его можно отличить от кадра sf::Packet
+bool isHelloStart(uint8_t firstByte);
+
+// Длина первого кадра в буфере вместе с заголовком; 0 - кадр пришёл не целиком
+size_t frameLength(WireProtocol protocol, const uint8_t* data, size_t size);
+
+// Дописывает сообщения в конец out. Compact кладёт их в один кадр, Legacy - по кадру на сообщение.
+// Кадр не длиннее MAX_FRAME_SIZE: иначе Compact делит сообщения по кадрам, а если не помещается
+// одно сообщение - возвращает false и оставляет out без изменений
+bool appendFrames(WireProtocol protocol, const WireMessage* messages, size_t count, std::vector<uint8_t>& out);
+
+// Сообщения одного кадра; компактный кадр читается прямо из буфера приёма, без копирования
+class FrameReader
+{
+public:
+    // frame и length - кадр целиком, как его нашла frameLength
+    FrameReader(WireProtocol protocol, const uint8_t* frame, size_t length);
+
+    // false - сообщения кончились или кадр испорчен (тогда failed())
+    bool next(WireMessage& message);
+    bool failed() const { return broken; }
+
+private:
+    WireProtocol protocol;
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool broken = false;
+
+    bool readByte(uint8_t& value);
+    bool readVarint(uint32_t& value);
+    bool readText(std::string& text);
+    bool readMove(Move& move);
+    bool readMoves(std::vector<Move>& moves);
+    bool nextLegacy(WireMessage& message);
+};
\ No newline at end of file
@@ -0,0 +1,542 @@
+#include "Reactor.h"
+#include <chrono>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef REACTOR_EPOLL
+#include <sys/epoll.h>
+#endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+static const size_t READ_CHUNK = 16 * 1024;
+// Столько неразобранных байт честный клиент не присылает
+static const size_t MAX_INPUT = 1 << 20;
+static const int MAX_EVENTS = 256;
+// Отметки очереди на отправку. Партия занимает сотни байт, так что верхняя - это клиент,
+// который давно не читает; за MAX_OUTPUT он отключается, чтобы не держать память сервера
+static const size_t OUTPUT_LOW_WATERMARK = 16 * 1024;
+static const size_t OUTPUT_HIGH_WATERMARK = 64 * 1024;
+static const size_t MAX_OUTPUT = 1 << 20;
+static const ConnectionId WAKE_ID = 0;
+// Без eventfd wake() некому прервать ожидание: poll просыпается сам с таким периодом
+static const int WAKE_INTERVAL_MS = 10;
+// Сколько закрываемое соединение может дописывать очередь; получателя, который не читает, дальше не ждём
+static const int64_t CLOSE_LINGER_MS = 5000;
+
+Reactor::Reactor()
+    : timers(now())
+{
+#ifdef REACTOR_EPOLL
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+        std::cerr << "Error: epoll_create1 failed" << std::endl;
+#endif
+#ifdef __linux__
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+#ifdef REACTOR_EPOLL
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+#endif
+}
+
+Reactor::~Reactor()
+{
+    for (auto& [id, conn] : connections)
+        closeSocket(conn->socket);
+    connections.clear();
+#ifdef REACTOR_EPOLL
+    if (epollFd != -1)
+        ::close(epollFd);
+#endif
+#ifdef __linux__
+    if (wakeFd != -1)
+        ::close(wakeFd);
+#endif
+}
+
+void Reactor::wake()
+{
+#ifdef __linux__
+    if (!wakePending.exchange(true))
+    {
+        uint64_t one = 1;
+        if (::write(wakeFd, &one, sizeof(one)) < 0)
+            wakePending = false;
+    }
+#endif
+}
+
+void Reactor::poll(int timeoutMs)
+{
+    // данные, поставленные в очередь вне poll (например, при adopt), не должны ждать событий
+    if (!dirtyList.empty() || !closeList.empty() || !detachList.empty())
+        finishIteration();
+
+    // не проспать ближайший срок колеса таймеров; без таймеров poll спит сколько просили
+    int untilTimer = timers.timeUntilNext(now());
+    if (untilTimer >= 0 && (timeoutMs < 0 || untilTimer < timeoutMs))
+        timeoutMs = untilTimer;
+
+#ifdef REACTOR_EPOLL
+    epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+
+    for (int i = 0; i < count; ++i)
+    {
+        ConnectionId id = static_cast<ConnectionId>(events[i].data.u64);
+        if (id == WAKE_ID)
+        {
+            uint64_t value;
+            while (::read(wakeFd, &value, sizeof(value)) > 0)
+                ;
+            wakePending = false;
+            continue;
+        }
+
+        auto it = connections.find(id);
+        if (it == connections.end())
+            continue;
+        Connection& conn = *it->second;
+
+        // при обрыве дочитываем то, что успело прийти, recv вернёт 0
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            readAll(id, conn);
+        if (events[i].events & EPOLLOUT)
+            flush(id, conn);
+    }
+#else
+    std::vector<pollfd> fds;
+    std::vector<ConnectionId> ids;
+    fds.reserve(connections.size() + 1);
+    ids.reserve(connections.size() + 1);
+
+#ifdef __linux__
+    fds.push_back({ wakeFd, POLLIN, 0 });
+    ids.push_back(WAKE_ID);
+#else
+    if (timeoutMs < 0 || timeoutMs > WAKE_INTERVAL_MS)
+        timeoutMs = WAKE_INTERVAL_MS;
+#endif
+    for (auto& [id, conn] : connections)
+    {
+        short events = conn->congested ? 0 : POLLIN;
+        if (conn->pending() > 0)
+            events |= POLLOUT;
+        fds.push_back({ conn->socket, events, 0 });
+        ids.push_back(id);
+    }
+
+#ifdef _WIN32
+    int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+    int count = ::poll(fds.data(), fds.size(), timeoutMs);
+#endif
+
+    for (size_t i = 0; count > 0 && i < fds.size(); ++i)
+    {
+        if (fds[i].revents == 0)
+            continue;
+        --count;
+
+#ifdef __linux__
+        if (ids[i] == WAKE_ID)
+        {
+            uint64_t value;
+            while (::read(wakeFd, &value, sizeof(value)) > 0)
+                ;
+            wakePending = false;
+            continue;
+        }
+#endif
+
+        auto it = connections.find(ids[i]);
+        if (it == connections.end())
+            continue;
+        Connection& conn = *it->second;
+
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            readAll(ids[i], conn);
+        if (fds[i].revents & POLLOUT)
+            flush(ids[i], conn);
+    }
+#endif
+
+    timers.advance(now());
+    finishIteration();
+}
+
+int64_t Reactor::now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TimerId Reactor::schedule(int64_t deadlineMs, TimerWheel::Callback callback)
+{
+    return timers.schedule(deadlineMs, std::move(callback));
+}
+
+void Reactor::cancel(TimerId id)
+{
+    if (id != NO_TIMER)
+        timers.cancel(id);
+}
+
+ConnectionId Reactor::adopt(SocketHandoff&& handoff)
+{
+    NativeSocket s = handoff.socket;
+    if (!setNonBlocking(s))
+    {
+        closeSocket(s);
+        return WAKE_ID;
+    }
+
+    ConnectionId id = nextId++;
+    if (nextId == WAKE_ID)
+        nextId = 1;
+
+#ifdef REACTOR_EPOLL
+    // если в сокете уже есть данные, epoll сообщит о них сразу после добавления
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.u64 = id;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, s, &ev) != 0)
+    {
+        closeSocket(s);
+        return WAKE_ID;
+    }
+#endif
+
+    auto owned = std::make_unique<Connection>();
+    Connection& conn = *owned;
+    conn.socket = s;
+    conn.output.write(handoff.output.data(), handoff.output.size());
+    connections[id] = std::move(owned);
+    if (!conn.output.empty())
+    {
+        conn.dirty = true;
+        dirtyList.push_back(id);
+    }
+
+    if (onOpen)
+        onOpen(id);
+    if (!handoff.input.empty())
+        deliver(id, conn, handoff.input.data(), handoff.input.size());
+    if (conn.broken)
+        close(id);
+    return id;
+}
+
+void Reactor::detach(ConnectionId id, HandoffSink sink)
+{
+    auto it = connections.find(id);
+    if (it == connections.end() || it->second->closing || it->second->detachSink)
+        return;
+    it->second->detachSink = std::move(sink);
+    detachList.push_back(id);
+}
+
+void Reactor::readAll(ConnectionId id, Connection& conn)
+{
+    uint8_t chunk[READ_CHUNK];
+
+    // в edge-triggered режиме новое событие придёт только после того, как сокет опустеет;
+    // уходящее к другому реактору соединение дочитает он сам, а перегруженное - flush, когда очередь спадёт
+    while (!conn.broken && !conn.detachSink && !conn.congested)
+    {
+        long received = receiveSome(conn.socket, chunk, READ_CHUNK);
+        if (received == 0)
+        {
+            conn.broken = true;
+            break;
+        }
+        if (received < 0)
+        {
+            if (socketInterrupted())
+                continue;
+            if (!socketWouldBlock())
+                conn.broken = true;
+            break;
+        }
+        deliver(id, conn, chunk, static_cast<size_t>(received));
+    }
+
+    if (conn.broken)
+        close(id);
+}
+
+void Reactor::deliver(ConnectionId id, Connection& conn, const uint8_t* data, size_t size)
+{
+    if (conn.closing || conn.detachSink || !onData)
+        return;
+
+    // обычно приходят целые пакеты: разбираем прямо из принятого куска и копируем только хвост
+    if (conn.input.empty())
+    {
+        size_t consumed = onData(id, data, size);
+        conn.input.assign(data + consumed, data + size);
+    }
+    else
+    {
+        conn.input.insert(conn.input.end(), data, data + size);
+        size_t consumed = onData(id, conn.input.data(), conn.input.size());
+        conn.input.erase(conn.input.begin(), conn.input.begin() + consumed);
+    }
+
+    if (conn.input.size() > MAX_INPUT)
+        conn.broken = true;
+}
+
+void Reactor::flush(ConnectionId id, Connection& conn)
+{
+    while (true)
+    {
+        const uint8_t* data;
+        size_t length;
+        if (!conn.output.empty())
+        {
+            data = conn.output.front(length);
+        }
+        else if (!conn.shared.empty())
+        {
+            data = conn.shared.front()->data() + conn.sharedSent;
+            length = conn.shared.front()->size() - conn.sharedSent;
+        }
+        else
+        {
+            break;
+        }
+
+        long sent = sendSome(conn.socket, data, length);
+        if (sent > 0)
+        {
+            if (!conn.output.empty())
+            {
+                conn.output.consume(static_cast<size_t>(sent));
+                continue;
+            }
+            conn.sharedSent += static_cast<size_t>(sent);
+            conn.sharedBytes -= static_cast<size_t>(sent);
+            if (conn.sharedSent == conn.shared.front()->size())
+            {
+                conn.shared.pop_front();
+                conn.sharedSent = 0;
+            }
+            continue;
+        }
+        if (sent < 0 && socketInterrupted())
+            continue;
+        // сокет заполнен - допишем по событию готовности к записи
+        if (sent < 0 && socketWouldBlock())
+            break;
+
+        conn.broken = true;
+        close(id);
+        return;
+    }
+
+    if (conn.congested && conn.pending() <= OUTPUT_LOW_WATERMARK)
+    {
+        conn.congested = false;
+        if (onCongestion)
+            onCongestion(id, false);
+        // запросы, пришедшие за время паузы, событием уже не придут
+        readAll(id, conn);
+    }
+}
+
+Reactor::Connection* Reactor::prepareSend(ConnectionId id, size_t size)
+{
+    auto it = connections.find(id);
+    if (it == connections.end() || it->second->broken)
+        return nullptr;
+    Connection& conn = *it->second;
+
+    if (conn.pending() + size > MAX_OUTPUT)
+    {
+        std::cerr << "Connection " << id << " does not read its data, dropping it" << std::endl;
+        conn.broken = true;
+        close(id);
+        return nullptr;
+    }
+    return &conn;
+}
+
+void Reactor::queued(ConnectionId id, Connection& conn)
+{
+    if (!conn.congested && conn.pending() > OUTPUT_HIGH_WATERMARK)
+    {
+        conn.congested = true;
+        if (onCongestion)
+            onCongestion(id, true);
+    }
+    if (!conn.dirty)
+    {
+        conn.dirty = true;
+        dirtyList.push_back(id);
+    }
+}
+
+void Reactor::send(ConnectionId id, const uint8_t* data, size_t size)
+{
+    Connection* conn = prepareSend(id, size);
+    if (!conn || size == 0)
+        return;
+
+    if (conn->shared.empty())
+    {
+        conn->output.write(data, size);
+    }
+    else
+    {
+        conn->shared.push_back(std::make_shared<const std::vector<uint8_t>>(data, data + size));
+        conn->sharedBytes += size;
+    }
+    queued(id, *conn);
+}
+
+void Reactor::sendShared(ConnectionId id, const SharedBuffer& buffer)
+{
+    Connection* conn = prepareSend(id, buffer->size());
+    if (!conn || buffer->empty())
+        return;
+
+    conn->shared.push_back(buffer);
+    conn->sharedBytes += buffer->size();
+    queued(id, *conn);
+}
+
+void Reactor::close(ConnectionId id)
+{
+    auto it = connections.find(id);
+    if (it == connections.end() || it->second->closing)
+        return;
+    it->second->closing = true;
+    it->second->lingerTimer = timers.schedule(now() + CLOSE_LINGER_MS, [this, id]() {
+        auto conn = connections.find(id);
+        if (conn == connections.end())
+            return;
+        conn->second->lingerTimer = NO_TIMER;
+        destroy(id);
+    });
+    closeList.push_back(id);
+}
+
+void Reactor::finishIteration()
+{
+    // обработчики закрытия могут отправлять данные и закрывать другие соединения
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+
+        std::vector<ConnectionId> dirty;
+        dirty.swap(dirtyList);
+        for (ConnectionId id : dirty)
+        {
+            auto it = connections.find(id);
+            if (it == connections.end())
+                continue;
+            it->second->dirty = false;
+            flush(id, *it->second);
+        }
+        // отправки из обработчиков спада очереди (снимок для отставшего зрителя)
+        if (!dirtyList.empty())
+            progress = true;
+
+        std::vector<ConnectionId> detaching;
+        detaching.swap(detachList);
+        for (ConnectionId id : detaching)
+        {
+            auto it = connections.find(id);
+            if (it == connections.end() || it->second->closing)
+                continue;
+
+            Connection& conn = *it->second;
+            SocketHandoff handoff;
+            handoff.socket = conn.socket;
+            handoff.input = std::move(conn.input);
+            conn.output.copyTo(handoff.output);
+            for (size_t i = 0; i < conn.shared.size(); ++i)
+            {
+                const std::vector<uint8_t>& buffer = *conn.shared[i];
+                handoff.output.insert(handoff.output.end(), buffer.begin() + (i == 0 ? conn.sharedSent : 0), buffer.end());
+            }
+            HandoffSink sink = std::move(conn.detachSink);
+
+            release(conn);
+            connections.erase(it);
+            sink(std::move(handoff));
+        }
+
+        std::vector<ConnectionId> pending;
+        pending.swap(closeList);
+        for (ConnectionId id : pending)
+        {
+            auto it = connections.find(id);
+            if (it == connections.end())
+                continue;
+            Connection& conn = *it->second;
+            if (conn.broken || conn.pending() == 0)
+            {
+                destroy(id);
+                progress = true;
+            }
+            else
+            {
+                closeList.push_back(id);
+            }
+        }
+    }
+}
+
+void Reactor::release(Connection& conn)
+{
+    cancel(conn.lingerTimer);
+    conn.lingerTimer = NO_TIMER;
+#ifdef REACTOR_EPOLL
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.socket, nullptr);
+#endif
+}
+
+void Reactor::destroy(ConnectionId id)
+{
+    auto it = connections.find(id);
+    if (it == connections.end())
+        return;
+
+    release(*it->second);
+    closeSocket(it->second->socket);
+    connections.erase(it);
+
+    if (onClose)
+        onClose(id);
+}
+
+size_t Reactor::getConnectionCount() const
+{
+    return connections.size();
+}
+
+size_t Reactor::getPendingOutput(ConnectionId id) const
+{
+    auto it = connections.find(id);
+    return it == connections.end() ? 0 : it->second->pending();
+}
+
+std::string Reactor::getRemoteAddress(ConnectionId id) const
+{
+    auto it = connections.find(id);
+    return it == connections.end() ? "" : peerAddress(it->second->socket);
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+#include "RingBuffer.h"
+#include "Sockets.h"
+#include "TimerWheel.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// На Linux - epoll в edge-triggered режиме; в остальных системах и при CHESS_SERVER_POLL
+// (для сравнения) - poll/WSAPoll, который на каждом пробуждении проходит все соединения
+#if defined(__linux__) && !defined(CHESS_SERVER_POLL)
+#define REACTOR_EPOLL 1
+#endif
+
+using ConnectionId = uint32_t;
+// Неизменяемый буфер рассылки: кодируется один раз и ставится в очередь многим соединениям
+using SharedBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Цикл событий сервера на неблокирующих сокетах. У каждого соединения свои буферы:
+// принятые байты копятся, пока обработчик не разберёт их целиком, исходящие -
+// пока сокет их не примет. Обрабатываются только соединения, на которых есть события.
+// Медленный получатель не тормозит остальных: когда у него копится больше верхней отметки,
+// реактор перестаёт читать его запросы до спада ниже нижней, а за пределом очереди отключает.
+// Таймеры (часы партий, пинги) срабатывают в том же потоке, без опроса каждой партии.
+// Все методы, кроме wake() и now(), вызываются из потока, который крутит poll().
+class Reactor
+{
+public:
+    // Возвращает, сколько байт с начала буфера разобрано; остаток ждёт следующего чтения
+    using DataHandler = std::function<size_t(ConnectionId id, const uint8_t* data, size_t size)>;
+    using EventHandler = std::function<void(ConnectionId id)>;
+    using HandoffSink = std::function<void(SocketHandoff&& handoff)>;
+    using CongestionHandler = std::function<void(ConnectionId id, bool congested)>;
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // Одна итерация: ждёт события не дольше timeoutMs (-1 - без ограничения) и обрабатывает их
+    // вместе с наступившими таймерами
+    void poll(int timeoutMs);
+    // Прерывает ожидание в poll(); можно звать из любого потока
+    void wake();
+
+    // Берёт сокет на обслуживание; уже принятые байты сразу уходят обработчику.
+    // 0 - сокет зарегистрировать не удалось, он закрыт
+    ConnectionId adopt(SocketHandoff&& handoff);
+    // Отдаёт соединение вместе с неразобранными байтами, не закрывая сокет. onClose не вызывается.
+    void detach(ConnectionId id, HandoffSink sink);
+
+    void setOnOpen(EventHandler callback) { onOpen = callback; }
+    void setOnData(DataHandler callback) { onData = callback; }
+    // Вызывается один раз для каждого соединения: при обрыве, ошибке или после close()
+    void setOnClose(EventHandler callback) { onClose = callback; }
+    // Очередь на отправку прошла верхнюю отметку (true) или спала до нижней (false)
+    void setOnCongestion(CongestionHandler callback) { onCongestion = callback; }
+
+    // Данные уходят в сокет в конце итерации, одним вызовом на соединение.
+    // Получатель, у которого не ушло больше MAX_OUTPUT, отключается
+    void send(ConnectionId id, const uint8_t* data, size_t size);
+    // То же без копирования: соединение держит ссылку на буфер, пока не отправит его
+    void sendShared(ConnectionId id, const SharedBuffer& buffer);
+    // Закрывает соединение, когда уже поставленные в очередь данные отправлены,
+    // но ждёт их не дольше нескольких секунд
+    void close(ConnectionId id);
+
+    // Монотонное время в мс
+    static int64_t now();
+    // callback вызывается из poll() не раньше deadlineMs (по now()), то есть в потоке шарда;
+    // ставить и снимать таймеры можно только из него же
+    TimerId schedule(int64_t deadlineMs, TimerWheel::Callback callback);
+    // NO_TIMER и уже сработавшие таймеры пропускаются
+    void cancel(TimerId id);
+
+    size_t getConnectionCount() const;
+    // Байты, которые ждут отправки
+    size_t getPendingOutput(ConnectionId id) const;
+    std::string getRemoteAddress(ConnectionId id) const;
+
+private:
+    struct Connection
+    {
+        NativeSocket socket;
+        std::vector<uint8_t> input;
+        RingBuffer output;
+        // Общие буферы уходят после байтов output. Пока они есть, новые байты тоже встают
+        // в эту очередь, иначе обогнали бы их
+        std::deque<SharedBuffer> shared;
+        size_t sharedSent = 0;  // из первого общего буфера
+        size_t sharedBytes = 0; // ещё не отправлено из общих буферов
+        // очередь выше верхней отметки: новые запросы не читаются
+        bool congested = false;
+        bool closing = false;
+        // после close(): по истечении соединение закрывается, даже если очередь не ушла
+        TimerId lingerTimer = NO_TIMER;
+        bool broken = false;
+        bool dirty = false;
+        HandoffSink detachSink;
+
+        size_t pending() const { return output.size() + sharedBytes; }
+    };
+
+#ifdef REACTOR_EPOLL
+    int epollFd = -1;
+#endif
+#ifdef __linux__
+    int wakeFd = -1;
+#endif
+    std::atomic<bool> wakePending{ false };
+
+    std::unordered_map<ConnectionId, std::unique_ptr<Connection>> connections;
+    ConnectionId nextId = 1;
+    // Соединения с новыми исходящими данными, закрываемые и передаваемые в конце итерации
+    std::vector<ConnectionId> dirtyList;
+    std::vector<ConnectionId> closeList;
+    std::vector<ConnectionId> detachList;
+    TimerWheel timers;
+
+    EventHandler onOpen;
+    DataHandler onData;
+    EventHandler onClose;
+    CongestionHandler onCongestion;
+
+    void readAll(ConnectionId id, Connection& conn);
+    void deliver(ConnectionId id, Connection& conn, const uint8_t* data, size_t size);
+    void flush(ConnectionId id, Connection& conn);
+    Connection* prepareSend(ConnectionId id, size_t size);
+    void queued(ConnectionId id, Connection& conn);
+    void finishIteration();
+    void release(Connection& conn);
+    void destroy(ConnectionId id);
+};
\ No newline at end of file
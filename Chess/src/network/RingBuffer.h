@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Кольцевой буфер байт - очередь исходящих данных соединения. Ёмкость - степень двойки,
+// растёт удвоением и не уменьшается: после первой партии соединение пишет в уже выделенную память,
+// а частичная отправка не сдвигает оставшиеся байты.
+class RingBuffer
+{
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void write(const uint8_t* data, size_t length)
+    {
+        if (count + length > capacity)
+            grow(count + length);
+
+        size_t tail = (head + count) & (capacity - 1);
+        size_t first = std::min(length, capacity - tail);
+        std::memcpy(buffer.get() + tail, data, first);
+        std::memcpy(buffer.get(), data + first, length - first);
+        count += length;
+    }
+
+    // Непрерывный кусок с начала очереди; остаток после него - в начале памяти
+    const uint8_t* front(size_t& length) const
+    {
+        length = std::min(count, capacity - head);
+        return buffer.get() + head;
+    }
+
+    void consume(size_t length)
+    {
+        count -= length;
+        head = count == 0 ? 0 : (head + length) & (capacity - 1);
+    }
+
+    void copyTo(std::vector<uint8_t>& out) const
+    {
+        size_t first = std::min(count, capacity - head);
+        out.insert(out.end(), buffer.get() + head, buffer.get() + head + first);
+        out.insert(out.end(), buffer.get(), buffer.get() + (count - first));
+    }
+
+private:
+    static const size_t INITIAL_CAPACITY = 4096;
+
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t count = 0;
+
+    void grow(size_t needed)
+    {
+        size_t newCapacity = std::max(capacity, INITIAL_CAPACITY);
+        while (newCapacity < needed)
+            newCapacity *= 2;
+
+        auto newBuffer = std::make_unique<uint8_t[]>(newCapacity);
+        size_t first = std::min(count, capacity - head);
+        if (count > 0)
+        {
+            std::memcpy(newBuffer.get(), buffer.get() + head, first);
+            std::memcpy(newBuffer.get() + first, buffer.get(), count - first);
+        }
+        buffer = std::move(newBuffer);
+        capacity = newCapacity;
+        head = 0;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,387 @@
+#include "Room.h"
+#include "../core/board.h"
+#include <algorithm>
+#include <iostream>
+
+// Имена фигур превращения в Move, по PieceType
+static const char* const PROMOTION_NAMES[] = { "", "knight", "bishop", "rook", "queen" };
+// 50 ходов каждой стороны без взятий и ходов пешкой
+static const int FIFTY_MOVE_PLIES = 100;
+
+// Легальный ход позиции с теми же полями и фигурой превращения. У короля Фишера на одно поле
+// может вести и обычный ход, и рокировка - тогда выбираем по флагу рокировки из хода клиента
+static FastMove findLegalMove(const FastBoard& position, const Move& move)
+{
+    int from = squareOf(move.getFrom().getX(), move.getFrom().getY());
+    int to = squareOf(move.getTo().getX(), move.getTo().getY());
+    std::string promo = move.getPromotionPiece();
+
+    MoveList list;
+    position.generateMoves(list);
+
+    FastMove found = NO_MOVE;
+    for (FastMove m : list)
+    {
+        if (moveFrom(m) != from || moveTo(m) != to)
+            continue;
+        if (isPromotion(m) && promo != PROMOTION_NAMES[promotionType(m)])
+            continue;
+        if ((moveFlag(m) == FLAG_CASTLING) == move.isCastling())
+            return m;
+        found = m;
+    }
+    return found;
+}
+
+// Ход для пересылки: флаги берутся из позиции, а не из присланного клиентом
+static Move toClientMove(FastMove m)
+{
+    bool promotion = isPromotion(m);
+    return Move(Position(fileOf(moveFrom(m)), rankOf(moveFrom(m))),
+        Position(fileOf(moveTo(m)), rankOf(moveTo(m))),
+        moveFlag(m) == FLAG_CASTLING,
+        promotion,
+        moveFlag(m) == FLAG_EN_PASSANT,
+        promotion ? PROMOTION_NAMES[promotionType(m)] : "");
+}
+
+Room::Room(const std::string& code)
+    : code(code)
+{
+}
+
+const std::string& Room::getCode() const
+{
+    return code;
+}
+
+int Room::slotOf(SessionId session) const
+{
+    if (session == NO_SESSION)
+        return -1;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (players[i] == session)
+            return i;
+    }
+    return -1;
+}
+
+SessionId Room::getPlayer(int slot) const
+{
+    return players[slot];
+}
+
+SessionId Room::opponentOf(SessionId session) const
+{
+    int slot = slotOf(session);
+    return slot == -1 ? NO_SESSION : players[1 - slot];
+}
+
+SessionId Room::playerToMove() const
+{
+    // хост играет цветом из своего конфига
+    return players[position.sideToMove() == configs[0].colorInt ? 0 : 1];
+}
+
+int Room::addPlayer(SessionId session)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (players[i] == NO_SESSION)
+        {
+            players[i] = session;
+            ready[i] = false;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Room::removePlayer(SessionId session)
+{
+    int slot = slotOf(session);
+    if (slot == -1)
+        return;
+    players[slot] = NO_SESSION;
+    ready[slot] = false;
+}
+
+void Room::setPlayer(int slot, SessionId session)
+{
+    players[slot] = session;
+}
+
+bool Room::isFull() const
+{
+    return players[0] != NO_SESSION && players[1] != NO_SESSION;
+}
+
+bool Room::isEmpty() const
+{
+    return players[0] == NO_SESSION && players[1] == NO_SESSION;
+}
+
+void Room::setConfig(int slot, const RoomConfig& config)
+{
+    configs[slot] = config;
+    ready[slot] = true;
+}
+
+bool Room::bothReady() const
+{
+    return isFull() && ready[0] && ready[1];
+}
+
+bool Room::modesMatch() const
+{
+    return configs[0].gameTypeInt == configs[1].gameTypeInt;
+}
+
+const RoomConfig& Room::getHostConfig() const
+{
+    return configs[0];
+}
+
+void Room::start(int fallbackSeed)
+{
+    started = true;
+
+    RoomConfig& host = configs[0];
+    if (host.gameTypeInt == 0)
+    {
+        startFen = FastBoard::START_FEN;
+    }
+    else
+    {
+        if (host.seed == 0)
+            host.seed = fallbackSeed;
+        // та же расстановка, что построят у себя клиенты
+        Board board(std::make_unique<Fischer>(host.seed), 0, 0);
+        startFen = board.getFen();
+    }
+    position.setFen(startFen);
+    keys.assign(1, position.getKey());
+}
+
+bool Room::isStarted() const
+{
+    return started;
+}
+
+std::optional<Move> Room::playMove(SessionId player, const Move& move, int64_t nowMs, int lagCreditMs)
+{
+    int slot = slotOf(player);
+    if (!started || slot == -1 || !move.isValid())
+        return std::nullopt;
+
+    int side = (slot == 0) ? configs[0].colorInt : 1 - configs[0].colorInt;
+    if (side != position.sideToMove())
+        return std::nullopt;
+
+    FastMove m = findLegalMove(position, move);
+    if (m == NO_MOVE)
+        return std::nullopt;
+
+    if (clockRunning)
+    {
+        int64_t spent = std::max<int64_t>(0, nowMs - turnStartedMs - lagCreditMs);
+        remainingMs[side] += incrementMs - spent;
+        turnStartedMs = nowMs;
+    }
+
+    Move relayed = toClientMove(m);
+    UndoInfo undo;
+    position.makeMove(m, undo);
+    moves.push_back(relayed);
+    keys.push_back(position.getKey());
+    checkGameEnd();
+    return relayed;
+}
+
+void Room::checkGameEnd()
+{
+    MoveList list;
+    position.generateMoves(list);
+    if (list.size == 0)
+    {
+        // мат и пат клиенты видят сами
+        finish();
+        return;
+    }
+
+    DrawReason reason;
+    if (isThreefoldRepetition())
+        reason = DrawReason::Repetition;
+    else if (position.getHalfmoveClock() >= FIFTY_MOVE_PLIES)
+        reason = DrawReason::FiftyMoves;
+    else if (position.isInsufficientMaterial())
+        reason = DrawReason::InsufficientMaterial;
+    else
+        return;
+
+    std::cout << "Room " << code << ": draw by rule (" << static_cast<int>(reason) << "): " << position.getFen() << std::endl;
+    WireMessage adjudication(PacketType::Adjudication);
+    adjudication.result = static_cast<int>(reason);
+    finish(adjudication);
+}
+
+bool Room::isThreefoldRepetition() const
+{
+    // повториться могут только позиции после последнего взятия или хода пешкой, с той же очередью хода
+    size_t last = keys.size() - 1;
+    size_t reversible = std::min<size_t>(last, static_cast<size_t>(position.getHalfmoveClock()));
+    int count = 1;
+    for (size_t back = 2; back <= reversible; back += 2)
+    {
+        if (keys[last - back] == keys[last] && ++count == 3)
+            return true;
+    }
+    return false;
+}
+
+bool Room::isDeadDraw(const Tablebase& tablebase) const
+{
+    if (position.pieceCount() > std::max(2, tablebase.getMaxPieces()))
+        return false;
+
+    auto result = tablebase.probe(position);
+    if (!result || result->wdl != 0)
+        return false;
+
+    std::cout << "Room " << code << ": dead draw by tablebase: " << position.getFen() << std::endl;
+    return true;
+}
+
+void Room::startClock(int64_t nowMs)
+{
+    const RoomConfig& host = configs[0];
+    remainingMs[0] = remainingMs[1] = static_cast<int64_t>(host.timeMinutes) * 60 * 1000;
+    incrementMs = static_cast<int64_t>(host.incrementSeconds) * 1000;
+    turnStartedMs = nowMs;
+    clockRunning = true;
+}
+
+bool Room::isClockRunning() const
+{
+    return clockRunning;
+}
+
+void Room::finish(std::optional<WireMessage> outcome)
+{
+    // исход - первый: сдача после упавшего флага партию уже не меняет
+    if (!finished)
+        this->outcome = std::move(outcome);
+    finished = true;
+    clockRunning = false;
+}
+
+bool Room::isFinished() const
+{
+    return finished;
+}
+
+const std::optional<WireMessage>& Room::getOutcome() const
+{
+    return outcome;
+}
+
+WireMessage Room::getClockSync(int64_t nowMs) const
+{
+    WireMessage sync(PacketType::ClockSync);
+    for (int color = 0; color < 2; ++color)
+    {
+        int64_t remaining = remainingMs[color];
+        if (clockRunning && color == position.sideToMove())
+            remaining -= std::max<int64_t>(0, nowMs - turnStartedMs);
+        sync.clockMs[color] = static_cast<int>(std::max<int64_t>(0, remaining));
+    }
+    return sync;
+}
+
+int Room::sideToMove() const
+{
+    return position.sideToMove();
+}
+
+int64_t Room::getFlagDeadline(int lagCreditMs) const
+{
+    return turnStartedMs + remainingMs[position.sideToMove()] + lagCreditMs;
+}
+
+TimerId Room::getFlagTimer() const
+{
+    return flagTimer;
+}
+
+void Room::setFlagTimer(TimerId timer)
+{
+    flagTimer = timer;
+}
+
+const std::string& Room::getToken(int slot) const
+{
+    return tokens[slot];
+}
+
+void Room::setToken(int slot, const std::string& token)
+{
+    tokens[slot] = token;
+}
+
+// Сравнение за время, не зависящее от того, где строки расходятся: по времени ответа токен не подобрать
+static bool equalTokens(const std::string& a, const std::string& b)
+{
+    if (a.empty() || a.size() != b.size())
+        return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+int Room::slotOfToken(const std::string& token) const
+{
+    bool matches[2] = { equalTokens(tokens[0], token), equalTokens(tokens[1], token) };
+    return matches[0] ? 0 : matches[1] ? 1 : -1;
+}
+
+TimerId Room::getGraceTimer(int slot) const
+{
+    return graceTimers[slot];
+}
+
+void Room::setGraceTimer(int slot, TimerId timer)
+{
+    graceTimers[slot] = timer;
+}
+
+const std::string& Room::getStartFen() const
+{
+    return startFen;
+}
+
+const std::vector<Move>& Room::getMoves() const
+{
+    return moves;
+}
+
+void Room::addSpectator(SessionId session)
+{
+    spectators.push_back(session);
+}
+
+void Room::removeSpectator(SessionId session)
+{
+    auto it = std::find(spectators.begin(), spectators.end(), session);
+    if (it == spectators.end())
+        return;
+    // порядок зрителей не важен
+    *it = spectators.back();
+    spectators.pop_back();
+}
+
+const std::vector<SessionId>& Room::getSpectators() const
+{
+    return spectators;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include "../core/FastBoard.h"
+#include "../core/Tablebase.h"
+#include "../core/move.h"
+#include "Protocol.h"
+#include "TimerWheel.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+using SessionId = uint32_t;
+static const SessionId NO_SESSION = 0;
+
+// Партия на сервере: два места для сессий игроков, зрители и состояние игры.
+// Место 0 - хост, его настройки применяются к партии.
+class Room
+{
+public:
+    explicit Room(const std::string& code);
+
+    const std::string& getCode() const;
+
+    // Номер места сессии или -1
+    int slotOf(SessionId session) const;
+    SessionId getPlayer(int slot) const;
+    SessionId opponentOf(SessionId session) const;
+    // Игрок, чья очередь ходить
+    SessionId playerToMove() const;
+
+    // Занимает свободное место; -1, если комната заполнена
+    int addPlayer(SessionId session);
+    void removePlayer(SessionId session);
+    // Возвращает игрока на его место после обрыва
+    void setPlayer(int slot, SessionId session);
+    bool isFull() const;
+    bool isEmpty() const;
+
+    // Конфиг игрока; партия готова к старту, когда конфиги прислали оба
+    void setConfig(int slot, const RoomConfig& config);
+    bool bothReady() const;
+    bool modesMatch() const;
+    const RoomConfig& getHostConfig() const;
+
+    // Расстановку Фишера без seed выбирает сервер (fallbackSeed), чтобы она совпала у обоих клиентов
+    void start(int fallbackSeed);
+    bool isStarted() const;
+
+    // Проверяет ход игрока по позиции партии и делает его. Возвращает ход в том виде,
+    // в каком его надо переслать сопернику; nullopt - не его очередь или ход не легален.
+    // Если часы у сервера, списывает с ходившего время с начала хода (nowMs, монотонные мс)
+    // за вычетом зачёта задержки и добавляет ему инкремент.
+    // Мат, пат, троекратное повторение, правило 50 ходов и недостаточный материал заканчивают
+    // партию (finish); ничью по правилам outcome хранит как Adjudication с причиной
+    std::optional<Move> playMove(SessionId player, const Move& move, int64_t nowMs, int lagCreditMs);
+    // Ничья по таблицам эндшпиля в текущей позиции
+    bool isDeadDraw(const Tablebase& tablebase) const;
+
+    // Часы партии ведёт сервер, только если оба клиента это умеют; иначе часы у клиентов
+    void startClock(int64_t nowMs);
+    bool isClockRunning() const;
+    // Партия окончена (флаг, сдача, мат, присуждение): часы стоят, ходы больше не принимаются.
+    // outcome - сообщение, которым партию закончил сервер или соперник; мат и пат клиент видит сам
+    void finish(std::optional<WireMessage> outcome = std::nullopt);
+    bool isFinished() const;
+    const std::optional<WireMessage>& getOutcome() const;
+    // Сообщение ClockSync с остатком времени обеих сторон на nowMs: у стороны, которая ходит,
+    // вычтено время с начала хода (сразу после хода это ноль)
+    WireMessage getClockSync(int64_t nowMs) const;
+    // Цвет стороны, которая ходит (0 - белые)
+    int sideToMove() const;
+    // Момент, когда у стороны, которая ходит, кончится время с учётом зачёта задержки
+    int64_t getFlagDeadline(int lagCreditMs) const;
+    // Таймер реактора, который проверит флаг к этому моменту
+    TimerId getFlagTimer() const;
+    void setFlagTimer(TimerId timer);
+
+    // Токен места для возврата после обрыва; пустой - игроку токен не выдавался
+    const std::string& getToken(int slot) const;
+    void setToken(int slot, const std::string& token);
+    // Место с этим токеном или -1
+    int slotOfToken(const std::string& token) const;
+    // Таймер, по которому место отключившегося игрока перестаёт его ждать
+    TimerId getGraceTimer(int slot) const;
+    void setGraceTimer(int slot, TimerId timer);
+
+    // Начальная позиция и сыгранные ходы - снимок для зрителя, пришедшего посреди партии,
+    // и журнал, из которого вернувшийся игрок получает пропущенные ходы
+    const std::string& getStartFen() const;
+    const std::vector<Move>& getMoves() const;
+
+    void addSpectator(SessionId session);
+    void removeSpectator(SessionId session);
+    const std::vector<SessionId>& getSpectators() const;
+
+private:
+    std::string code;
+    SessionId players[2] = { NO_SESSION, NO_SESSION };
+    RoomConfig configs[2];
+    bool ready[2] = { false, false };
+    bool started = false;
+    bool finished = false;
+    bool clockRunning = false;
+    int64_t remainingMs[2] = { 0, 0 }; // по цвету
+    int64_t incrementMs = 0;
+    int64_t turnStartedMs = 0;
+    TimerId flagTimer = NO_TIMER;
+    std::optional<WireMessage> outcome;
+    std::string tokens[2];
+    TimerId graceTimers[2] = { NO_TIMER, NO_TIMER };
+    std::string startFen;
+    std::vector<Move> moves;
+    // ключи всех позиций партии - для троекратного повторения
+    std::vector<uint64_t> keys;
+    std::vector<SessionId> spectators;
+
+    // Позиция партии на битбордах: проверка хода - генерация легальных ходов без выделений памяти
+    FastBoard position;
+
+    void checkGameEnd();
+    bool isThreefoldRepetition() const;
+};
\ No newline at end of file
@@ -1,16 +1,29 @@
 #include "chessServer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
-int main()
+int main(int argc, char* argv[])
 {
     unsigned short port = 53000;
+    // 0 - по числу ядер
+    size_t threads = 0;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "-port") == 0)
+            port = static_cast<unsigned short>(std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "-threads") == 0)
+            threads = static_cast<size_t>(std::max(0, std::atoi(argv[i + 1])));
+    }
 
     std::cout << "--- Chess Server (SFML 3.0) ---" << std::endl;
     std::cout << "Initializing on port " << port << "..." << std::endl;
 
     try
     {
-        ChessServer server(port);
+        ChessServer server(port, threads);
         server.run();
     }
     catch (const std::exception& e)
@@ -0,0 +1,837 @@
+#include "ServerShard.h"
+#include "chessServer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+
+// Первый символ кода определяет шард комнаты, поэтому шардов не больше, чем символов
+static const char ROOM_CODE_ALPHABET[] = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
+static const int ROOM_CODE_ALPHABET_SIZE = sizeof(ROOM_CODE_ALPHABET) - 1;
+static const int ROOM_CODE_LENGTH = 6;
+static const size_t INBOX_CAPACITY = 4096;
+// Ход идёт до сервера, а ход соперника - до игрока: зачёт задержки - время пинга,
+// но не больше этого, чтобы игрок не выигрывал время, придерживая Pong
+static const int MAX_LAG_CREDIT_MS = 500;
+static const int64_t PING_INTERVAL_MS = 5000;
+// Ответ дольше - чужая или испорченная метка
+static const uint32_t MAX_RTT_SAMPLE_MS = 60 * 1000;
+// Сколько место игрока с токеном ждёт его после обрыва; часы партии при этом идут
+static const int64_t RECONNECT_GRACE_MS = 60 * 1000;
+// Токен места - код комнаты (по нему находится шард) и 128 случайных бит из генератора ОС
+static const int TOKEN_RANDOM_WORDS = 4;
+
+// Сообщения о часах понимают только клиенты с CLOCK_VERSION
+static bool isClockMessage(PacketType type)
+{
+    return type == PacketType::Ping || type == PacketType::ClockSync || type == PacketType::Flag;
+}
+
+static std::string normalizeCode(const std::string& code)
+{
+    std::string normalized = code;
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+        [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return normalized;
+}
+
+ServerShard::ServerShard(ChessServer& server, size_t index, size_t shardCount, const Tablebase& tablebase)
+    : server(server)
+    , index(index)
+    , shardCount(shardCount)
+    , tablebase(tablebase)
+    , inbox(INBOX_CAPACITY)
+    , rng(std::random_device{}())
+{
+    reactor.setOnOpen([this](ConnectionId id) { openSession(id); });
+    reactor.setOnData([this](ConnectionId id, const uint8_t* data, size_t size) { return handleData(id, data, size); });
+    reactor.setOnClose([this](ConnectionId id) { closeSession(id); });
+    reactor.setOnCongestion([this](ConnectionId id, bool congested) { handleCongestion(id, congested); });
+}
+
+void ServerShard::run()
+{
+    while (true)
+    {
+        SocketHandoff handoff;
+        while (inbox.tryPop(handoff))
+        {
+            adoptedProtocol = static_cast<WireProtocol>(handoff.protocol);
+            adoptedVersion = handoff.version;
+            reactor.adopt(std::move(handoff));
+        }
+        reactor.poll(-1);
+    }
+}
+
+void ServerShard::handoff(SocketHandoff&& socket)
+{
+    inbox.push(std::move(socket));
+    reactor.wake();
+}
+
+size_t ServerShard::shardOfCode(const std::string& code, size_t shardCount)
+{
+    const char* found = code.empty() ? nullptr : std::strchr(ROOM_CODE_ALPHABET, code[0]);
+    if (!found || code[0] == '\0')
+        return shardCount;
+    return static_cast<size_t>(found - ROOM_CODE_ALPHABET) % shardCount;
+}
+
+size_t ServerShard::getMaxShards()
+{
+    return ROOM_CODE_ALPHABET_SIZE;
+}
+
+std::ostream& ServerShard::log()
+{
+    return std::cout << "[" << index << "] ";
+}
+
+void ServerShard::openSession(SessionId id)
+{
+    // переехавшее из другого шарда соединение уже договорилось о протоколе
+    sessions[id].protocol = adoptedProtocol;
+    sessions[id].version = adoptedVersion;
+    adoptedProtocol = WireProtocol::Unknown;
+    adoptedVersion = 0;
+    log() << "Session " << id << " connected: " << reactor.getRemoteAddress(id)
+          << " (sessions: " << sessions.size() << ", rooms: " << rooms.size() << ")" << std::endl;
+}
+
+size_t ServerShard::handleData(SessionId id, const uint8_t* data, size_t size)
+{
+    size_t offset = 0;
+    WireProtocol protocol = sessions[id].protocol;
+
+    if (protocol == WireProtocol::Unknown)
+    {
+        // старый клиент сразу шлёт кадр sf::Packet, новый - приветствие компактного протокола
+        protocol = isHelloStart(data[0]) ? WireProtocol::Compact : WireProtocol::Legacy;
+        if (protocol == WireProtocol::Compact)
+        {
+            if (size < HELLO_SIZE)
+                return 0;
+            uint8_t version = readHello(data);
+            if (version == 0)
+            {
+                log() << "Session " << id << " sent a bad greeting" << std::endl;
+                reactor.close(id);
+                return size;
+            }
+            uint8_t reply[HELLO_SIZE];
+            sessions[id].version = std::min(version, COMPACT_VERSION);
+            writeHello(reply, sessions[id].version);
+            reactor.send(id, reply, HELLO_SIZE);
+            offset = HELLO_SIZE;
+        }
+        sessions[id].protocol = protocol;
+    }
+
+    while (offset < size)
+    {
+        size_t length = frameLength(protocol, data + offset, size - offset);
+        if (length == 0)
+            break;
+
+        if (length == FRAME_MALFORMED)
+        {
+            log() << "Session " << id << " sent an oversized frame" << std::endl;
+            reactor.close(id);
+            return size;
+        }
+
+        FrameReader reader(protocol, data + offset, length);
+        WireMessage message;
+        bool keep = true;
+        while (keep && reader.next(message))
+            keep = processMessage(id, message);
+
+        if (reader.failed())
+        {
+            log() << "Session " << id << " sent a malformed frame" << std::endl;
+            reactor.close(id);
+            return size;
+        }
+        // соединение уходит в другой шард или закрыто. Переезд вызывают только первые
+        // сообщения клиента (вход в комнату), поэтому кадр целиком разберёт новый шард
+        if (!keep)
+            break;
+        offset += length;
+    }
+    return offset;
+}
+
+bool ServerShard::processMessage(SessionId id, const WireMessage& message)
+{
+    Room* room = sessions[id].room;
+    // зритель только смотрит
+    if (sessions[id].spectator)
+        return true;
+
+    if (message.type == PacketType::Move)
+    {
+        // ход, догнавший уже упавший флаг, просто опоздал
+        if (room && room->isStarted() && !room->isFinished())
+            return playMove(id, *room, message.move);
+    }
+    else if (message.type == PacketType::Pong)
+    {
+        handlePong(id, message.stamp);
+    }
+    else if (message.type == PacketType::GameOver)
+    {
+        relayToOpponent(id, WireMessage(PacketType::GameOver));
+        if (room)
+        {
+            room->finish(WireMessage(PacketType::GameOver));
+            broadcast(*room, WireMessage(PacketType::GameOver));
+        }
+    }
+    else if (message.type == PacketType::GameConfig)
+    {
+        // без комнаты - общая очередь, она живёт в шарде 0
+        if (!room && index != 0)
+        {
+            migrate(id, 0);
+            return false;
+        }
+        handleConfig(id, message.config);
+    }
+    else if (message.type == PacketType::CreateRoom)
+    {
+        createRoom(id);
+    }
+    else if (message.type == PacketType::JoinRoom)
+    {
+        size_t target = shardOfCode(normalizeCode(message.text), shardCount);
+        if (!room && target != index && target < shardCount)
+        {
+            migrate(id, target);
+            return false;
+        }
+        joinRoom(id, message.text);
+    }
+    else if (message.type == PacketType::Spectate)
+    {
+        size_t target = shardOfCode(normalizeCode(message.text), shardCount);
+        if (!room && target != index && target < shardCount)
+        {
+            migrate(id, target);
+            return false;
+        }
+        spectate(id, message.text);
+    }
+    else if (message.type == PacketType::Resume)
+    {
+        size_t target = shardOfCode(normalizeCode(message.text), shardCount);
+        if (!room && target != index && target < shardCount)
+        {
+            migrate(id, target);
+            return false;
+        }
+        resumeGame(id, normalizeCode(message.text), message.ply);
+    }
+    return true;
+}
+
+void ServerShard::migrate(SessionId id, size_t target)
+{
+    WireProtocol protocol = sessions[id].protocol;
+    uint8_t version = sessions[id].version;
+    sessions.erase(id);
+    reactor.detach(id, [this, target, protocol, version](SocketHandoff&& socket) {
+        socket.protocol = static_cast<uint8_t>(protocol);
+        socket.version = version;
+        server.handoff(target, std::move(socket));
+    });
+}
+
+std::string ServerShard::generateRoomCode()
+{
+    std::uniform_int_distribution<int> pick(0, ROOM_CODE_ALPHABET_SIZE - 1);
+    // первый символ - из тех, что указывают на этот шард
+    int firstChoices = (ROOM_CODE_ALPHABET_SIZE - static_cast<int>(index) + static_cast<int>(shardCount) - 1) / static_cast<int>(shardCount);
+    std::uniform_int_distribution<int> pickFirst(0, firstChoices - 1);
+    std::string code;
+    do
+    {
+        code.assign(1, ROOM_CODE_ALPHABET[index + shardCount * pickFirst(rng)]);
+        for (int i = 1; i < ROOM_CODE_LENGTH; ++i)
+            code += ROOM_CODE_ALPHABET[pick(rng)];
+    } while (rooms.count(code));
+    return code;
+}
+
+Room* ServerShard::enterRoom(SessionId id, Room& room)
+{
+    if (room.addPlayer(id) == -1)
+        return nullptr;
+    sessions[id].room = &room;
+
+    WireMessage reply(PacketType::RoomJoined);
+    reply.text = room.getCode();
+    sendTo(id, reply);
+    return &room;
+}
+
+void ServerShard::createRoom(SessionId id)
+{
+    if (sessions[id].room)
+        return;
+
+    std::string code = generateRoomCode();
+    Room& room = *(rooms[code] = std::make_unique<Room>(code));
+    enterRoom(id, room);
+    log() << "Session " << id << " created room " << code << " (rooms: " << rooms.size() << ")" << std::endl;
+}
+
+void ServerShard::joinRoom(SessionId id, const std::string& code)
+{
+    if (sessions[id].room)
+        return;
+
+    std::string normalized = normalizeCode(code);
+
+    auto it = rooms.find(normalized);
+    if (it == rooms.end())
+    {
+        rejectSession(id, "Room " + normalized + " not found");
+        return;
+    }
+    if (!enterRoom(id, *it->second))
+    {
+        rejectSession(id, "Room " + normalized + " is full");
+        return;
+    }
+    log() << "Session " << id << " joined room " << normalized << std::endl;
+}
+
+void ServerShard::spectate(SessionId id, const std::string& code)
+{
+    Session& session = sessions[id];
+    if (session.room)
+        return;
+
+    std::string normalized = normalizeCode(code);
+    auto it = rooms.find(normalized);
+    if (it == rooms.end())
+    {
+        rejectSession(id, "Room " + normalized + " not found");
+        return;
+    }
+
+    Room& room = *it->second;
+    room.addSpectator(id);
+    session.room = &room;
+    session.spectator = true;
+
+    WireMessage reply(PacketType::RoomJoined);
+    reply.text = room.getCode();
+    sendTo(id, reply);
+    // до старта снимок придёт всем зрителям вместе с игроками
+    if (room.isStarted())
+        sendSnapshot(id, room);
+    log() << "Session " << id << " is watching room " << normalized
+          << " (spectators: " << room.getSpectators().size() << ")" << std::endl;
+}
+
+void ServerShard::sendSnapshot(SessionId id, const Room& room)
+{
+    // дальше зритель получает ходы по мере игры
+    WireMessage snapshot(PacketType::Snapshot);
+    snapshot.text = room.getStartFen();
+    snapshot.moves = room.getMoves();
+    if (!sendTo(id, snapshot))
+        rejectSession(id, "Game is too long to watch");
+}
+
+void ServerShard::handleCongestion(SessionId id, bool congested)
+{
+    log() << "Session " << id << (congested ? " is not reading, its input paused (" : " caught up (")
+          << reactor.getPendingOutput(id) << " bytes queued)" << std::endl;
+
+    auto it = sessions.find(id);
+    if (it == sessions.end() || !it->second.spectator)
+        return;
+
+    Session& session = it->second;
+    if (congested)
+    {
+        session.lagging = true;
+    }
+    else
+    {
+        // пропущенные ходы заменяет свежий снимок
+        session.lagging = false;
+        if (session.missedMoves && session.room)
+            sendSnapshot(id, *session.room);
+        session.missedMoves = false;
+    }
+}
+
+Room* ServerShard::quickMatch(SessionId id)
+{
+    auto it = rooms.find(openRoomCode);
+    if (it != rooms.end() && !it->second->isFull())
+    {
+        openRoomCode.clear();
+        return enterRoom(id, *it->second);
+    }
+
+    openRoomCode = generateRoomCode();
+    Room& room = *(rooms[openRoomCode] = std::make_unique<Room>(openRoomCode));
+    return enterRoom(id, room);
+}
+
+void ServerShard::handleConfig(SessionId id, const RoomConfig& config)
+{
+    Room* room = sessions[id].room;
+    if (!room)
+        room = quickMatch(id);
+    if (!room || room->isStarted())
+        return;
+
+    int slot = room->slotOf(id);
+    room->setConfig(slot, config);
+    log() << "Room " << room->getCode() << ": player " << slot << " config received. Mode: " << config.gameTypeInt << std::endl;
+
+    if (!room->bothReady())
+        return;
+
+    if (room->modesMatch())
+        startGame(*room);
+    else
+        abortGame(*room);
+}
+
+void ServerShard::startGame(Room& room)
+{
+    room.start(std::uniform_int_distribution<int>(1, std::numeric_limits<int>::max())(rng));
+
+    const RoomConfig& host = room.getHostConfig();
+    bool clocked = host.timeMinutes > 0 && clockAware(room.getPlayer(0)) && clockAware(room.getPlayer(1));
+    if (clocked)
+        room.startClock(reactor.now());
+    log() << "Room " << room.getCode() << " started: Host=" << (host.colorInt == 0 ? "White" : "Black")
+          << ", Time=" << host.timeMinutes << "+" << host.incrementSeconds
+          << ", Mode=" << host.gameTypeInt << (clocked ? ", server clock" : "") << std::endl;
+
+    // конфиг, часы, токен места и старт - одним кадром
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        SessionId player = room.getPlayer(slot);
+        WireMessage messages[4] = { WireMessage(PacketType::GameConfig) };
+        size_t count = 1;
+        messages[0].config = host;
+        messages[0].config.colorInt = (slot == 0) ? host.colorInt : 1 - host.colorInt;
+        if (clocked)
+            messages[count++] = room.getClockSync(reactor.now());
+        if (resumable(player))
+        {
+            room.setToken(slot, generateToken(room));
+            messages[count].type = PacketType::SessionToken;
+            messages[count++].text = room.getToken(slot);
+        }
+        messages[count++] = WireMessage(PacketType::StartGame);
+        sendTo(player, messages, count);
+    }
+    if (clocked)
+    {
+        armFlag(room);
+        sendPing(room.getPlayer(0));
+        sendPing(room.getPlayer(1));
+    }
+
+    WireMessage snapshot(PacketType::Snapshot);
+    snapshot.text = room.getStartFen();
+    broadcast(room, snapshot);
+}
+
+bool ServerShard::playMove(SessionId id, Room& room, const Move& move)
+{
+    int64_t now = reactor.now();
+    // таймер флага мог ещё не сработать, но срок уже прошёл
+    if (room.isClockRunning() && now > room.getFlagDeadline(lagCredit(room.playerToMove())))
+    {
+        flagGame(room);
+        return true;
+    }
+
+    std::optional<Move> legal = room.playMove(id, move, now, lagCredit(id));
+    if (!legal)
+    {
+        // честный клиент нелегальных ходов не шлёт: партия засчитывается сопернику, как при сдаче
+        WireMessage forfeit(PacketType::GameOver);
+        relayToOpponent(id, forfeit);
+        broadcast(room, forfeit);
+        room.finish(forfeit);
+        reactor.cancel(room.getFlagTimer());
+        rejectSession(id, "Illegal move");
+        return false;
+    }
+
+    // сопернику ход и часы одним кадром, ходившему - только часы
+    bool clocked = room.isClockRunning();
+    WireMessage relay[2] = { WireMessage(PacketType::Move), room.getClockSync(now) };
+    relay[0].move = *legal;
+    sendTo(room.opponentOf(id), relay, clocked ? 2 : 1);
+    broadcast(room, relay[0]);
+    if (clocked)
+    {
+        sendTo(id, relay[1]);
+        broadcast(room, relay[1]);
+    }
+
+    if (!room.isFinished() && room.isDeadDraw(tablebase))
+    {
+        WireMessage adjudication(PacketType::Adjudication);
+        adjudication.result = static_cast<int>(DrawReason::Tablebase);
+        room.finish(adjudication);
+    }
+    // мат и пат клиенты видят сами, о ничьей по правилам или таблицам им сообщает сервер
+    if (room.isFinished() && room.getOutcome())
+    {
+        sendTo(room.getPlayer(0), *room.getOutcome());
+        sendTo(room.getPlayer(1), *room.getOutcome());
+        broadcast(room, *room.getOutcome());
+    }
+
+    if (room.isClockRunning())
+        armFlag(room);
+    else
+        reactor.cancel(room.getFlagTimer());
+    return true;
+}
+
+void ServerShard::abortGame(Room& room)
+{
+    log() << "Room " << room.getCode() << ": game modes mismatch, closing both players" << std::endl;
+
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        SessionId player = room.getPlayer(slot);
+        sendTo(player, WireMessage(PacketType::Disconnect));
+        sessions[player].room = nullptr;
+        reactor.close(player);
+    }
+    dismissSpectators(room);
+
+    std::string code = room.getCode();
+    if (code == openRoomCode)
+        openRoomCode.clear();
+    rooms.erase(code);
+}
+
+void ServerShard::dismissSpectators(Room& room)
+{
+    broadcast(room, WireMessage(PacketType::Disconnect));
+    for (SessionId spectator : room.getSpectators())
+    {
+        sessions[spectator].room = nullptr;
+        reactor.close(spectator);
+    }
+}
+
+void ServerShard::rejectSession(SessionId id, const std::string& reason)
+{
+    log() << "Session " << id << " rejected: " << reason << std::endl;
+    // место держится только при обрыве связи: отключённый сервером игрок в партию не вернётся
+    Room* room = sessions[id].room;
+    int slot = room ? room->slotOf(id) : -1;
+    if (slot != -1)
+        room->setToken(slot, "");
+    WireMessage error(PacketType::RoomError);
+    error.text = reason;
+    sendTo(id, error);
+    reactor.close(id);
+}
+
+void ServerShard::leaveRoom(SessionId id)
+{
+    Room* room = sessions[id].room;
+    if (!room)
+        return;
+    sessions[id].room = nullptr;
+
+    if (sessions[id].spectator)
+    {
+        room->removeSpectator(id);
+        return;
+    }
+
+    room->removePlayer(id);
+    closeRoom(*room);
+}
+
+void ServerShard::closeRoom(Room& room)
+{
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        SessionId player = room.getPlayer(slot);
+        if (player != NO_SESSION)
+        {
+            sendTo(player, WireMessage(PacketType::Disconnect));
+            room.removePlayer(player);
+            sessions[player].room = nullptr;
+        }
+        reactor.cancel(room.getGraceTimer(slot));
+    }
+    dismissSpectators(room);
+    reactor.cancel(room.getFlagTimer());
+
+    std::string code = room.getCode();
+    if (code == openRoomCode)
+        openRoomCode.clear();
+    rooms.erase(code);
+}
+
+void ServerShard::closeSession(SessionId id)
+{
+    log() << "Session " << id << " disconnected" << std::endl;
+    Room* room = sessions[id].room;
+    int slot = room ? room->slotOf(id) : -1;
+    // идущая партия ждёт игрока с токеном: обрыв связи - ещё не уход из партии
+    if (slot != -1 && room->isStarted() && !room->isFinished() && !room->getToken(slot).empty())
+        holdSeat(id, *room, slot);
+    else
+        leaveRoom(id);
+    reactor.cancel(sessions[id].pingTimer);
+    sessions.erase(id);
+}
+
+void ServerShard::holdSeat(SessionId id, Room& room, int slot)
+{
+    room.removePlayer(id);
+    sessions[id].room = nullptr;
+
+    // без соперника комнату держать незачем
+    if (room.getPlayer(1 - slot) == NO_SESSION && room.getGraceTimer(1 - slot) == NO_TIMER)
+    {
+        closeRoom(room);
+        return;
+    }
+
+    std::string code = room.getCode();
+    room.setGraceTimer(slot, reactor.schedule(reactor.now() + RECONNECT_GRACE_MS, [this, code, slot]() { abandonSeat(code, slot); }));
+    log() << "Room " << code << ": player " << slot << " dropped, seat held for "
+          << RECONNECT_GRACE_MS / 1000 << " s" << std::endl;
+}
+
+void ServerShard::abandonSeat(const std::string& code, int slot)
+{
+    auto it = rooms.find(code);
+    if (it == rooms.end())
+        return;
+
+    Room& room = *it->second;
+    room.setGraceTimer(slot, NO_TIMER);
+    if (room.getPlayer(slot) != NO_SESSION)
+        return;
+    log() << "Room " << code << ": player " << slot << " did not come back" << std::endl;
+    closeRoom(room);
+}
+
+void ServerShard::resumeGame(SessionId id, const std::string& token, uint32_t ply)
+{
+    Session& session = sessions[id];
+    if (session.room)
+        return;
+
+    auto it = rooms.find(token.substr(0, ROOM_CODE_LENGTH));
+    int slot = (it == rooms.end()) ? -1 : it->second->slotOfToken(token);
+    if (slot == -1)
+    {
+        rejectSession(id, "Game to resume not found");
+        return;
+    }
+
+    Room& room = *it->second;
+    // старое соединение ещё не заметило обрыва (мобильная сеть сменила адрес)
+    SessionId stale = room.getPlayer(slot);
+    if (stale != NO_SESSION)
+    {
+        room.removePlayer(stale);
+        sessions[stale].room = nullptr;
+        reactor.close(stale);
+    }
+    reactor.cancel(room.getGraceTimer(slot));
+    room.setGraceTimer(slot, NO_TIMER);
+    room.setPlayer(slot, id);
+    session.room = &room;
+
+    // Клиент знает ply ходов. У сервера их больше - шлём хвост; меньше - клиент
+    // перешлёт свои ходы, не дошедшие до обрыва, увидев, сколько ходов у сервера
+    const std::vector<Move>& moves = room.getMoves();
+    WireMessage reply[3] = { WireMessage(PacketType::Resume) };
+    size_t count = 1;
+    reply[0].ply = std::min<uint32_t>(ply, static_cast<uint32_t>(moves.size()));
+    reply[0].moves.assign(moves.begin() + reply[0].ply, moves.end());
+    if (room.isClockRunning())
+        reply[count++] = room.getClockSync(reactor.now());
+    if (room.getOutcome())
+        reply[count++] = *room.getOutcome();
+    if (!sendTo(id, reply, count))
+    {
+        rejectSession(id, "Game is too long to resume");
+        return;
+    }
+
+    if (room.isClockRunning())
+        sendPing(id);
+    log() << "Session " << id << " resumed room " << room.getCode() << " as player " << slot
+          << " (" << reply[0].moves.size() << " moves replayed)" << std::endl;
+}
+
+bool ServerShard::sendTo(SessionId id, const WireMessage* messages, size_t count)
+{
+    auto it = sessions.find(id);
+    if (it == sessions.end())
+        return false;
+
+    // кодируем в общий буфер шарда: реактор всё равно копирует данные в буфер соединения
+    sendBuffer.clear();
+    if (!appendFrames(it->second.protocol, messages, count, sendBuffer))
+    {
+        log() << "Session " << id << ": message does not fit into a frame, not sent" << std::endl;
+        return false;
+    }
+    reactor.send(id, sendBuffer.data(), sendBuffer.size());
+    return true;
+}
+
+bool ServerShard::sendTo(SessionId id, const WireMessage& message)
+{
+    return sendTo(id, &message, 1);
+}
+
+void ServerShard::relayToOpponent(SessionId sender, const WireMessage& message)
+{
+    Room* room = sessions[sender].room;
+    if (room)
+        sendTo(room->opponentOf(sender), message);
+}
+
+void ServerShard::broadcast(const Room& room, const WireMessage& message)
+{
+    SharedBuffer frames[2];
+    for (SessionId spectator : room.getSpectators())
+    {
+        Session& session = sessions[spectator];
+        if (isClockMessage(message.type) && !clockAware(spectator))
+            continue;
+        if (session.lagging)
+        {
+            session.missedMoves = true;
+            continue;
+        }
+
+        SharedBuffer& frame = frames[session.protocol == WireProtocol::Compact ? 1 : 0];
+        if (!frame)
+        {
+            auto encoded = std::make_shared<std::vector<uint8_t>>();
+            if (!appendFrames(session.protocol, &message, 1, *encoded))
+                return;
+            frame = std::move(encoded);
+        }
+        reactor.sendShared(spectator, frame);
+    }
+}
+
+bool ServerShard::resumable(SessionId id) const
+{
+    auto it = sessions.find(id);
+    return it != sessions.end() && it->second.protocol == WireProtocol::Compact && it->second.version >= RESUME_VERSION;
+}
+
+std::string ServerShard::generateToken(const Room& room)
+{
+    // не из rng шарда: по нескольким выданным значениям mt19937 восстанавливается целиком
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    std::string token = room.getCode();
+    for (int i = 0; i < TOKEN_RANDOM_WORDS; ++i)
+    {
+        uint32_t word = static_cast<uint32_t>(entropy());
+        for (int shift = 28; shift >= 0; shift -= 4)
+            token += HEX_DIGITS[(word >> shift) & 0xF];
+    }
+    return token;
+}
+
+bool ServerShard::clockAware(SessionId id) const
+{
+    auto it = sessions.find(id);
+    return it != sessions.end() && it->second.protocol == WireProtocol::Compact && it->second.version >= CLOCK_VERSION;
+}
+
+int ServerShard::lagCredit(SessionId id) const
+{
+    auto it = sessions.find(id);
+    if (it == sessions.end() || it->second.rttMs < 0)
+        return 0;
+    return std::min(it->second.rttMs, MAX_LAG_CREDIT_MS);
+}
+
+void ServerShard::armFlag(Room& room)
+{
+    reactor.cancel(room.getFlagTimer());
+    std::string code = room.getCode();
+    int64_t deadline = room.getFlagDeadline(lagCredit(room.playerToMove()));
+    room.setFlagTimer(reactor.schedule(deadline + 1, [this, code]() { checkFlag(code); }));
+}
+
+void ServerShard::checkFlag(const std::string& code)
+{
+    auto it = rooms.find(code);
+    if (it == rooms.end() || !it->second->isClockRunning())
+        return;
+
+    Room& room = *it->second;
+    room.setFlagTimer(NO_TIMER);
+    // зачёт задержки мог вырасти с новым пингом - тогда срок отодвигается
+    if (reactor.now() > room.getFlagDeadline(lagCredit(room.playerToMove())))
+        flagGame(room);
+    else
+        armFlag(room);
+}
+
+void ServerShard::flagGame(Room& room)
+{
+    WireMessage flag(PacketType::Flag);
+    flag.result = room.sideToMove();
+    room.finish(flag);
+    reactor.cancel(room.getFlagTimer());
+    room.setFlagTimer(NO_TIMER);
+    log() << "Room " << room.getCode() << ": " << (flag.result == 0 ? "White" : "Black") << " lost on time" << std::endl;
+
+    sendTo(room.getPlayer(0), flag);
+    sendTo(room.getPlayer(1), flag);
+    broadcast(room, flag);
+}
+
+void ServerShard::sendPing(SessionId id)
+{
+    auto it = sessions.find(id);
+    if (it == sessions.end())
+        return;
+    Session& session = it->second;
+    session.pingTimer = NO_TIMER;
+    // задержка нужна только для часов идущей партии
+    if (!session.room || !session.room->isClockRunning())
+        return;
+
+    WireMessage ping(PacketType::Ping);
+    ping.stamp = static_cast<uint32_t>(reactor.now());
+    sendTo(id, ping);
+    session.pingTimer = reactor.schedule(reactor.now() + PING_INTERVAL_MS, [this, id]() { sendPing(id); });
+}
+
+void ServerShard::handlePong(SessionId id, uint32_t stamp)
+{
+    uint32_t sample = static_cast<uint32_t>(reactor.now()) - stamp;
+    if (sample > MAX_RTT_SAMPLE_MS)
+        return;
+
+    int& rtt = sessions[id].rttMs;
+    rtt = (rtt < 0) ? static_cast<int>(sample) : (rtt * 7 + static_cast<int>(sample)) / 8;
+}
\ No newline at end of file
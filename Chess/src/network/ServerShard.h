@@ -0,0 +1,132 @@
+#pragma once
+#include "../core/Tablebase.h"
+#include "../core/move.h"
+#include "LockFreeQueue.h"
+#include "Protocol.h"
+#include "Reactor.h"
+#include "Room.h"
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+class ChessServer;
+
+// Подключённый клиент и комната, в которой он играет или которую смотрит.
+// Id сессии - id соединения в реакторе шарда.
+struct Session
+{
+    Room* room = nullptr;
+    WireProtocol protocol = WireProtocol::Unknown;
+    uint8_t version = 0; // компактного протокола
+    bool spectator = false;
+    // зритель не успевает читать: ходы ему не шлются, и если какие-то пропущены,
+    // по спаду очереди он получит снимок заново
+    bool lagging = false;
+    bool missedMoves = false;
+    // Сглаженное время пинга, мс; -1 - ещё не измерено
+    int rttMs = -1;
+    TimerId pingTimer = NO_TIMER;
+};
+
+// Часть сервера со своим потоком, реактором, сессиями и комнатами. Оба игрока комнаты
+// обслуживаются одним шардом, поэтому состояние партии не делится между потоками.
+// Шард комнаты задан первым символом её кода; клиент, пришедший с кодом чужой комнаты,
+// переезжает в её шард вместе с ещё не разобранными байтами.
+class ServerShard
+{
+public:
+    ServerShard(ChessServer& server, size_t index, size_t shardCount, const Tablebase& tablebase);
+
+    // Цикл потока шарда, не возвращается
+    void run();
+    // Передаёт шарду сокет; можно звать из любого потока
+    void handoff(SocketHandoff&& socket);
+
+    // Номер шарда, которому принадлежит код; shardCount - код не может существовать
+    static size_t shardOfCode(const std::string& code, size_t shardCount);
+    static size_t getMaxShards();
+
+private:
+    ChessServer& server;
+    const size_t index;
+    const size_t shardCount;
+    const Tablebase& tablebase;
+
+    Reactor reactor;
+    LockFreeQueue<SocketHandoff> inbox;
+
+    std::unordered_map<SessionId, Session> sessions;
+    // Комнаты шарда по коду приглашения
+    std::unordered_map<std::string, std::unique_ptr<Room>> rooms;
+    // Комната для клиентов без кода, ждущая второго игрока (только в шарде 0)
+    std::string openRoomCode;
+    std::mt19937 rng;
+    // Криптостойкий генератор ОС для токенов мест
+    std::random_device entropy;
+    // Кадры для отправки собираются здесь, без выделения памяти на каждое сообщение
+    std::vector<uint8_t> sendBuffer;
+    // Протокол соединения, которое сейчас принимает реактор (переезд из другого шарда)
+    WireProtocol adoptedProtocol = WireProtocol::Unknown;
+    uint8_t adoptedVersion = 0;
+
+    std::ostream& log();
+
+    void openSession(SessionId id);
+    // Нарезает принятые байты на кадры; возвращает, сколько байт разобрано
+    size_t handleData(SessionId id, const uint8_t* data, size_t size);
+    // false - соединение передано другому шарду или закрывается, разбор прекращается
+    bool processMessage(SessionId id, const WireMessage& message);
+    void migrate(SessionId id, size_t target);
+
+    void createRoom(SessionId id);
+    void joinRoom(SessionId id, const std::string& code);
+    // Клиент прислал конфиг, не выбрав комнату: сажаем его в общую очередь
+    Room* quickMatch(SessionId id);
+    Room* enterRoom(SessionId id, Room& room);
+    void handleConfig(SessionId id, const RoomConfig& config);
+    void spectate(SessionId id, const std::string& code);
+    void sendSnapshot(SessionId id, const Room& room);
+    void handleCongestion(SessionId id, bool congested);
+
+    void startGame(Room& room);
+    // false - ход нелегален, сессия отключена
+    bool playMove(SessionId id, Room& room, const Move& move);
+    void abortGame(Room& room);
+    // Комната закрывается: зрители получают Disconnect и отключаются
+    void dismissSpectators(Room& room);
+    void leaveRoom(SessionId id);
+    // Оставшиеся игроки получают Disconnect, комната удаляется
+    void closeRoom(Room& room);
+    void closeSession(SessionId id);
+
+    // Возврат после обрыва: место игрока с токеном ждёт его RECONNECT_GRACE_MS, потом
+    // комната закрывается. Вернувшийся получает недостающие ходы из журнала комнаты и часы
+    bool resumable(SessionId id) const;
+    std::string generateToken(const Room& room);
+    void holdSeat(SessionId id, Room& room, int slot);
+    void abandonSeat(const std::string& code, int slot);
+    void resumeGame(SessionId id, const std::string& token, uint32_t ply);
+
+    // Часы партии на сервере: флаг проверяется таймером к сроку стороны, которая ходит,
+    // а задержку сети игроку засчитывают по пингу, не больше MAX_LAG_CREDIT_MS
+    bool clockAware(SessionId id) const;
+    int lagCredit(SessionId id) const;
+    void armFlag(Room& room);
+    void checkFlag(const std::string& code);
+    void flagGame(Room& room);
+    void sendPing(SessionId id);
+    void handlePong(SessionId id, uint32_t stamp);
+    void rejectSession(SessionId id, const std::string& reason);
+
+    // Несколько сообщений уходят одним кадром, если клиент говорит на компактном протоколе
+    // false - сообщение не помещается в кадр и не отправлено
+    bool sendTo(SessionId id, const WireMessage* messages, size_t count);
+    bool sendTo(SessionId id, const WireMessage& message);
+    void relayToOpponent(SessionId sender, const WireMessage& message);
+    // Рассылка зрителям комнаты: кадр кодируется один раз на протокол,
+    // каждому зрителю в очередь ставится только ссылка на него
+    void broadcast(const Room& room, const WireMessage& message);
+    std::string generateRoomCode();
+};
\ No newline at end of file
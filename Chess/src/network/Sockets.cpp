@@ -0,0 +1,128 @@
+#include "Sockets.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+void initSockets()
+{
+#ifdef _WIN32
+    static bool started = false;
+    if (!started)
+    {
+        WSADATA wsaData;
+        started = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    }
+#endif
+}
+
+NativeSocket openListener(unsigned short port)
+{
+    NativeSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_NATIVE_SOCKET)
+        return INVALID_NATIVE_SOCKET;
+
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        closeSocket(listener);
+        return INVALID_NATIVE_SOCKET;
+    }
+    return listener;
+}
+
+NativeSocket acceptSocket(NativeSocket listener)
+{
+    return accept(listener, nullptr, nullptr);
+}
+
+void closeSocket(NativeSocket s)
+{
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool setNonBlocking(NativeSocket s)
+{
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags != -1 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Ходы - крошечные пакеты, алгоритм Нейгла только задерживал бы их
+void setNoDelay(NativeSocket s)
+{
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+}
+
+long receiveSome(NativeSocket s, uint8_t* data, size_t size)
+{
+#ifdef _WIN32
+    return recv(s, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+#else
+    return recv(s, data, size, 0);
+#endif
+}
+
+long sendSome(NativeSocket s, const uint8_t* data, size_t size)
+{
+#ifdef _WIN32
+    return send(s, reinterpret_cast<const char*>(data), static_cast<int>(size), 0);
+#else
+    return send(s, data, size, MSG_NOSIGNAL);
+#endif
+}
+
+bool socketWouldBlock()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool socketInterrupted()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEINTR;
+#else
+    return errno == EINTR;
+#endif
+}
+
+std::string peerAddress(NativeSocket s)
+{
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    if (getpeername(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0)
+        return "";
+
+    char text[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &addr.sin_addr, text, sizeof(text));
+    return text;
+}
\ No newline at end of file
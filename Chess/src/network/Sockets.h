@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Тонкая обёртка над сокетами ОС (WinSock / BSD) для приёма соединений и реакторов сервера
+
+#ifdef _WIN32
+using NativeSocket = uintptr_t;
+#else
+using NativeSocket = int;
+#endif
+
+static const NativeSocket INVALID_NATIVE_SOCKET = static_cast<NativeSocket>(-1);
+
+// Соединение, передаваемое другому реактору: сокет и байты, которые ещё не обработаны
+struct SocketHandoff
+{
+    NativeSocket socket = INVALID_NATIVE_SOCKET;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    // Протокол, о котором клиент уже договорился (WireProtocol), и версия компактного;
+    // реактор их не трогает
+    uint8_t protocol = 0;
+    uint8_t version = 0;
+};
+
+// WSAStartup на Windows; вызывается до первого сокета
+void initSockets();
+
+// Блокирующий слушающий сокет на всех интерфейсах
+NativeSocket openListener(unsigned short port);
+NativeSocket acceptSocket(NativeSocket listener);
+void closeSocket(NativeSocket s);
+
+bool setNonBlocking(NativeSocket s);
+void setNoDelay(NativeSocket s);
+
+// Результат как у recv/send: байты, 0 - соединение закрыто (для приёма), -1 - ошибка
+long receiveSome(NativeSocket s, uint8_t* data, size_t size);
+long sendSome(NativeSocket s, const uint8_t* data, size_t size);
+// Причина последней ошибки: сокет пуст/заполнен или вызов прерван сигналом
+bool socketWouldBlock();
+bool socketInterrupted();
+
+std::string peerAddress(NativeSocket s);
\ No newline at end of file
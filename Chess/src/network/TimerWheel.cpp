@@ -0,0 +1,202 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+static const int64_t MAX_DELAY_TICKS = (int64_t(1) << (TimerWheel::SLOT_BITS * TimerWheel::LEVEL_COUNT)) - 1;
+static const int64_t SLOT_MASK = TimerWheel::SLOT_COUNT - 1;
+
+TimerWheel::TimerWheel(int64_t nowMs)
+    : currentTick(nowMs)
+{
+    std::fill(std::begin(heads), std::end(heads), NIL);
+}
+
+TimerId TimerWheel::schedule(int64_t deadlineMs, Callback callback)
+{
+    uint32_t index;
+    if (freeNodes.empty())
+    {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    else
+    {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    }
+
+    Node& node = nodes[index];
+    node.callback = std::move(callback);
+    node.tick = std::clamp(deadlineMs, currentTick + 1, currentTick + MAX_DELAY_TICKS);
+    node.armed = true;
+    insert(index);
+    ++count;
+    return (TimerId(node.generation) << 32) | (index + 1);
+}
+
+void TimerWheel::cancel(TimerId id)
+{
+    uint32_t index = static_cast<uint32_t>(id) - 1;
+    if (index >= nodes.size())
+        return;
+    Node& node = nodes[index];
+    if (!node.armed || node.generation != static_cast<uint32_t>(id >> 32))
+        return;
+    unlink(index);
+    release(index);
+}
+
+void TimerWheel::advance(int64_t nowMs)
+{
+    while (currentTick < nowMs)
+    {
+        // без таймеров колесо стоит; время просто догоняется
+        int64_t next = count ? nextEventTick() : nowMs + 1;
+        if (next > nowMs)
+        {
+            currentTick = nowMs;
+            break;
+        }
+        currentTick = next;
+
+        if ((currentTick & SLOT_MASK) == 0)
+            cascade(1);
+
+        // обработчики могут ставить и снимать таймеры, но не в этот слот: срок всегда позже текущего тика
+        int slot = static_cast<int>(currentTick & SLOT_MASK);
+        while (heads[slot] != NIL)
+        {
+            uint32_t index = heads[slot];
+            unlink(index);
+            Callback callback = std::move(nodes[index].callback);
+            release(index);
+            callback();
+        }
+    }
+}
+
+int TimerWheel::timeUntilNext(int64_t nowMs) const
+{
+    if (count == 0)
+        return -1;
+    return static_cast<int>(std::clamp<int64_t>(nextEventTick() - nowMs, 0, INT32_MAX));
+}
+
+size_t TimerWheel::size() const
+{
+    return count;
+}
+
+void TimerWheel::insert(uint32_t index)
+{
+    Node& node = nodes[index];
+    int64_t delay = node.tick - currentTick;
+
+    int level = 0;
+    while (level + 1 < LEVEL_COUNT && delay >= (int64_t(1) << (SLOT_BITS * (level + 1))))
+        ++level;
+    int slot = static_cast<int>((node.tick >> (SLOT_BITS * level)) & SLOT_MASK);
+    uint16_t bucket = static_cast<uint16_t>(level * SLOT_COUNT + slot);
+
+    node.bucket = bucket;
+    node.prev = NIL;
+    node.next = heads[bucket];
+    if (node.next != NIL)
+        nodes[node.next].prev = index;
+    heads[bucket] = index;
+
+    if (level == 0)
+        pending[slot / 64] |= uint64_t(1) << (slot % 64);
+    ++levelSize[level];
+}
+
+void TimerWheel::unlink(uint32_t index)
+{
+    Node& node = nodes[index];
+    if (node.prev != NIL)
+        nodes[node.prev].next = node.next;
+    else
+        heads[node.bucket] = node.next;
+    if (node.next != NIL)
+        nodes[node.next].prev = node.prev;
+
+    int level = node.bucket / SLOT_COUNT;
+    int slot = node.bucket % SLOT_COUNT;
+    if (level == 0 && heads[node.bucket] == NIL)
+        pending[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    --levelSize[level];
+}
+
+void TimerWheel::release(uint32_t index)
+{
+    Node& node = nodes[index];
+    node.callback = nullptr;
+    node.armed = false;
+    ++node.generation;
+    freeNodes.push_back(index);
+    --count;
+}
+
+void TimerWheel::cascade(int level)
+{
+    int slot = static_cast<int>((currentTick >> (SLOT_BITS * level)) & SLOT_MASK);
+    uint32_t index = heads[level * SLOT_COUNT + slot];
+    heads[level * SLOT_COUNT + slot] = NIL;
+
+    while (index != NIL)
+    {
+        uint32_t next = nodes[index].next;
+        --levelSize[level];
+        insert(index);
+        index = next;
+    }
+
+    // слот 0 уровня значит, что прошёл полный оборот: пора разобрать слот уровня выше
+    if (slot == 0 && level + 1 < LEVEL_COUNT)
+        cascade(level + 1);
+}
+
+int64_t TimerWheel::nextEventTick() const
+{
+    int64_t base = currentTick & ~SLOT_MASK;
+    int slot = firstPendingSlot(static_cast<int>(currentTick & SLOT_MASK) + 1);
+    if (slot >= 0)
+        return base + slot;
+
+    // До конца оборота нижнего уровня сроков нет. Дальше - сроки следующего оборота или граница,
+    // на которой спускаются таймеры ближайшего непустого верхнего уровня
+    int64_t next = INT64_MAX;
+    slot = firstPendingSlot(0);
+    if (slot >= 0)
+        next = base + SLOT_COUNT + slot;
+    for (int level = 1; level < LEVEL_COUNT; ++level)
+    {
+        if (levelSize[level] > 0)
+        {
+            int shift = SLOT_BITS * level;
+            next = std::min(next, ((currentTick >> shift) + 1) << shift);
+            break;
+        }
+    }
+    return next;
+}
+
+int TimerWheel::firstPendingSlot(int from) const
+{
+    for (int word = from / 64; word < SLOT_COUNT / 64; ++word)
+    {
+        uint64_t bits = pending[word];
+        if (word == from / 64)
+            bits &= ~uint64_t(0) << (from % 64);
+        if (bits)
+        {
+            int bit = 0;
+            while (!(bits & 1))
+            {
+                bits >>= 1;
+                ++bit;
+            }
+            return word * 64 + bit;
+        }
+    }
+    return -1;
+}
\ No newline at end of file
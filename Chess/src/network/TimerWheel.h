@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using TimerId = uint64_t;
+static const TimerId NO_TIMER = 0;
+
+// Иерархическое колесо таймеров с тиком в 1 мс: уровень i делится на 256 слотов по 256^i тиков.
+// Таймер ставится в слот уровня, которому соответствует его срок, и спускается на уровень ниже,
+// когда колесо доходит до его слота; за всю жизнь таймер переносится не больше LEVEL_COUNT раз.
+// Таймеры - узлы двусвязных списков в общем пуле, поэтому schedule и cancel - O(1)
+// без поиска и без хеш-таблицы, а сработавший или снятый узел сразу уходит в повторное использование.
+// Колесо однопоточное: им владеет Reactor шарда, обработчики вызываются из его poll().
+class TimerWheel
+{
+public:
+    using Callback = std::function<void()>;
+
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr int LEVEL_COUNT = 4;
+
+    explicit TimerWheel(int64_t nowMs);
+
+    // callback вызывается из advance() не раньше deadlineMs; сроки дальше 49 суток урезаются
+    TimerId schedule(int64_t deadlineMs, Callback callback);
+    // Снятый или уже сработавший таймер - не ошибка
+    void cancel(TimerId id);
+
+    // Вызывает таймеры, срок которых наступил к nowMs
+    void advance(int64_t nowMs);
+
+    // Сколько мс до ближайшего срока или спуска таймеров с верхнего уровня; -1 - таймеров нет
+    int timeUntilNext(int64_t nowMs) const;
+
+    size_t size() const;
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node
+    {
+        Callback callback;
+        int64_t tick = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 1; // TimerId старого владельца узла не снимет нового
+        uint16_t bucket = 0;
+        bool armed = false;
+    };
+
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+    int64_t nextEventTick() const;
+    int firstPendingSlot(int from) const;
+
+    int64_t currentTick;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    uint32_t heads[LEVEL_COUNT * SLOT_COUNT];
+    // непустые слоты нижнего уровня, чтобы перескакивать пустые тики
+    uint64_t pending[SLOT_COUNT / 64] = {};
+    size_t levelSize[LEVEL_COUNT] = {};
+    size_t count = 0;
+};
\ No newline at end of file
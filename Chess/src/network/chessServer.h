@@ -1,42 +1,26 @@
 #pragma once
-#include "../core/move.h"
-#include "PacketType.h"
-#include <SFML/Network.hpp>
+#include "../core/Tablebase.h"
+#include "ServerShard.h"
+#include "Sockets.h"
 #include <iostream>
 #include <memory>
 #include <vector>
 
+//  :      -      .
+//          .
 class ChessServer
 {
-    sf::TcpListener listener;
-    sf::SocketSelector selector;
-    std::vector<std::unique_ptr<sf::TcpSocket>> clients;
     unsigned short port;
-
-    int hostColorInt = 0; // 0 - White, 1 - Black
-    int timeMinutes = 10;
-    int incrementSeconds = 0;
-    int gameTypeInt = 0;
-    int seed = 0;
-
-    //       
-    int clientGameTypes[2] = { 0, 0 };
-    // ,     
-    bool clientsReady[2] = { false, false };
+    std::unique_ptr<Tablebase> tablebase;
+    std::vector<std::unique_ptr<ServerShard>> shards;
+    size_t nextShard = 0;
 
 public:
-    ChessServer(unsigned short port);
+    // threads = 0 -   
+    ChessServer(unsigned short port, size_t threads = 0);
+    //     ;    
     void run();
 
-private:
-    void handleNewConnection();
-    void handleClientActivity();
-
-    //     bool (true -  , false -  ,   )
-    bool processPacket(sf::TcpSocket& sender, sf::Packet& packet);
-
-    void startGame();
-    void abortGame();
-    void relayPacketToOthers(sf::TcpSocket& sender, sf::Packet& packet);
-    int getClientIndex(sf::TcpSocket& socket);
+    //   ;     
+    void handoff(size_t shard, SocketHandoff&& socket);
 };
\ No newline at end of file
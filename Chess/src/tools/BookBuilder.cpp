@@ -0,0 +1,366 @@
+﻿#include "BookBuilder.h"
+#include "../core/Book.h"
+#include "../core/Pgn.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <thread>
+
+static const size_t GAMES_PER_BATCH = 256;
+static const size_t MAX_MERGE_FAN_IN = 256;
+// Примерный размер записи unordered_map (узел + бакет)
+static const size_t BYTES_PER_ENTRY = 64;
+
+BookBuilder::BookBuilder(BookBuilderOptions options)
+    : options(std::move(options))
+{
+    if (this->options.threads == 0)
+        this->options.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    maxEntriesPerThread = std::max<size_t>(1024, this->options.memoryMb * 1024 * 1024 / BYTES_PER_ENTRY / this->options.threads);
+}
+
+bool BookBuilder::build(const std::vector<std::string>& pgnFiles)
+{
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < options.threads; ++i)
+        workers.emplace_back([this]() { worker(); });
+
+    reader(pgnFiles, options.threads * 4);
+
+    for (auto& t : workers)
+        t.join();
+
+    std::cout << "Games used: " << gamesUsed << ", skipped: " << gamesSkipped
+              << ", sorted runs: " << runFiles.size() << std::endl;
+
+    size_t positions = 0, entries = 0;
+    bool ok = merge(positions, entries);
+
+    for (const auto& run : runFiles)
+        std::remove(run.c_str());
+
+    if (ok)
+        std::cout << "Book written to " << options.outputPath << ": " << positions << " positions, "
+                  << entries << " moves" << std::endl;
+    return ok;
+}
+
+void BookBuilder::reader(const std::vector<std::string>& pgnFiles, size_t maxBatches)
+{
+    std::vector<std::string> batch;
+    auto push = [&]() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueNotFull.wait(lock, [&]() { return batches.size() < maxBatches; });
+        batches.push_back(std::move(batch));
+        batch.clear();
+        queueNotEmpty.notify_one();
+    };
+
+    for (const auto& path : pgnFiles)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "Cannot open " << path << std::endl;
+            continue;
+        }
+
+        PgnReader pgn(in);
+        std::string text;
+        while (pgn.nextRaw(text))
+        {
+            batch.push_back(std::move(text));
+            if (batch.size() == GAMES_PER_BATCH)
+                push();
+        }
+    }
+    if (!batch.empty())
+        push();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    readingDone = true;
+    queueNotEmpty.notify_all();
+}
+
+void BookBuilder::worker()
+{
+    CountMap counts;
+    counts.reserve(std::min<size_t>(maxEntriesPerThread, 1 << 20));
+
+    while (true)
+    {
+        std::vector<std::string> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNotEmpty.wait(lock, [this]() { return !batches.empty() || readingDone; });
+            if (batches.empty())
+                break;
+            batch = std::move(batches.front());
+            batches.pop_front();
+            queueNotFull.notify_one();
+        }
+
+        for (const auto& text : batch)
+        {
+            addGame(text, counts);
+            if (counts.size() >= maxEntriesPerThread)
+                spill(counts);
+        }
+    }
+
+    if (!counts.empty())
+        spill(counts);
+}
+
+void BookBuilder::addGame(const std::string& text, CountMap& counts)
+{
+    PgnGame game;
+    if (!PgnReader::parse(text, game))
+    {
+        ++gamesSkipped;
+        return;
+    }
+
+    // партии с произвольной начальной позицией и варианты пропускаем
+    auto variant = game.tags.find("Variant");
+    if (game.tags.count("FEN") || (variant != game.tags.end() && variant->second != "Standard")
+        || game.result == "*")
+    {
+        ++gamesSkipped;
+        return;
+    }
+
+    int whiteScore = game.result == "1-0" ? 1 : game.result == "0-1" ? -1 : 0;
+
+    Board board(std::make_unique<Сlassic>(), 3600, 0);
+    int plies = std::min<int>(options.maxPlies, static_cast<int>(game.moves.size()));
+    for (int ply = 0; ply < plies; ++ply)
+    {
+        auto move = Pgn::sanToMove(board, game.moves[ply]);
+        if (!move)
+            break;
+
+        int score = (board.getCurrentPlayer() == Color::White) ? whiteScore : -whiteScore;
+        Counts& c = counts[EntryKey { board.getKey(), polyglotMove(board, *move) }];
+        if (score > 0)
+            ++c.wins;
+        else if (score < 0)
+            ++c.losses;
+        else
+            ++c.draws;
+
+        if (!board.makeMove(*move))
+            break;
+    }
+    ++gamesUsed;
+}
+
+uint16_t BookBuilder::polyglotMove(const Board& board, const Move& move)
+{
+    std::string uci = Pgn::moveToUci(move);
+    if (move.isCastling())
+    {
+        // в Polyglot рокировка записывается как ход короля на поле своей ладьи
+        const auto& grid = board.getGrid();
+        int y = move.getFrom().getY();
+        int dx = move.getTo().getX() > move.getFrom().getX() ? 1 : -1;
+        for (int x = move.getFrom().getX() + dx; x >= 0 && x < 8; x += dx)
+        {
+            const auto& piece = grid[y][x];
+            if (piece && piece->getType() == "rook" && piece->getColor() == board.getCurrentPlayer())
+            {
+                uci[2] = static_cast<char>('a' + x);
+                break;
+            }
+        }
+    }
+    return Book::uciToMove(uci);
+}
+
+void BookBuilder::spill(CountMap& counts)
+{
+    std::vector<RunRecord> records;
+    records.reserve(counts.size());
+    for (const auto& [entry, c] : counts)
+        records.push_back(RunRecord { entry.key, entry.move, c });
+    counts.clear();
+
+    std::sort(records.begin(), records.end(), [](const RunRecord& a, const RunRecord& b) {
+        return a.key != b.key ? a.key < b.key : a.move < b.move;
+    });
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(runsMutex);
+        path = options.outputPath + ".run" + std::to_string(runFiles.size()) + ".tmp";
+        runFiles.push_back(path);
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    for (const auto& r : records)
+        writeRecord(out, r);
+}
+
+void BookBuilder::writeRecord(std::ofstream& out, const RunRecord& r)
+{
+    out.write(reinterpret_cast<const char*>(&r.key), sizeof(r.key));
+    out.write(reinterpret_cast<const char*>(&r.move), sizeof(r.move));
+    out.write(reinterpret_cast<const char*>(&r.counts.wins), sizeof(r.counts.wins));
+    out.write(reinterpret_cast<const char*>(&r.counts.draws), sizeof(r.counts.draws));
+    out.write(reinterpret_cast<const char*>(&r.counts.losses), sizeof(r.counts.losses));
+}
+
+bool BookBuilder::readRecord(std::ifstream& in, RunRecord& r)
+{
+    in.read(reinterpret_cast<char*>(&r.key), sizeof(r.key));
+    in.read(reinterpret_cast<char*>(&r.move), sizeof(r.move));
+    in.read(reinterpret_cast<char*>(&r.counts.wins), sizeof(r.counts.wins));
+    in.read(reinterpret_cast<char*>(&r.counts.draws), sizeof(r.counts.draws));
+    in.read(reinterpret_cast<char*>(&r.counts.losses), sizeof(r.counts.losses));
+    return static_cast<bool>(in);
+}
+
+static void writeBigEndian(std::ofstream& out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; --i)
+        out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+bool BookBuilder::mergeRuns(const std::vector<std::string>& paths, const std::function<void(const RunRecord&)>& emit)
+{
+    std::vector<std::ifstream> runs;
+    runs.reserve(paths.size());
+    for (const auto& path : paths)
+    {
+        runs.emplace_back(path, std::ios::binary);
+        if (!runs.back())
+        {
+            std::cerr << "Cannot open " << path << std::endl;
+            return false;
+        }
+    }
+
+    // k-путевое слияние прогонов по (ключ, ход), одинаковые пары суммируются
+    using HeapItem = std::pair<RunRecord, size_t>;
+    auto greater = [](const HeapItem& a, const HeapItem& b) {
+        return a.first.key != b.first.key ? a.first.key > b.first.key : a.first.move > b.first.move;
+    };
+    std::priority_queue<HeapItem, std::vector<HeapItem>, decltype(greater)> heap(greater);
+
+    auto pull = [&](size_t run) {
+        RunRecord r;
+        if (readRecord(runs[run], r))
+            heap.push({ r, run });
+    };
+    for (size_t i = 0; i < runs.size(); ++i)
+        pull(i);
+
+    bool hasCurrent = false;
+    RunRecord current {};
+    while (!heap.empty())
+    {
+        HeapItem top = heap.top();
+        heap.pop();
+        pull(top.second);
+
+        const RunRecord& r = top.first;
+        if (hasCurrent && current.key == r.key && current.move == r.move)
+        {
+            current.counts.wins += r.counts.wins;
+            current.counts.draws += r.counts.draws;
+            current.counts.losses += r.counts.losses;
+            continue;
+        }
+        if (hasCurrent)
+            emit(current);
+        current = r;
+        hasCurrent = true;
+    }
+    if (hasCurrent)
+        emit(current);
+    return true;
+}
+
+bool BookBuilder::merge(size_t& positions, size_t& entries)
+{
+    // Открытых файлов одновременно не больше MAX_MERGE_FAN_IN (в CRT Windows предел около 512):
+    // лишние прогоны предварительно сливаются группами в промежуточные
+    size_t pass = 0;
+    while (runFiles.size() > MAX_MERGE_FAN_IN)
+    {
+        std::vector<std::string> merged;
+        for (size_t first = 0; first < runFiles.size(); first += MAX_MERGE_FAN_IN)
+        {
+            size_t last = std::min(runFiles.size(), first + MAX_MERGE_FAN_IN);
+            std::vector<std::string> group(runFiles.begin() + first, runFiles.begin() + last);
+
+            std::string path = options.outputPath + ".pass" + std::to_string(pass) + "." + std::to_string(merged.size()) + ".tmp";
+            std::ofstream out(path, std::ios::binary);
+            merged.push_back(path);
+            bool ok = out && mergeRuns(group, [&](const RunRecord& r) { writeRecord(out, r); });
+            out.close();
+            for (const auto& run : group)
+                std::remove(run.c_str());
+            if (!ok || !out)
+            {
+                std::cerr << "Cannot write " << path << std::endl;
+                runFiles.erase(runFiles.begin(), runFiles.begin() + last);
+                runFiles.insert(runFiles.end(), merged.begin(), merged.end());
+                return false;
+            }
+        }
+        runFiles = std::move(merged);
+        ++pass;
+    }
+
+    std::ofstream out(options.outputPath, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot write " << options.outputPath << std::endl;
+        return false;
+    }
+
+    std::vector<RunRecord> group; // все ходы одной позиции
+    auto flushGroup = [&]() {
+        uint64_t key = group.front().key;
+        std::vector<std::pair<uint16_t, uint64_t>> moves;
+        uint64_t maxWeight = 0;
+        for (const auto& r : group)
+        {
+            uint64_t games = uint64_t(r.counts.wins) + r.counts.draws + r.counts.losses;
+            uint64_t weight = 2 * uint64_t(r.counts.wins) + r.counts.draws;
+            if (games < static_cast<uint64_t>(options.minGames) || weight == 0)
+                continue;
+            moves.push_back({ r.move, weight });
+            maxWeight = std::max(maxWeight, weight);
+        }
+        group.clear();
+        if (moves.empty())
+            return;
+
+        std::sort(moves.begin(), moves.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        for (const auto& [move, weight] : moves)
+        {
+            // вес Polyglot 16-битный: при необходимости масштабируем, сохраняя пропорции
+            uint64_t scaled = maxWeight > 0xFFFF ? std::max<uint64_t>(1, weight * 0xFFFF / maxWeight) : weight;
+            writeBigEndian(out, key, 8);
+            writeBigEndian(out, move, 2);
+            writeBigEndian(out, scaled, 2);
+            writeBigEndian(out, 0, 4);
+            ++entries;
+        }
+        ++positions;
+    };
+
+    bool ok = mergeRuns(runFiles, [&](const RunRecord& r) {
+        if (!group.empty() && group.back().key != r.key)
+            flushGroup();
+        group.push_back(r);
+    });
+    if (!group.empty())
+        flushGroup();
+
+    return ok && static_cast<bool>(out);
+}
\ No newline at end of file
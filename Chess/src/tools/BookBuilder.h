@@ -0,0 +1,87 @@
+#pragma once
+#include "../core/board.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BookBuilderOptions
+{
+    std::string outputPath = "book.bin";
+    int maxPlies = 24;        // глубина книги в полуходах
+    int minGames = 2;         // ход попадает в книгу, если сыгран хотя бы столько раз
+    size_t threads = 0;       // 0 - по числу ядер
+    size_t memoryMb = 512;    // суммарный бюджет на таблицы потоков, при превышении - сброс на диск
+};
+
+// Сборка дебютной книги Polyglot из PGN: партии проигрываются через Board, статистика (позиция, ход)
+// копится в таблицах потоков, которые сбрасываются на диск отсортированными прогонами и сливаются в конце.
+class BookBuilder
+{
+public:
+    explicit BookBuilder(BookBuilderOptions options);
+
+    bool build(const std::vector<std::string>& pgnFiles);
+
+private:
+    struct EntryKey
+    {
+        uint64_t key;
+        uint16_t move;
+        bool operator==(const EntryKey& other) const { return key == other.key && move == other.move; }
+    };
+
+    struct EntryKeyHash
+    {
+        size_t operator()(const EntryKey& k) const { return static_cast<size_t>(k.key ^ (static_cast<uint64_t>(k.move) * 0x9E3779B97F4A7C15ULL)); }
+    };
+
+    struct Counts
+    {
+        uint32_t wins = 0;
+        uint32_t draws = 0;
+        uint32_t losses = 0;
+    };
+
+    struct RunRecord
+    {
+        uint64_t key;
+        uint16_t move;
+        Counts counts;
+    };
+
+    using CountMap = std::unordered_map<EntryKey, Counts, EntryKeyHash>;
+
+    BookBuilderOptions options;
+    size_t maxEntriesPerThread;
+
+    std::deque<std::vector<std::string>> batches;
+    std::mutex queueMutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+    bool readingDone = false;
+
+    std::vector<std::string> runFiles;
+    std::mutex runsMutex;
+
+    std::atomic<size_t> gamesUsed { 0 };
+    std::atomic<size_t> gamesSkipped { 0 };
+
+    void reader(const std::vector<std::string>& pgnFiles, size_t maxBatches);
+    void worker();
+    void addGame(const std::string& text, CountMap& counts);
+    void spill(CountMap& counts);
+    bool merge(size_t& positions, size_t& entries);
+    static bool mergeRuns(const std::vector<std::string>& paths, const std::function<void(const RunRecord&)>& emit);
+
+    static void writeRecord(std::ofstream& out, const RunRecord& r);
+    static bool readRecord(std::ifstream& in, RunRecord& r);
+
+    static uint16_t polyglotMove(const Board& board, const Move& move);
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "BookBuilder.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage()
+{
+    std::cout << "Usage: bookgen [-o book.bin] [-plies N] [-min N] [-threads N] [-mem MB] games1.pgn [games2.pgn ...]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    BookBuilderOptions options;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-o" && hasValue)
+            options.outputPath = argv[++i];
+        else if (arg == "-plies" && hasValue)
+            options.maxPlies = std::stoi(argv[++i]);
+        else if (arg == "-min" && hasValue)
+            options.minGames = std::stoi(argv[++i]);
+        else if (arg == "-threads" && hasValue)
+            options.threads = std::stoul(argv[++i]);
+        else if (arg == "-mem" && hasValue)
+            options.memoryMb = std::stoul(argv[++i]);
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            printUsage();
+            return -1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    if (files.empty())
+    {
+        printUsage();
+        return -1;
+    }
+
+    std::cout << "--- Opening book builder ---" << std::endl;
+
+    try
+    {
+        BookBuilder builder(options);
+        if (!builder.build(files))
+            return -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "SelfPlay.h"
+#include "../core/Clock.h"
+#include "../core/board.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+SelfPlay::SelfPlay(SelfPlayOptions options)
+    : options(std::move(options))
+{
+}
+
+void SelfPlay::setOnGameFinished(std::function<bool(const SelfPlayGame&)> callback)
+{
+    onGameFinished = std::move(callback);
+}
+
+bool SelfPlay::loadOpenings()
+{
+    openings.clear();
+    if (options.openingsFile.empty())
+        return true;
+
+    std::ifstream in(options.openingsFile);
+    if (!in)
+    {
+        std::cerr << "Cannot open openings file: " << options.openingsFile << std::endl;
+        return false;
+    }
+
+    // EPD: первые четыре поля FEN, дальше операции ("bm", "id", ...)
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream ss(line);
+        std::string placement, turn, castling, ep;
+        if (!(ss >> placement >> turn >> castling >> ep))
+            continue;
+        std::string fen = placement + " " + turn + " " + castling + " " + ep + " 0 1";
+        FastBoard pos;
+        if (pos.setFen(fen))
+            openings.push_back(fen);
+    }
+
+    if (openings.empty())
+    {
+        std::cerr << "No positions in openings file: " << options.openingsFile << std::endl;
+        return false;
+    }
+
+    std::mt19937 rng(options.seed);
+    std::shuffle(openings.begin(), openings.end(), rng);
+    std::cout << "Openings loaded: " << openings.size() << std::endl;
+    return true;
+}
+
+std::string SelfPlay::openingFor(int game) const
+{
+    int round = options.repeatOpenings ? game / 2 : game;
+    if (!openings.empty())
+        return openings[round % openings.size()];
+    if (options.fischer)
+    {
+        // расстановка по seed - та же, что у Fischer в игре
+        int fischerSeed = static_cast<int>((options.seed + round) & 0x7FFFFFFF);
+        Board board(std::make_unique<Fischer>(fischerSeed ? fischerSeed : 1), 0, 0);
+        return board.getFen();
+    }
+    return FastBoard::START_FEN;
+}
+
+bool SelfPlay::run()
+{
+    if (!loadOpenings())
+        return false;
+
+    pgn.open(options.pgnPath, std::ios::out | std::ios::trunc);
+    if (!pgn)
+    {
+        std::cerr << "Cannot open PGN file: " << options.pgnPath << std::endl;
+        return false;
+    }
+
+    auto tb = std::make_shared<const Tablebase>(options.tablebasePath);
+    tablebase = tb->getTableCount() > 0 ? tb : nullptr;
+
+    std::time_t now = std::time(nullptr);
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y.%m.%d", std::localtime(&now));
+    date = buffer;
+
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, static_cast<size_t>(std::max(options.games, 1)));
+    std::cout << "Playing " << options.games << " games on " << threads << " threads" << std::endl;
+
+    nextGame = 0;
+    finished = 0;
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i)
+        pool.emplace_back(&SelfPlay::worker, this);
+    for (auto& t : pool)
+        t.join();
+
+    std::cout << "Finished: " << finished << " games, +" << whiteWins << " -" << blackWins << " =" << draws
+              << " (white/black/draw)" << std::endl;
+    return true;
+}
+
+void SelfPlay::worker()
+{
+    // у каждого потока свои движки: хеш-таблицы не делятся между партиями
+    Search searches[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        searches[i].setHashSize(options.engines[i].hashMb);
+        searches[i].setParams(options.engines[i].params);
+        searches[i].setTablebase(tablebase);
+    }
+    Search* engines[2] = { &searches[0], &searches[1] };
+
+    while (!stopRequested)
+    {
+        int index = nextGame++;
+        if (index >= options.games)
+            return;
+        finishGame(playGame(index, engines));
+    }
+}
+
+SelfPlayGame SelfPlay::playGame(int index, Search* engines[2])
+{
+    SelfPlayGame game;
+    game.index = index;
+    game.whiteEngine = index % 2;
+    game.startFen = openingFor(index);
+
+    FastBoard pos;
+    pos.setFen(game.startFen);
+    if (options.fischer)
+        pos.setChess960(true);
+    for (int i = 0; i < 2; ++i)
+        engines[i]->clearHash();
+
+    bool useClock = options.nodesPerMove == 0;
+    Clock clock(options.baseSeconds, options.incrementSeconds, pos.sideToMove() == SIDE_WHITE);
+    clock.start();
+    clock.update();
+
+    std::vector<uint64_t> keys;
+    auto win = [&](int side, const std::string& reason) {
+        game.result = side == SIDE_WHITE ? "1-0" : "0-1";
+        game.termination = reason;
+    };
+    auto draw = [&](const std::string& reason) {
+        game.result = "1/2-1/2";
+        game.termination = reason;
+    };
+
+    while (game.result.empty())
+    {
+        int us = pos.sideToMove();
+        MoveList list;
+        pos.generateMoves(list);
+        if (list.size == 0)
+        {
+            if (pos.inCheck())
+                win(us ^ 1, "checkmate");
+            else
+                draw("stalemate");
+            break;
+        }
+        if (pos.getHalfmoveClock() >= 100)
+        {
+            draw("fifty-move rule");
+            break;
+        }
+        if (pos.isInsufficientMaterial())
+        {
+            draw("insufficient material");
+            break;
+        }
+
+        int repetitions = 0;
+        int window = std::min<int>(pos.getHalfmoveClock(), static_cast<int>(keys.size()));
+        for (int i = 2; i <= window; i += 2)
+            repetitions += keys[keys.size() - i] == pos.getKey();
+        if (repetitions >= 2)
+        {
+            draw("threefold repetition");
+            break;
+        }
+
+        // результат из таблиц эндшпиля известен - доигрывать незачем
+        if (tablebase && pos.pieceCount() <= tablebase->getMaxPieces())
+        {
+            if (auto probe = tablebase->probe(pos))
+            {
+                if (probe->wdl == 0)
+                    draw("tablebase");
+                else
+                    win(probe->wdl > 0 ? us : us ^ 1, "tablebase");
+                break;
+            }
+        }
+
+        SearchLimits limits;
+        if (useClock)
+        {
+            limits.timeMs[SIDE_WHITE] = static_cast<int>(clock.getWhiteTime() * 1000);
+            limits.timeMs[SIDE_BLACK] = static_cast<int>(clock.getBlackTime() * 1000);
+            limits.incMs[SIDE_WHITE] = limits.incMs[SIDE_BLACK] = static_cast<int>(options.incrementSeconds * 1000);
+        }
+        else
+            limits.nodes = options.nodesPerMove;
+
+        Search* engine = engines[us == SIDE_WHITE ? game.whiteEngine : 1 - game.whiteEngine];
+        engine->clearStop();
+        SearchResult result = engine->run(pos, limits, keys);
+
+        clock.update();
+        if (useClock && clock.isTimeUp())
+        {
+            win(us ^ 1, "time forfeit");
+            break;
+        }
+
+        FastMove m = result.bestMove != NO_MOVE ? result.bestMove : list.moves[0];
+        game.sanMoves.push_back(pos.moveToSan(m));
+        keys.push_back(pos.getKey());
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        clock.switchTurn();
+    }
+    return game;
+}
+
+void SelfPlay::finishGame(const SelfPlayGame& game)
+{
+    if (game.result == "1-0")
+        ++whiteWins;
+    else if (game.result == "0-1")
+        ++blackWins;
+    else
+        ++draws;
+
+    std::string text = toPgn(game);
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        pgn << text << std::flush;
+        ++finished;
+        std::cout << "Game " << (game.index + 1) << ": " << game.result << " (" << game.termination << "), "
+                  << finished << "/" << options.games << " done" << std::endl;
+    }
+
+    if (onGameFinished && onGameFinished(game))
+        stopRequested = true;
+}
+
+std::string SelfPlay::toPgn(const SelfPlayGame& game) const
+{
+    const std::string& white = options.engines[game.whiteEngine].name;
+    const std::string& black = options.engines[1 - game.whiteEngine].name;
+
+    std::ostringstream out;
+    out << "[Event \"Self-play\"]\n";
+    out << "[Site \"local\"]\n";
+    out << "[Date \"" << date << "\"]\n";
+    out << "[Round \"" << (game.index + 1) << "\"]\n";
+    out << "[White \"" << white << "\"]\n";
+    out << "[Black \"" << black << "\"]\n";
+    out << "[Result \"" << game.result << "\"]\n";
+    if (options.fischer)
+        out << "[Variant \"Chess960\"]\n";
+    if (game.startFen != FastBoard::START_FEN)
+    {
+        out << "[SetUp \"1\"]\n";
+        out << "[FEN \"" << game.startFen << "\"]\n";
+    }
+    if (options.nodesPerMove == 0)
+        out << "[TimeControl \"" << options.baseSeconds << "+" << options.incrementSeconds << "\"]\n";
+    out << "[Termination \"" << game.termination << "\"]\n\n";
+
+    FastBoard pos;
+    pos.setFen(game.startFen);
+    int moveNumber = pos.getFullmoveNumber();
+    bool whiteToMove = pos.sideToMove() == SIDE_WHITE;
+
+    // ходы строками не длиннее 80 символов
+    std::string line;
+    auto append = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80)
+        {
+            out << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    };
+
+    for (size_t i = 0; i < game.sanMoves.size(); ++i)
+    {
+        if (whiteToMove)
+            append(std::to_string(moveNumber) + ".");
+        else if (i == 0)
+            append(std::to_string(moveNumber) + "...");
+        append(game.sanMoves[i]);
+        if (!whiteToMove)
+            ++moveNumber;
+        whiteToMove = !whiteToMove;
+    }
+    append(game.result);
+    out << line << "\n\n";
+    return out.str();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "../core/FastBoard.h"
+#include "../core/Search.h"
+#include "../core/Tablebase.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SelfPlayEngine
+{
+    std::string name = "Chess";
+    size_t hashMb = 16;
+    SearchParams params;
+};
+
+struct SelfPlayOptions
+{
+    int games = 100;
+    size_t threads = 0;             // 0 - по числу ядер
+    float baseSeconds = 10.f;
+    float incrementSeconds = 0.1f;
+    uint64_t nodesPerMove = 0;      // если задано - ход по числу узлов вместо часов
+    std::string openingsFile;       // EPD; пусто - начальная позиция или позиции Фишера
+    bool fischer = false;
+    unsigned seed = 1;
+    bool repeatOpenings = false;    // каждая позиция играется дважды со сменой цвета
+    std::string pgnPath = "selfplay.pgn";
+    std::string tablebasePath = "tb";
+    SelfPlayEngine engines[2];
+};
+
+struct SelfPlayGame
+{
+    int index = 0;
+    int whiteEngine = 0;            // индекс в SelfPlayOptions::engines
+    std::string startFen;
+    std::vector<std::string> sanMoves;
+    std::string result;             // "1-0", "0-1", "1/2-1/2"
+    std::string termination;
+};
+
+// Партии движка против движка без окна: пул потоков, по одной партии на поток за раз,
+// у каждой партии свои часы. Готовые партии сразу дописываются в PGN.
+class SelfPlay
+{
+public:
+    explicit SelfPlay(SelfPlayOptions options);
+
+    bool run();
+    // Вызывается из рабочих потоков после каждой партии; true - прекратить турнир
+    void setOnGameFinished(std::function<bool(const SelfPlayGame&)> callback);
+
+    int getWhiteWins() const { return whiteWins; }
+    int getBlackWins() const { return blackWins; }
+    int getDraws() const { return draws; }
+
+private:
+    SelfPlayOptions options;
+    std::vector<std::string> openings;
+    std::shared_ptr<const Tablebase> tablebase;
+    std::function<bool(const SelfPlayGame&)> onGameFinished;
+    std::string date;
+
+    std::ofstream pgn;
+    std::mutex outputMutex;
+    std::atomic<int> nextGame { 0 };
+    std::atomic<bool> stopRequested { false };
+    std::atomic<int> whiteWins { 0 };
+    std::atomic<int> blackWins { 0 };
+    std::atomic<int> draws { 0 };
+    int finished = 0;
+
+    bool loadOpenings();
+    std::string openingFor(int game) const;
+    void worker();
+    SelfPlayGame playGame(int index, Search* engines[2]);
+    void finishGame(const SelfPlayGame& game);
+    std::string toPgn(const SelfPlayGame& game) const;
+};
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "SelfPlay.h"
+#include <iostream>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "Usage: selfplay [-games N] [-threads N] [-tc 10+0.1] [-nodes N] [-openings file.epd] [-fischer]"
+              << " [-seed N] [-repeat] [-pgn selfplay.pgn] [-hash MB] [-tb dir]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    SelfPlayOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-games" && hasValue)
+            options.games = std::stoi(argv[++i]);
+        else if (arg == "-threads" && hasValue)
+            options.threads = std::stoul(argv[++i]);
+        else if (arg == "-tc" && hasValue)
+        {
+            // "база+добавка" в секундах
+            std::string tc = argv[++i];
+            size_t plus = tc.find('+');
+            options.baseSeconds = std::stof(tc.substr(0, plus));
+            options.incrementSeconds = plus == std::string::npos ? 0.f : std::stof(tc.substr(plus + 1));
+        }
+        else if (arg == "-nodes" && hasValue)
+            options.nodesPerMove = std::stoull(argv[++i]);
+        else if (arg == "-openings" && hasValue)
+            options.openingsFile = argv[++i];
+        else if (arg == "-fischer")
+            options.fischer = true;
+        else if (arg == "-seed" && hasValue)
+            options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "-repeat")
+            options.repeatOpenings = true;
+        else if (arg == "-pgn" && hasValue)
+            options.pgnPath = argv[++i];
+        else if (arg == "-hash" && hasValue)
+            options.engines[0].hashMb = options.engines[1].hashMb = std::stoul(argv[++i]);
+        else if (arg == "-tb" && hasValue)
+            options.tablebasePath = argv[++i];
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    std::cout << "--- Self-play runner ---" << std::endl;
+
+    try
+    {
+        SelfPlay selfPlay(options);
+        return selfPlay.run() ? 0 : -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+}
\ No newline at end of file
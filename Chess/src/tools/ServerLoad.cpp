@@ -0,0 +1,339 @@
+#include "ServerLoad.h"
+#include "../network/PacketType.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Ходы по кругу: конями туда и обратно, позиция всегда легальна
+static const int KNIGHT_CYCLE[4][4] = {
+    { 6, 0, 5, 2 }, // g1f3
+    { 6, 7, 5, 5 }, // g8f6
+    { 5, 2, 6, 0 }, // f3g1
+    { 5, 5, 6, 7 }  // f6g8
+};
+
+// Кадры в формате sf::Packet: длина и числа в big-endian, строка - длина и байты
+static void putInt(std::vector<uint8_t>& out, int32_t value)
+{
+    uint32_t v = static_cast<uint32_t>(value);
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static int32_t getInt(const uint8_t* data)
+{
+    return static_cast<int32_t>((uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3]);
+}
+
+static void putString(std::vector<uint8_t>& out, const std::string& text)
+{
+    putInt(out, static_cast<int32_t>(text.size()));
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+static std::vector<uint8_t> frame(const std::vector<uint8_t>& payload)
+{
+    std::vector<uint8_t> out;
+    putInt(out, static_cast<int32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+static std::vector<uint8_t> movePacket(int ply)
+{
+    const int* m = KNIGHT_CYCLE[ply % 4];
+    std::vector<uint8_t> payload;
+    putInt(payload, static_cast<int>(PacketType::Move));
+    for (int i = 0; i < 4; ++i)
+        putInt(payload, m[i]);
+    payload.push_back(0); // castling
+    payload.push_back(0); // promotion
+    payload.push_back(0); // capture
+    putString(payload, "");
+    return frame(payload);
+}
+
+static std::vector<uint8_t> configPacket()
+{
+    std::vector<uint8_t> payload;
+    putInt(payload, static_cast<int>(PacketType::GameConfig));
+    putInt(payload, 0);  // белые
+    putInt(payload, 10); // минут
+    putInt(payload, 0);  // добавка
+    putInt(payload, 0);  // классика
+    putInt(payload, 0);  // seed
+    return frame(payload);
+}
+
+static bool writeAll(int fd, const std::vector<uint8_t>& data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n > 0)
+            sent += static_cast<size_t>(n);
+        else if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        else
+            return false;
+    }
+    return true;
+}
+
+static bool readExact(int fd, uint8_t* data, size_t size)
+{
+    size_t got = 0;
+    while (got < size)
+    {
+        ssize_t n = ::recv(fd, data + got, size - got, 0);
+        if (n > 0)
+            got += static_cast<size_t>(n);
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Блокирующее чтение до пакета нужного типа (на этапе рассадки по комнатам)
+static bool waitFor(int fd, PacketType type, std::vector<uint8_t>& payload)
+{
+    while (true)
+    {
+        uint8_t header[4];
+        if (!readExact(fd, header, 4))
+            return false;
+        payload.resize(static_cast<uint32_t>(getInt(header)));
+        if (!readExact(fd, payload.data(), payload.size()))
+            return false;
+        if (payload.size() >= 4 && getInt(payload.data()) == static_cast<int>(type))
+            return true;
+    }
+}
+
+static int connectTo(const sockaddr_in& addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+struct LoadPlayer
+{
+    int fd = -1;
+    int game = 0;
+    std::vector<uint8_t> input;
+    bool spectator = false;
+};
+
+struct LoadGame
+{
+    int players[2] = { -1, -1 }; // индексы в списке игроков; 0 - белые
+    int ply = 0;
+    Clock::time_point sentAt;
+};
+
+ServerLoad::ServerLoad(const ServerLoadOptions& options)
+    : options(options)
+{
+}
+
+bool ServerLoad::run(ServerLoadReport& report)
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1)
+    {
+        std::cerr << "Bad server address: " << options.host << std::endl;
+        return false;
+    }
+
+    std::vector<int> idleFds;
+    for (int i = 0; i < options.idle; ++i)
+    {
+        int fd = connectTo(addr);
+        if (fd < 0)
+        {
+            std::cerr << "Idle connection " << i << " failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        idleFds.push_back(fd);
+    }
+
+    // рассадка: хост создаёт комнату, гость входит по коду, оба шлют конфиг и ждут старта
+    std::vector<LoadPlayer> players;
+    std::vector<LoadGame> games;
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> config = configPacket();
+    for (int g = 0; g < options.active / 2; ++g)
+    {
+        int host = connectTo(addr);
+        int guest = host < 0 ? -1 : connectTo(addr);
+        if (guest < 0)
+        {
+            std::cerr << "Player connection failed: " << strerror(errno) << std::endl;
+            if (host >= 0)
+                close(host);
+            break;
+        }
+
+        std::vector<uint8_t> create;
+        putInt(create, static_cast<int>(PacketType::CreateRoom));
+        if (!writeAll(host, frame(create)) || !waitFor(host, PacketType::RoomJoined, payload) || payload.size() < 8)
+        {
+            std::cerr << "Room creation failed" << std::endl;
+            close(host);
+            close(guest);
+            break;
+        }
+        std::string code(payload.begin() + 8, payload.end());
+
+        std::vector<uint8_t> join;
+        putInt(join, static_cast<int>(PacketType::JoinRoom));
+        putString(join, code);
+        bool ok = writeAll(host, config) && writeAll(guest, frame(join)) && writeAll(guest, config)
+            && waitFor(host, PacketType::StartGame, payload) && waitFor(guest, PacketType::StartGame, payload);
+        if (!ok)
+        {
+            std::cerr << "Room " << code << " did not start" << std::endl;
+            close(host);
+            close(guest);
+            break;
+        }
+
+        LoadGame game;
+        game.players[0] = static_cast<int>(players.size());
+        game.players[1] = static_cast<int>(players.size()) + 1;
+        games.push_back(game);
+        players.push_back({ host, g, {} });
+        players.push_back({ guest, g, {} });
+
+        // зрители приходят в начавшуюся партию и сразу получают снимок
+        std::vector<uint8_t> spectate;
+        putInt(spectate, static_cast<int>(PacketType::Spectate));
+        putString(spectate, code);
+        for (int s = 0; s < options.spectators; ++s)
+        {
+            int fd = connectTo(addr);
+            if (fd < 0 || !writeAll(fd, frame(spectate)) || !waitFor(fd, PacketType::Snapshot, payload))
+            {
+                std::cerr << "Spectator of room " << code << " failed" << std::endl;
+                if (fd >= 0)
+                    close(fd);
+                break;
+            }
+            players.push_back({ fd, g, {}, true });
+        }
+    }
+
+    report.connected = static_cast<int>(idleFds.size() + players.size());
+    report.games = static_cast<int>(games.size());
+
+    int epollFd = epoll_create1(0);
+    for (size_t i = 0; i < players.size(); ++i)
+    {
+        fcntl(players[i].fd, F_SETFL, fcntl(players[i].fd, F_GETFL, 0) | O_NONBLOCK);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, players[i].fd, &ev);
+    }
+
+    std::vector<std::vector<uint8_t>> moves;
+    for (int ply = 0; ply < 4; ++ply)
+        moves.push_back(movePacket(ply));
+
+    std::vector<uint32_t> latencies;
+    latencies.reserve(1 << 20);
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::seconds(options.seconds);
+    for (auto& game : games)
+    {
+        game.sentAt = Clock::now();
+        writeAll(players[game.players[0]].fd, moves[0]);
+    }
+
+    epoll_event events[256];
+    uint8_t chunk[16 * 1024];
+    while (Clock::now() < end)
+    {
+        int count = epoll_wait(epollFd, events, 256, 100);
+        for (int e = 0; e < count; ++e)
+        {
+            LoadPlayer& player = players[events[e].data.u32];
+            ssize_t n;
+            while ((n = ::recv(player.fd, chunk, sizeof(chunk), 0)) > 0)
+                player.input.insert(player.input.end(), chunk, chunk + n);
+
+            size_t offset = 0;
+            while (player.input.size() - offset >= 4)
+            {
+                uint32_t length = static_cast<uint32_t>(getInt(player.input.data() + offset));
+                if (player.input.size() - offset - 4 < length)
+                    break;
+                int type = length >= 4 ? getInt(player.input.data() + offset + 4) : -1;
+                offset += 4 + length;
+                if (type != static_cast<int>(PacketType::Move))
+                    continue;
+                if (player.spectator)
+                {
+                    ++report.watched;
+                    continue;
+                }
+
+                LoadGame& game = games[player.game];
+                Clock::time_point now = Clock::now();
+                latencies.push_back(static_cast<uint32_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - game.sentAt).count()));
+                ++report.moves;
+
+                game.ply++;
+                game.sentAt = now;
+                writeAll(player.fd, moves[game.ply % 4]);
+            }
+            player.input.erase(player.input.begin(), player.input.begin() + offset);
+        }
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        report.p50Us = latencies[latencies.size() / 2];
+        report.p99Us = latencies[latencies.size() * 99 / 100];
+        report.maxUs = latencies.back();
+    }
+
+    close(epollFd);
+    for (auto& player : players)
+        close(player.fd);
+    for (int fd : idleFds)
+        close(fd);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct ServerLoadOptions
+{
+    std::string host = "127.0.0.1";
+    unsigned short port = 53000;
+    int idle = 0;       // соединения, которые только держатся открытыми
+    int active = 1000;  // игроки, по двое в комнате, ходят без пауз
+    int spectators = 0; // зрители каждой партии
+    int seconds = 10;
+};
+
+struct ServerLoadReport
+{
+    int connected = 0;
+    int games = 0;
+    uint64_t moves = 0;
+    uint64_t watched = 0; // ходы, полученные зрителями
+    double seconds = 0;
+    // Задержка пересылки хода: от отправки одним игроком до получения другим
+    double p50Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+};
+
+// Нагрузочный тест сервера через loopback. Игроки попарно создают комнаты и входят в них
+// по коду, затем перебрасываются ходами конями (g1f3 g8f6 f3g1 f6g8 ...), каждый ход -
+// сразу по получению хода соперника. Только Linux: клиенты обслуживаются через epoll.
+class ServerLoad
+{
+public:
+    explicit ServerLoad(const ServerLoadOptions& options);
+
+    bool run(ServerLoadReport& report);
+
+private:
+    ServerLoadOptions options;
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "ServerLoad.h"
+#include <iostream>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "Usage: server-load [-host 127.0.0.1] [-port 53000] [-idle N] [-active N] [-spectators N] [-seconds N]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    ServerLoadOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-host" && hasValue)
+            options.host = argv[++i];
+        else if (arg == "-port" && hasValue)
+            options.port = static_cast<unsigned short>(std::stoi(argv[++i]));
+        else if (arg == "-idle" && hasValue)
+            options.idle = std::stoi(argv[++i]);
+        else if (arg == "-active" && hasValue)
+            options.active = std::stoi(argv[++i]);
+        else if (arg == "-spectators" && hasValue)
+            options.spectators = std::stoi(argv[++i]);
+        else if (arg == "-seconds" && hasValue)
+            options.seconds = std::stoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    ServerLoad load(options);
+    ServerLoadReport report;
+    if (!load.run(report))
+        return -1;
+
+    std::cout << "Connections: " << report.connected << ", games: " << report.games << std::endl;
+    std::cout << "Moves relayed: " << report.moves << " in " << report.seconds << " s ("
+              << static_cast<uint64_t>(report.moves / report.seconds) << " moves/s)" << std::endl;
+    if (report.watched)
+        std::cout << "Moves delivered to spectators: " << report.watched << " ("
+                  << static_cast<uint64_t>(report.watched / report.seconds) << " moves/s)" << std::endl;
+    std::cout << "Relay latency, us: p50 " << report.p50Us << ", p99 " << report.p99Us << ", max " << report.maxUs << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "Sprt.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+static double expectedScore(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+static double eloFromScore(double score)
+{
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+Sprt::Sprt(SprtOptions options)
+    : options(options)
+{
+}
+
+void Sprt::addPair(double score)
+{
+    int index = static_cast<int>(std::lround(score * 2));
+    ++counts[std::clamp(index, 0, 4)];
+}
+
+int Sprt::getPairs() const
+{
+    int pairs = 0;
+    for (int c : counts)
+        pairs += c;
+    return pairs;
+}
+
+void Sprt::getStats(double& mean, double& variance) const
+{
+    // к каждому исходу добавляем четверть пары: на первых парах дисперсия не схлопывается
+    // и тест не останавливается по единственному результату
+    double n = 0, freq[5];
+    for (int i = 0; i < 5; ++i)
+    {
+        freq[i] = counts[i] + 0.25;
+        n += freq[i];
+    }
+
+    mean = 0;
+    for (int i = 0; i < 5; ++i)
+        mean += freq[i] / n * (i / 4.0);
+    variance = 0;
+    for (int i = 0; i < 5; ++i)
+        variance += freq[i] / n * (i / 4.0 - mean) * (i / 4.0 - mean);
+}
+
+double Sprt::getLlr() const
+{
+    int pairs = getPairs();
+    if (pairs == 0)
+        return 0;
+
+    double mean, variance;
+    getStats(mean, variance);
+    double s0 = expectedScore(options.elo0), s1 = expectedScore(options.elo1);
+    return pairs * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance);
+}
+
+double Sprt::getLowerBound() const
+{
+    return std::log(options.beta / (1 - options.alpha));
+}
+
+double Sprt::getUpperBound() const
+{
+    return std::log((1 - options.beta) / options.alpha);
+}
+
+Sprt::Decision Sprt::getDecision() const
+{
+    double llr = getLlr();
+    if (llr >= getUpperBound())
+        return Decision::AcceptH1;
+    if (llr <= getLowerBound())
+        return Decision::AcceptH0;
+    return Decision::Continue;
+}
+
+double Sprt::getElo(double& margin) const
+{
+    int pairs = getPairs();
+    double mean, variance;
+    getStats(mean, variance);
+    if (pairs == 0)
+    {
+        margin = 0;
+        return 0;
+    }
+
+    double deviation = 1.96 * std::sqrt(variance / pairs);
+    double elo = eloFromScore(mean);
+    margin = (eloFromScore(mean + deviation) - eloFromScore(mean - deviation)) / 2;
+    return elo;
+}
+
+std::string Sprt::formatStatus() const
+{
+    double margin;
+    double elo = getElo(margin);
+
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    out << "Pairs " << getPairs() << " [" << counts[0] << " " << counts[1] << " " << counts[2] << " " << counts[3] << " " << counts[4]
+        << "] Elo " << elo << " +- " << margin << " LLR " << getLlr() << " (" << getLowerBound() << ", " << getUpperBound() << ")";
+    return out.str();
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+
+struct SprtOptions
+{
+    double elo0 = 0;    // H0: разница не больше elo0
+    double elo1 = 5;    // H1: разница не меньше elo1
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// Обобщённый SPRT по парам партий (одна позиция, цвета меняются): пентаномиальная статистика,
+// логарифм отношения правдоподобия в нормальном приближении. Оценки Elo - логистические.
+class Sprt
+{
+public:
+    enum class Decision
+    {
+        Continue,
+        AcceptH0,
+        AcceptH1
+    };
+
+    explicit Sprt(SprtOptions options);
+
+    // Счёт пары для первого движка: 0, 0.5, 1, 1.5 или 2
+    void addPair(double score);
+
+    double getLlr() const;
+    double getLowerBound() const;
+    double getUpperBound() const;
+    Decision getDecision() const;
+    int getPairs() const;
+    // Разница Elo и половина 95% доверительного интервала
+    double getElo(double& margin) const;
+    std::string formatStatus() const;
+
+private:
+    SprtOptions options;
+    int counts[5] = {};
+
+    void getStats(double& mean, double& variance) const;
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "SelfPlay.h"
+#include "Sprt.h"
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "Usage: sprt -engine name=New [hash=16] [nullmove|lmr|futility=on|off] [aspiration|fmargin|rfmargin=N]"
+              << " -engine name=Base [...] [-elo0 0] [-elo1 5] [-alpha 0.05] [-beta 0.05] [-games 20000] [-threads N]"
+              << " [-tc 10+0.1 | -nodes N] [-openings file.epd] [-fischer] [-seed N] [-pgn sprt.pgn] [-tb dir]" << std::endl;
+}
+
+// Параметры движка "ключ=значение" до следующего ключа командной строки
+static bool parseEngine(int argc, char* argv[], int& i, SelfPlayEngine& engine)
+{
+    while (i + 1 < argc && argv[i + 1][0] != '-')
+    {
+        std::string arg = argv[++i];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos)
+            return false;
+        std::string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+        if (key == "name")
+            engine.name = value;
+        else if (key == "hash")
+            engine.hashMb = std::stoul(value);
+        else if (!engine.params.set(key, value))
+        {
+            std::cerr << "Unknown engine option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    SelfPlayOptions options;
+    options.games = 20000;
+    options.pgnPath = "sprt.pgn";
+    options.repeatOpenings = true;
+    options.engines[0].name = "New";
+    options.engines[1].name = "Base";
+    SprtOptions sprtOptions;
+    int engines = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        bool ok = true;
+
+        if (arg == "-engine" && engines < 2)
+            ok = parseEngine(argc, argv, i, options.engines[engines++]);
+        else if (arg == "-elo0" && hasValue)
+            sprtOptions.elo0 = std::stod(argv[++i]);
+        else if (arg == "-elo1" && hasValue)
+            sprtOptions.elo1 = std::stod(argv[++i]);
+        else if (arg == "-alpha" && hasValue)
+            sprtOptions.alpha = std::stod(argv[++i]);
+        else if (arg == "-beta" && hasValue)
+            sprtOptions.beta = std::stod(argv[++i]);
+        else if (arg == "-games" && hasValue)
+            options.games = std::stoi(argv[++i]);
+        else if (arg == "-threads" && hasValue)
+            options.threads = std::stoul(argv[++i]);
+        else if (arg == "-tc" && hasValue)
+        {
+            std::string tc = argv[++i];
+            size_t plus = tc.find('+');
+            options.baseSeconds = std::stof(tc.substr(0, plus));
+            options.incrementSeconds = plus == std::string::npos ? 0.f : std::stof(tc.substr(plus + 1));
+        }
+        else if (arg == "-nodes" && hasValue)
+            options.nodesPerMove = std::stoull(argv[++i]);
+        else if (arg == "-openings" && hasValue)
+            options.openingsFile = argv[++i];
+        else if (arg == "-fischer")
+            options.fischer = true;
+        else if (arg == "-seed" && hasValue)
+            options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "-pgn" && hasValue)
+            options.pgnPath = argv[++i];
+        else if (arg == "-tb" && hasValue)
+            options.tablebasePath = argv[++i];
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    // пары партий: чётная и следующая нечётная играются из одной позиции
+    options.games += options.games % 2;
+
+    std::cout << "--- SPRT: " << options.engines[0].name << " vs " << options.engines[1].name
+              << ", elo0 " << sprtOptions.elo0 << " elo1 " << sprtOptions.elo1 << " ---" << std::endl;
+
+    try
+    {
+        Sprt sprt(sprtOptions);
+        std::mutex sprtMutex;
+        std::map<int, std::pair<int, double>> pendingPairs; // номер пары -> (сыграно партий, очки первого движка)
+
+        SelfPlay selfPlay(options);
+        selfPlay.setOnGameFinished([&](const SelfPlayGame& game) {
+            double score = game.result == "1/2-1/2" ? 0.5 : (game.result == "1-0") == (game.whiteEngine == 0) ? 1.0 : 0.0;
+
+            std::lock_guard<std::mutex> lock(sprtMutex);
+            if (sprt.getDecision() != Sprt::Decision::Continue)
+                return true;
+
+            auto& pair = pendingPairs[game.index / 2];
+            pair.second += score;
+            if (++pair.first < 2)
+                return false;
+
+            sprt.addPair(pair.second);
+            pendingPairs.erase(game.index / 2);
+            std::cout << sprt.formatStatus() << std::endl;
+            return sprt.getDecision() != Sprt::Decision::Continue;
+        });
+
+        if (!selfPlay.run())
+            return -1;
+
+        std::cout << sprt.formatStatus() << std::endl;
+        switch (sprt.getDecision())
+        {
+        case Sprt::Decision::AcceptH1:
+            std::cout << "H1 accepted: " << options.engines[0].name << " is stronger" << std::endl;
+            break;
+        case Sprt::Decision::AcceptH0:
+            std::cout << "H0 accepted: no improvement" << std::endl;
+            break;
+        default:
+            std::cout << "Inconclusive: game limit reached" << std::endl;
+            break;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "TablebaseGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// Значение ещё не решённой позиции (в готовых файлах не встречается)
+static const uint8_t UNKNOWN = 254;
+static const int MAX_WIN = Tablebase::LOSS_BASE - 1;
+static const int MAX_LOSS = UNKNOWN - 1 - Tablebase::LOSS_BASE;
+
+static const uint8_t DRAW_ESCAPE = 1;   // есть ход в ничейную позицию меньшей таблицы
+static const uint8_t WIN_CANDIDATE = 2; // есть ход в проигранную соперником позицию меньшей таблицы
+
+TablebaseGenerator::TablebaseGenerator(TablebaseGeneratorOptions options)
+    : options(std::move(options))
+{
+    if (this->options.threads == 0)
+        this->options.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+bool TablebaseGenerator::generateAll()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(options.directory, ec);
+
+    for (const auto& name : TbLayout::allNames(options.maxPieces))
+    {
+        if (!generate(name))
+            return false;
+    }
+    return true;
+}
+
+void TablebaseGenerator::setupPosition(FastBoard& pos, const int* squares, int stm) const
+{
+    pos.clear();
+    for (int i = 0; i < layout.getPieceCount(); ++i)
+        pos.putPiece(layout.getPieceSide(i), layout.getPieceType(i), squares[i]);
+    pos.setSideToMove(stm);
+}
+
+void TablebaseGenerator::runParallel(uint64_t tasks, uint64_t chunk, void (TablebaseGenerator::*job)(uint64_t, uint64_t, size_t))
+{
+    std::atomic<uint64_t> next { 0 };
+    auto worker = [&](size_t thread) {
+        while (true)
+        {
+            uint64_t begin = next.fetch_add(chunk);
+            if (begin >= tasks)
+                break;
+            (this->*job)(begin, std::min(tasks, begin + chunk), thread);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < options.threads; ++t)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (auto& t : threads)
+        t.join();
+}
+
+void TablebaseGenerator::mergeThreadOutput()
+{
+    for (auto& out : threadResolved)
+    {
+        for (const auto& [level, idx] : out)
+            resolved[level].push_back(idx);
+        out.clear();
+    }
+    for (auto& out : threadCandidates)
+    {
+        for (const auto& [level, idx] : out)
+            candidates[level].push_back(idx);
+        out.clear();
+    }
+}
+
+bool TablebaseGenerator::generate(const std::string& name)
+{
+    if (!layout.init(name))
+    {
+        std::cerr << "Unknown table: " << name << std::endl;
+        return false;
+    }
+
+    std::string path = Tablebase::fileName(options.directory, name);
+    if (!options.overwrite && std::filesystem::exists(path))
+    {
+        std::cout << name << ": already exists" << std::endl;
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    smaller = std::make_unique<Tablebase>(options.directory);
+    missingTable = false;
+
+    uint64_t size = layout.size();
+    values = std::vector<std::atomic<uint8_t>>(size);
+    remaining = std::vector<std::atomic<uint8_t>>(size);
+    for (auto& v : values)
+        v.store(UNKNOWN, std::memory_order_relaxed);
+    longestEscape.assign(size, 0);
+    flags.assign(size, 0);
+    resolved.assign(MAX_WIN + 2, {});
+    candidates.assign(MAX_WIN + 2, {});
+    threadResolved.assign(options.threads, {});
+    threadCandidates.assign(options.threads, {});
+
+    // 1. Маты, паты и ходы в меньшие таблицы; каждый поток берёт целые пары королей
+    runParallel(layout.kingPairs(), 1, &TablebaseGenerator::initKingPairs);
+    mergeThreadOutput();
+    if (missingTable)
+    {
+        std::cerr << name << ": smaller tables are missing, generate them first" << std::endl;
+        return false;
+    }
+
+    // 2. Обратные ходы от позиций, решённых на уровне level, дают решения уровня level + 1 и дальше
+    for (int level = 0; level <= MAX_WIN; ++level)
+    {
+        for (uint32_t idx : candidates[level])
+        {
+            uint8_t expected = UNKNOWN;
+            if (values[idx].compare_exchange_strong(expected, static_cast<uint8_t>(level)))
+                resolved[level].push_back(idx);
+        }
+        candidates[level].clear();
+
+        currentLevel = level;
+        runParallel(resolved[level].size(), 256, &TablebaseGenerator::propagate);
+        mergeThreadOutput();
+        std::vector<uint32_t>().swap(resolved[level]);
+    }
+
+    Stats stats;
+    if (!write(stats))
+        return false;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << stats.wins << " wins, " << stats.draws << " draws, " << stats.losses
+              << " losses, longest mate " << stats.longestMate << " plies, " << seconds << " s" << std::endl;
+    return true;
+}
+
+void TablebaseGenerator::initKingPairs(uint64_t begin, uint64_t end, size_t thread)
+{
+    FastBoard pos;
+    uint64_t perPair = layout.entriesPerKingPair();
+    for (uint64_t idx = begin * perPair; idx < end * perPair; ++idx)
+        initPosition(idx, pos, thread);
+}
+
+void TablebaseGenerator::initPosition(uint64_t idx, FastBoard& pos, size_t thread)
+{
+    int squares[TbLayout::MAX_PIECES], stm;
+    layout.decode(idx, squares, stm);
+    // неканонические записи (симметричные копии) и невозможные расстановки не используются
+    if (layout.index(squares, stm) != idx)
+    {
+        values[idx].store(Tablebase::INVALID, std::memory_order_relaxed);
+        return;
+    }
+
+    setupPosition(pos, squares, stm);
+    if (pos.isAttacked(pos.kingSquare(stm ^ 1), stm))
+    {
+        values[idx].store(Tablebase::INVALID, std::memory_order_relaxed);
+        return;
+    }
+
+    MoveList list;
+    pos.generateMoves(list);
+    if (list.size == 0)
+    {
+        if (pos.inCheck())
+        {
+            values[idx].store(Tablebase::LOSS_BASE, std::memory_order_relaxed);
+            threadResolved[thread].push_back({ 0, static_cast<uint32_t>(idx) });
+        }
+        else
+            values[idx].store(Tablebase::DRAW, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t children[256];
+    int childCount = 0;
+    int bestWin = MAX_WIN + 1;
+    int longest = 0;
+    uint8_t flag = 0;
+
+    for (FastMove m : list)
+    {
+        if (pos.isCapture(m) || isPromotion(m))
+        {
+            UndoInfo undo;
+            pos.makeMove(m, undo);
+            auto result = smaller->probe(pos);
+            pos.unmakeMove(m, undo);
+
+            if (!result)
+                missingTable = true;
+            else if (result->wdl < 0)
+                bestWin = std::min(bestWin, result->dtm + 1);
+            else if (result->wdl == 0)
+                flag |= DRAW_ESCAPE;
+            else
+                longest = std::max(longest, result->dtm);
+            continue;
+        }
+
+        // тихий ход остаётся внутри таблицы; симметричные продолжения считаются одним
+        int childSquares[TbLayout::MAX_PIECES];
+        for (int i = 0; i < layout.getPieceCount(); ++i)
+            childSquares[i] = squares[i] == moveFrom(m) ? moveTo(m) : squares[i];
+        children[childCount++] = static_cast<uint32_t>(layout.index(childSquares, stm ^ 1));
+    }
+
+    std::sort(children, children + childCount);
+    childCount = static_cast<int>(std::unique(children, children + childCount) - children);
+
+    remaining[idx].store(static_cast<uint8_t>(childCount), std::memory_order_relaxed);
+    longestEscape[idx] = static_cast<uint8_t>(longest);
+
+    if (bestWin <= MAX_WIN)
+    {
+        flag |= WIN_CANDIDATE;
+        threadCandidates[thread].push_back({ bestWin, static_cast<uint32_t>(idx) });
+    }
+    else if (childCount == 0 && !(flag & DRAW_ESCAPE))
+    {
+        // все ходы ведут в меньшие таблицы, где соперник выигрывает
+        int dtm = std::min(longest + 1, MAX_LOSS);
+        values[idx].store(static_cast<uint8_t>(Tablebase::LOSS_BASE + dtm), std::memory_order_relaxed);
+        threadResolved[thread].push_back({ dtm, static_cast<uint32_t>(idx) });
+    }
+    flags[idx] = flag;
+}
+
+void TablebaseGenerator::propagate(uint64_t begin, uint64_t end, size_t thread)
+{
+    FastBoard pos;
+    const auto& list = resolved[currentLevel];
+
+    for (uint64_t n = begin; n < end; ++n)
+    {
+        uint32_t idx = list[n];
+        bool childLost = values[idx].load(std::memory_order_relaxed) >= Tablebase::LOSS_BASE;
+
+        int squares[TbLayout::MAX_PIECES], stm;
+        layout.decode(idx, squares, stm);
+        setupPosition(pos, squares, stm);
+
+        // обратные ходы стороны, сделавшей последний ход (без взятий и превращений)
+        int mover = stm ^ 1;
+        Bitboard occ = pos.occupied();
+        uint32_t parents[256];
+        int parentCount = 0;
+
+        for (int i = 0; i < layout.getPieceCount(); ++i)
+        {
+            if (layout.getPieceSide(i) != mover)
+                continue;
+            int type = layout.getPieceType(i);
+            int from = squares[i];
+
+            Bitboard targets = 0;
+            if (type == PAWN)
+            {
+                int back = mover == SIDE_WHITE ? -8 : 8;
+                int single = from + back;
+                if (rankOf(single) >= 1 && rankOf(single) <= 6 && !(occ & squareBit(single)))
+                {
+                    targets |= squareBit(single);
+                    int doubleFrom = single + back;
+                    if (rankOf(from) == (mover == SIDE_WHITE ? 3 : 4) && !(occ & squareBit(doubleFrom)))
+                        targets |= squareBit(doubleFrom);
+                }
+            }
+            else
+                targets = Attacks::piece(type, mover, from, occ) & ~occ;
+
+            while (targets)
+            {
+                int prev = popLsb(targets);
+                pos.removePiece(from);
+                pos.putPiece(mover, type, prev);
+                bool legal = !pos.isAttacked(pos.kingSquare(stm), mover);
+                pos.removePiece(prev);
+                pos.putPiece(mover, type, from);
+                if (!legal)
+                    continue;
+
+                int parentSquares[TbLayout::MAX_PIECES];
+                std::copy(squares, squares + layout.getPieceCount(), parentSquares);
+                parentSquares[i] = prev;
+                uint64_t parent = layout.index(parentSquares, mover);
+                if (parent != TbLayout::NO_INDEX)
+                    parents[parentCount++] = static_cast<uint32_t>(parent);
+            }
+        }
+
+        std::sort(parents, parents + parentCount);
+        parentCount = static_cast<int>(std::unique(parents, parents + parentCount) - parents);
+
+        for (int p = 0; p < parentCount; ++p)
+        {
+            uint32_t parent = parents[p];
+            uint8_t expected = UNKNOWN;
+            if (childLost)
+            {
+                // соперник проигрывает после нашего хода - выигрываем на полуход дольше
+                int dtm = std::min(currentLevel + 1, MAX_WIN);
+                if (values[parent].compare_exchange_strong(expected, static_cast<uint8_t>(dtm)))
+                    threadResolved[thread].push_back({ dtm, parent });
+                continue;
+            }
+
+            if (values[parent].load(std::memory_order_relaxed) != UNKNOWN)
+                continue;
+            if (remaining[parent].fetch_sub(1) != 1 || (flags[parent] & (DRAW_ESCAPE | WIN_CANDIDATE)))
+                continue;
+
+            // все ходы проигрывают: сопротивляемся как можно дольше
+            int dtm = std::min(std::max<int>(currentLevel, longestEscape[parent]) + 1, MAX_LOSS);
+            if (values[parent].compare_exchange_strong(expected, static_cast<uint8_t>(Tablebase::LOSS_BASE + dtm)))
+                threadResolved[thread].push_back({ dtm, parent });
+        }
+    }
+}
+
+bool TablebaseGenerator::write(Stats& stats)
+{
+    smaller.reset();
+    std::string path = Tablebase::fileName(options.directory, layout.getName());
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+
+    Tablebase::Header header {};
+    header.magic = Tablebase::MAGIC;
+    header.pieces = static_cast<uint32_t>(layout.getPieceCount());
+    layout.getName().copy(header.name, sizeof(header.name) - 1);
+    header.entries = layout.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(1 << 16);
+    for (uint64_t idx = 0; idx < layout.size(); ++idx)
+    {
+        uint8_t value = values[idx].load(std::memory_order_relaxed);
+        if (value == UNKNOWN)
+            value = Tablebase::DRAW; // ни выигрыша, ни вынужденного проигрыша - ничья
+
+        if (value == Tablebase::DRAW)
+            ++stats.draws;
+        else if (value < Tablebase::LOSS_BASE)
+        {
+            ++stats.wins;
+            stats.longestMate = std::max<int>(stats.longestMate, value);
+        }
+        else if (value != Tablebase::INVALID)
+            ++stats.losses;
+
+        buffer.push_back(value);
+        if (buffer.size() == buffer.capacity())
+        {
+            out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+    values = std::vector<std::atomic<uint8_t>>();
+    remaining = std::vector<std::atomic<uint8_t>>();
+    return static_cast<bool>(out);
+}
\ No newline at end of file
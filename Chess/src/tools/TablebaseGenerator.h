@@ -0,0 +1,60 @@
+#pragma once
+#include "../core/Tablebase.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TablebaseGeneratorOptions
+{
+    std::string directory = "tb";
+    int maxPieces = 4;
+    size_t threads = 0; // 0 - по числу ядер
+    bool overwrite = false;
+};
+
+// Ретроградный анализ: сначала все позиции таблицы оцениваются по ходам, уводящим в меньшие таблицы
+// (взятия, превращения), затем от матов и уже решённых позиций по уровням DTM идём обратными ходами
+// к предшественникам. Работа делится между потоками по индексу пары королей.
+class TablebaseGenerator
+{
+public:
+    explicit TablebaseGenerator(TablebaseGeneratorOptions options);
+
+    bool generateAll();
+    bool generate(const std::string& name);
+
+private:
+    struct Stats
+    {
+        uint64_t wins = 0;
+        uint64_t draws = 0;
+        uint64_t losses = 0;
+        int longestMate = 0;
+    };
+
+    TablebaseGeneratorOptions options;
+
+    TbLayout layout;
+    std::unique_ptr<Tablebase> smaller;
+    std::vector<std::atomic<uint8_t>> values;
+    std::vector<std::atomic<uint8_t>> remaining;   // ходы внутри таблицы, которые ещё не признаны проигрышными
+    std::vector<uint8_t> longestEscape;           // самый длинный выигрыш соперника среди ходов в меньшие таблицы
+    std::vector<uint8_t> flags;
+    std::vector<std::vector<uint32_t>> resolved;  // решённые позиции по числу полуходов до мата
+    std::vector<std::vector<uint32_t>> candidates; // выигрыши через ходы в меньшие таблицы, ещё не подтверждённые
+    std::atomic<bool> missingTable { false };
+
+    // найденные потоком позиции (уровень, индекс), сливаются в общие списки после каждого шага
+    std::vector<std::vector<std::pair<int, uint32_t>>> threadResolved;
+    std::vector<std::vector<std::pair<int, uint32_t>>> threadCandidates;
+    int currentLevel = 0;
+
+    void runParallel(uint64_t tasks, uint64_t chunk, void (TablebaseGenerator::*job)(uint64_t, uint64_t, size_t));
+    void initKingPairs(uint64_t begin, uint64_t end, size_t thread);
+    void initPosition(uint64_t idx, FastBoard& pos, size_t thread);
+    void propagate(uint64_t begin, uint64_t end, size_t thread);
+    void mergeThreadOutput();
+    void setupPosition(FastBoard& pos, const int* squares, int stm) const;
+    bool write(Stats& stats);
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "TablebaseGenerator.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage()
+{
+    std::cout << "Usage: tbgen [-dir tb] [-pieces 3|4] [-threads N] [-force] [KQvK KRvKB ...]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    TablebaseGeneratorOptions options;
+    std::vector<std::string> tables;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-dir" && hasValue)
+            options.directory = argv[++i];
+        else if (arg == "-pieces" && hasValue)
+            options.maxPieces = std::stoi(argv[++i]);
+        else if (arg == "-threads" && hasValue)
+            options.threads = std::stoul(argv[++i]);
+        else if (arg == "-force")
+            options.overwrite = true;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            printUsage();
+            return -1;
+        }
+        else
+            tables.push_back(arg);
+    }
+
+    std::cout << "--- Endgame tablebase generator ---" << std::endl;
+
+    try
+    {
+        TablebaseGenerator generator(options);
+        if (tables.empty())
+            return generator.generateAll() ? 0 : -1;
+
+        for (const auto& name : tables)
+        {
+            if (!generator.generate(name))
+                return -1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
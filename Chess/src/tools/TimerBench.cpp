@@ -0,0 +1,103 @@
+#include "TimerBench.h"
+#include "../network/TimerWheel.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double nanosecondsPer(Clock::time_point start, uint64_t operations)
+{
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return operations ? ns / operations : 0;
+}
+
+TimerBench::TimerBench(const TimerBenchOptions& options)
+    : options(options)
+{
+}
+
+bool TimerBench::run(TimerBenchReport& report)
+{
+    if (options.timers <= 0 || options.spreadMs <= 0 || options.cancelPercent < 0 || options.cancelPercent > 100)
+    {
+        std::cerr << "Invalid benchmark options" << std::endl;
+        return false;
+    }
+
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<int64_t> delay(1, options.spreadMs);
+
+    // модельные часы: обработчик сверяет их со своим сроком
+    int64_t nowMs = 0;
+    TimerWheel wheel(nowMs);
+
+    auto onFire = [&report, &nowMs](int64_t deadlineMs)
+    {
+        ++report.fired;
+        if (nowMs < deadlineMs)
+            ++report.early;
+        report.maxLateMs = std::max(report.maxLateMs, nowMs - deadlineMs);
+    };
+
+    std::vector<int64_t> deadlines(options.timers);
+    for (int64_t& deadline : deadlines)
+        deadline = delay(rng);
+
+    std::vector<TimerId> ids(options.timers);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.timers; ++i)
+    {
+        int64_t deadline = deadlines[i];
+        ids[i] = wheel.schedule(deadline, [&onFire, deadline] { onFire(deadline); });
+    }
+    report.scheduleNs = nanosecondsPer(start, options.timers);
+
+    std::shuffle(ids.begin(), ids.end(), rng);
+    size_t cancelled = static_cast<size_t>(options.timers) * options.cancelPercent / 100;
+    start = Clock::now();
+    for (size_t i = 0; i < cancelled; ++i)
+        wheel.cancel(ids[i]);
+    report.cancelNs = nanosecondsPer(start, cancelled);
+
+    start = Clock::now();
+    while (wheel.size() > 0)
+    {
+        int wait = wheel.timeUntilNext(nowMs);
+        nowMs += std::max(wait, 1);
+        wheel.advance(nowMs);
+        ++report.wakeups;
+    }
+    report.fireNs = nanosecondsPer(start, report.fired);
+
+    uint64_t expected = options.timers - cancelled;
+    if (report.fired != expected)
+    {
+        std::cerr << "Fired " << report.fired << " timers, expected " << expected << std::endl;
+        return false;
+    }
+
+    // Колесо снова заполнено; каждый ход снимает таймер партии и ставит новый
+    for (int i = 0; i < options.timers; ++i)
+    {
+        int64_t deadline = nowMs + delay(rng);
+        ids[i] = wheel.schedule(deadline, [&onFire, deadline] { onFire(deadline); });
+    }
+    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    std::vector<size_t> victims(options.timers);
+    for (size_t& victim : victims)
+        victim = pick(rng);
+
+    start = Clock::now();
+    for (size_t victim : victims)
+    {
+        wheel.cancel(ids[victim]);
+        int64_t deadline = nowMs + deadlines[victim];
+        ids[victim] = wheel.schedule(deadline, [&onFire, deadline] { onFire(deadline); });
+    }
+    report.rearmNs = nanosecondsPer(start, victims.size());
+
+    return report.early == 0;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+struct TimerBenchOptions
+{
+    int timers = 1000000;  // одновременно стоящих таймеров
+    int spreadMs = 600000; // сроки равномерно в (0, spreadMs]
+    int cancelPercent = 50;
+    unsigned seed = 1;
+};
+
+struct TimerBenchReport
+{
+    // Среднее время одной операции, нс
+    double scheduleNs = 0;
+    double cancelNs = 0;
+    double fireNs = 0;
+    double rearmNs = 0; // снять таймер и поставить новый, как при каждом ходе партии с часами
+    uint64_t fired = 0;
+    uint64_t wakeups = 0; // сколько раз цикл событий просыпался, чтобы довести таймеры до срока
+    uint64_t early = 0;   // сработали раньше срока - ошибка колеса
+    int64_t maxLateMs = 0;
+};
+
+// Микробенчмарк колеса таймеров сервера на модельном времени: колесо двигается так же,
+// как в Reactor::poll - сразу к ближайшему сроку, который оно само называет.
+class TimerBench
+{
+public:
+    explicit TimerBench(const TimerBenchOptions& options);
+
+    bool run(TimerBenchReport& report);
+
+private:
+    TimerBenchOptions options;
+};
\ No newline at end of file
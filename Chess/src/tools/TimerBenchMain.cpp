@@ -0,0 +1,47 @@
+#include "TimerBench.h"
+#include <iostream>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "Usage: timer-bench [-timers N] [-spread ms] [-cancel percent] [-seed N]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    TimerBenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-timers" && hasValue)
+            options.timers = std::stoi(argv[++i]);
+        else if (arg == "-spread" && hasValue)
+            options.spreadMs = std::stoi(argv[++i]);
+        else if (arg == "-cancel" && hasValue)
+            options.cancelPercent = std::stoi(argv[++i]);
+        else if (arg == "-seed" && hasValue)
+            options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    TimerBench bench(options);
+    TimerBenchReport report;
+    bool ok = bench.run(report);
+
+    std::cout << "Timers: " << options.timers << ", spread " << options.spreadMs << " ms, cancelled "
+              << options.cancelPercent << "%" << std::endl;
+    std::cout << "ns/op: schedule " << report.scheduleNs << ", cancel " << report.cancelNs
+              << ", fire " << report.fireNs << ", cancel+schedule " << report.rearmNs << std::endl;
+    std::cout << "Fired: " << report.fired << " in " << report.wakeups << " wakeups, max lateness "
+              << report.maxLateMs << " ms" << std::endl;
+    if (report.early)
+        std::cout << "Fired early: " << report.early << std::endl;
+    return ok ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "Tuner.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+static void printUsage()
+{
+    std::cout << "Usage: tune positions.epd [-out EvalParams.h] [-iterations 1000] [-lr 1.0] [-k K] [-limit N]"
+              << " [-threads N] [-report 50]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    TunerOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-out" && hasValue)
+            options.outputPath = argv[++i];
+        else if (arg == "-iterations" && hasValue)
+            options.iterations = std::stoi(argv[++i]);
+        else if (arg == "-lr" && hasValue)
+            options.learningRate = std::stod(argv[++i]);
+        else if (arg == "-k" && hasValue)
+            options.scale = std::stod(argv[++i]);
+        else if (arg == "-limit" && hasValue)
+            options.maxPositions = std::stoul(argv[++i]);
+        else if (arg == "-threads" && hasValue)
+            options.threads = std::stoul(argv[++i]);
+        else if (arg == "-report" && hasValue)
+            options.reportEvery = std::max(1, std::stoi(argv[++i]));
+        else if (!arg.empty() && arg[0] != '-' && options.dataFile.empty())
+            options.dataFile = arg;
+        else
+        {
+            printUsage();
+            return -1;
+        }
+    }
+
+    if (options.dataFile.empty())
+    {
+        printUsage();
+        return -1;
+    }
+
+    std::cout << "--- Texel tuning of evaluation weights ---" << std::endl;
+
+    try
+    {
+        Tuner tuner(options);
+        if (!tuner.load() || !tuner.run())
+            return -1;
+        std::cout << "Weights written to " << options.outputPath << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
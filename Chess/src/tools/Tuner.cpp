@@ -0,0 +1,373 @@
+#include "Tuner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+bool PackedPosition::pack(const FastBoard& pos, int result, PackedPosition& out)
+{
+    out = PackedPosition {};
+    out.occupied = pos.occupied();
+    if (popCount(out.occupied) > 32)
+        return false;
+
+    Bitboard bb = out.occupied;
+    for (int i = 0; bb; ++i)
+    {
+        int piece = pos.pieceOn(popLsb(bb));
+        out.pieces[i / 2] |= static_cast<uint8_t>(piece << ((i & 1) * 4));
+    }
+    out.sideToMove = static_cast<uint8_t>(pos.sideToMove());
+    out.result = static_cast<uint8_t>(result);
+    return true;
+}
+
+void PackedPosition::unpack(FastBoard& pos) const
+{
+    pos.clear();
+    Bitboard bb = occupied;
+    for (int i = 0; bb; ++i)
+    {
+        int piece = (pieces[i / 2] >> ((i & 1) * 4)) & 15;
+        pos.putPiece(FastBoard::pieceSide(piece), FastBoard::pieceType(piece), popLsb(bb));
+    }
+    pos.setSideToMove(sideToMove);
+}
+
+// Результат партии из строки EPD: 2 - выиграли белые, 1 - ничья, 0 - чёрные, -1 - не найден
+static int parseResult(const std::string& line)
+{
+    size_t bracket = line.find('[');
+    if (bracket != std::string::npos)
+    {
+        double value = std::atof(line.c_str() + bracket + 1);
+        return value > 0.75 ? 2 : value > 0.25 ? 1 : 0;
+    }
+    if (line.find("1/2-1/2") != std::string::npos)
+        return 1;
+    if (line.find("1-0") != std::string::npos)
+        return 2;
+    if (line.find("0-1") != std::string::npos)
+        return 0;
+    return -1;
+}
+
+Tuner::Tuner(TunerOptions options)
+    : options(std::move(options))
+{
+    if (this->options.threads == 0)
+        this->options.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+template <typename Job>
+void Tuner::runParallel(size_t count, Job job) const
+{
+    // каждому потоку - один непрерывный блок: соседние позиции лежат рядом в памяти
+    size_t threadCount = std::min(options.threads, std::max<size_t>(1, count));
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t)
+        threads.emplace_back(job, count * t / threadCount, count * (t + 1) / threadCount, t);
+    job(0, count / threadCount, 0);
+    for (auto& t : threads)
+        t.join();
+}
+
+bool Tuner::load()
+{
+    std::ifstream in(options.dataFile);
+    if (!in)
+    {
+        std::cerr << "Cannot open positions file: " << options.dataFile << std::endl;
+        return false;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::string line;
+    size_t skipped = 0;
+    FastBoard pos;
+    while (std::getline(in, line))
+    {
+        if (options.maxPositions && positions.size() >= options.maxPositions)
+            break;
+
+        // первые четыре поля - позиция, остальное (счётчики ходов, операции EPD) не нужно
+        std::istringstream ss(line);
+        std::string placement, turn, castling, ep;
+        int result = parseResult(line);
+        PackedPosition packed;
+        if (!(ss >> placement >> turn >> castling >> ep) || result < 0
+            || !pos.setFen(placement + " " + turn + " " + castling + " " + ep + " 0 1")
+            || pos.inCheck() || !PackedPosition::pack(pos, result, packed))
+        {
+            ++skipped;
+            continue;
+        }
+        positions.push_back(packed);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "Loaded " << positions.size() << " positions (" << positions.size() * sizeof(PackedPosition) / (1024 * 1024)
+              << " MB), skipped " << skipped << ", " << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+    if (positions.empty())
+        return false;
+
+    extractFeatures();
+    return true;
+}
+
+void Tuner::extractFeatures()
+{
+    struct Block
+    {
+        std::vector<uint32_t> sizes;
+        std::vector<uint16_t> terms;
+        std::vector<int8_t> counts;
+    };
+    std::vector<Block> blocks(options.threads);
+    phases.resize(positions.size());
+    targets.resize(positions.size());
+
+    runParallel(positions.size(), [&](size_t begin, size_t end, size_t thread) {
+        Block& block = blocks[thread];
+        FastBoard pos;
+        std::vector<int> coefficients(TERM_COUNT);
+        for (size_t i = begin; i < end; ++i)
+        {
+            positions[i].unpack(pos);
+            Evaluator::trace(pos, coefficients.data());
+
+            uint32_t size = 0;
+            for (int term = 0; term < TERM_COUNT; ++term)
+            {
+                if (coefficients[term] == 0)
+                    continue;
+                block.terms.push_back(static_cast<uint16_t>(term));
+                block.counts.push_back(static_cast<int8_t>(std::clamp(coefficients[term], -127, 127)));
+                ++size;
+            }
+            block.sizes.push_back(size);
+            phases[i] = static_cast<float>(Evaluator::phase(pos)) / Evaluator::MAX_PHASE;
+            targets[i] = positions[i].result * 0.5f;
+        }
+    });
+
+    // блоки идут в порядке позиций, склеиваем их в общие массивы
+    offsets.assign(1, 0);
+    offsets.reserve(positions.size() + 1);
+    for (auto& block : blocks)
+    {
+        for (uint32_t size : block.sizes)
+            offsets.push_back(offsets.back() + size);
+        terms.insert(terms.end(), block.terms.begin(), block.terms.end());
+        counts.insert(counts.end(), block.counts.begin(), block.counts.end());
+        block = Block {};
+    }
+
+    std::vector<int> mg(TERM_COUNT), eg(TERM_COUNT);
+    Evaluator::getWeights(mg.data(), eg.data());
+    weights.resize(WEIGHT_COUNT);
+    for (int term = 0; term < TERM_COUNT; ++term)
+    {
+        weights[term] = mg[term];
+        weights[TERM_COUNT + term] = eg[term];
+    }
+
+    std::cout << "Features: " << terms.size() << " non-zero coefficients, "
+              << terms.size() * (sizeof(uint16_t) + sizeof(int8_t)) / (1024 * 1024) << " MB" << std::endl;
+}
+
+// Оценка белых при текущих весах (без округлений Evaluator)
+double Tuner::positionEval(size_t i) const
+{
+    const double* w = weights.data();
+    double mg = 0, eg = 0;
+    for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j)
+    {
+        mg += w[terms[j]] * counts[j];
+        eg += w[TERM_COUNT + terms[j]] * counts[j];
+    }
+    return mg * phases[i] + eg * (1.0 - phases[i]);
+}
+
+static double sigmoid(double k, double eval)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+double Tuner::computeLoss(double k) const
+{
+    std::vector<double> sums(options.threads, 0.0);
+    runParallel(positions.size(), [&](size_t begin, size_t end, size_t thread) {
+        double sum = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            double diff = targets[i] - sigmoid(k, positionEval(i));
+            sum += diff * diff;
+        }
+        sums[thread] = sum;
+    });
+
+    double total = 0;
+    for (double sum : sums)
+        total += sum;
+    return total / positions.size();
+}
+
+double Tuner::computeGradient(std::vector<double>& gradient) const
+{
+    std::vector<std::vector<double>> partial(options.threads);
+    std::vector<double> sums(options.threads, 0.0);
+    runParallel(positions.size(), [&](size_t begin, size_t end, size_t thread) {
+        std::vector<double>& g = partial[thread];
+        g.assign(WEIGHT_COUNT, 0.0);
+        double sum = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            double s = sigmoid(scale, positionEval(i));
+            double diff = s - targets[i];
+            sum += diff * diff;
+
+            // производная квадрата ошибки по оценке, дальше раскладывается на веса миттельшпиля и эндшпиля
+            double d = diff * s * (1.0 - s);
+            double dMg = d * phases[i];
+            double dEg = d - dMg;
+            for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j)
+            {
+                g[terms[j]] += dMg * counts[j];
+                g[TERM_COUNT + terms[j]] += dEg * counts[j];
+            }
+        }
+        sums[thread] = sum;
+    });
+
+    double factor = 2.0 * scale * std::log(10.0) / 400.0 / positions.size();
+    gradient.assign(WEIGHT_COUNT, 0.0);
+    double total = 0;
+    for (size_t t = 0; t < partial.size(); ++t)
+    {
+        for (int w = 0; w < WEIGHT_COUNT && !partial[t].empty(); ++w)
+            gradient[w] += partial[t][w] * factor;
+        total += sums[t];
+    }
+    return total / positions.size();
+}
+
+// K, при котором исходные веса лучше всего предсказывают результаты (ошибка унимодальна по K)
+double Tuner::findScale() const
+{
+    double low = 0.1, high = 3.0;
+    for (int i = 0; i < 40; ++i)
+    {
+        double a = low + (high - low) / 3, b = high - (high - low) / 3;
+        if (computeLoss(a) < computeLoss(b))
+            high = b;
+        else
+            low = a;
+    }
+    return (low + high) / 2;
+}
+
+bool Tuner::run()
+{
+    scale = options.scale > 0 ? options.scale : findScale();
+    std::cout << "K = " << std::setprecision(4) << scale << ", initial loss " << std::setprecision(6) << computeLoss(scale) << std::endl;
+
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> gradient, m(WEIGHT_COUNT, 0.0), v(WEIGHT_COUNT, 0.0);
+    auto started = std::chrono::steady_clock::now();
+
+    for (int iter = 1; iter <= options.iterations; ++iter)
+    {
+        double loss = computeGradient(gradient);
+        double correction1 = 1.0 - std::pow(beta1, iter), correction2 = 1.0 - std::pow(beta2, iter);
+        for (int w = 0; w < WEIGHT_COUNT; ++w)
+        {
+            m[w] = beta1 * m[w] + (1.0 - beta1) * gradient[w];
+            v[w] = beta2 * v[w] + (1.0 - beta2) * gradient[w] * gradient[w];
+            weights[w] -= options.learningRate * (m[w] / correction1) / (std::sqrt(v[w] / correction2) + epsilon);
+        }
+
+        if (iter % options.reportEvery == 0 || iter == options.iterations)
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            std::cout << "Iteration " << iter << ": loss " << std::setprecision(6) << loss << ", "
+                      << std::setprecision(1) << seconds << " s" << std::endl;
+            if (!writeHeader(options.outputPath))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Tuner::writeHeader(const std::string& path) const
+{
+    auto weight = [&](int term, bool eg) { return static_cast<int>(std::lround(weights[(eg ? TERM_COUNT : 0) + term])); };
+    auto list = [&](int first, int count, bool eg) {
+        std::ostringstream ss;
+        for (int i = 0; i < count; ++i)
+            ss << (i ? ", " : "") << weight(first + i, eg);
+        return ss.str();
+    };
+    auto pst = [&](std::ostream& out, bool eg) {
+        out << "constexpr int PST_" << (eg ? "EG" : "MG") << "[6][64] = {\n";
+        for (int type = PAWN; type <= KING; ++type)
+        {
+            out << "    {\n";
+            for (int row = 0; row < 8; ++row)
+            {
+                out << "        ";
+                for (int x = 0; x < 8; ++x)
+                {
+                    int sq = row * 8 + x;
+                    out << std::setw(3) << weight(TERM_PST + type * 64 + sq, eg) << (sq < 63 ? "," : "") << (x < 7 ? " " : "");
+                }
+                out << "\n";
+            }
+            out << (type < KING ? "    },\n" : "    }\n");
+        }
+        out << "};\n";
+    };
+    auto pair = [&](std::ostream& out, const char* name, int term) {
+        out << "constexpr int " << name << "_MG = " << weight(term, false) << ";\n";
+        out << "constexpr int " << name << "_EG = " << weight(term, true) << ";\n";
+    };
+
+    std::ostringstream out;
+    out << "#pragma once\n\n";
+    out << "// Параметры оценки позиции: пары (миттельшпиль, эндшпиль) в сантипешках.\n";
+    out << "// Таблицы полей записаны для белых, индекс - поле (a1 = 0); для чёрных поле отражается по горизонтали.\n";
+    out << "// Файл может быть перезаписан утилитой tune.\n\n";
+    out << "constexpr int MATERIAL_MG[6] = { " << list(TERM_MATERIAL, 6, false) << " };\n";
+    out << "constexpr int MATERIAL_EG[6] = { " << list(TERM_MATERIAL, 6, true) << " };\n\n";
+    pst(out, false);
+    out << "\n";
+    pst(out, true);
+    out << "\n// За каждое поле, доступное фигуре и не битое пешками соперника (конь, слон, ладья, ферзь)\n";
+    out << "constexpr int MOBILITY_MG[6] = { " << list(TERM_MOBILITY, 6, false) << " };\n";
+    out << "constexpr int MOBILITY_EG[6] = { " << list(TERM_MOBILITY, 6, true) << " };\n\n";
+    out << "// Проходная пешка по горизонтали относительно своей стороны\n";
+    out << "constexpr int PASSED_PAWN_MG[8] = { " << list(TERM_PASSED_PAWN, 8, false) << " };\n";
+    out << "constexpr int PASSED_PAWN_EG[8] = { " << list(TERM_PASSED_PAWN, 8, true) << " };\n\n";
+    pair(out, "BISHOP_PAIR", TERM_BISHOP_PAIR);
+    pair(out, "DOUBLED_PAWN", TERM_DOUBLED_PAWN);
+    pair(out, "ISOLATED_PAWN", TERM_ISOLATED_PAWN);
+    pair(out, "ROOK_OPEN_FILE", TERM_ROOK_OPEN_FILE);
+    pair(out, "ROOK_SEMI_OPEN_FILE", TERM_ROOK_SEMI_OPEN_FILE);
+    pair(out, "TEMPO", TERM_TEMPO);
+
+    // как и остальные исходники, файл без перевода строки в конце
+    std::string text = out.str();
+    text.pop_back();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(text.data(), static_cast<std::streamsize>(text.size())))
+    {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
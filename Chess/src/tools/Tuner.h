@@ -0,0 +1,69 @@
+#pragma once
+#include "../core/Evaluate.h"
+#include "../core/FastBoard.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TunerOptions
+{
+    std::string dataFile;            // EPD: позиция и результат партии ("1-0", "[0.5]" и т.п.)
+    std::string outputPath = "EvalParams.h";
+    size_t threads = 0;              // 0 - по числу ядер
+    size_t maxPositions = 0;         // 0 - все позиции файла
+    int iterations = 1000;
+    double learningRate = 1.0;       // шаг Adam в сантипешках
+    double scale = 0.0;              // K сигмоиды; 0 - подобрать по данным
+    int reportEvery = 50;            // печать ошибки и запись заголовка
+};
+
+// Позиция в 32 байтах: занятые поля и 4-битные коды фигур (side * 6 + type) по возрастанию полей.
+// Для оценки рокировка и взятие на проходе не нужны, поэтому не хранятся.
+struct PackedPosition
+{
+    uint64_t occupied;
+    uint8_t pieces[16];
+    uint8_t sideToMove;
+    uint8_t result;                  // 0 - выиграли чёрные, 1 - ничья, 2 - выиграли белые
+
+    static bool pack(const FastBoard& pos, int result, PackedPosition& out);
+    void unpack(FastBoard& pos) const;
+};
+
+// Настройка весов оценки методом Texel: ошибка - средний квадрат разности результата партии
+// и сигмоиды от оценки белых. Оценка линейна по весам, поэтому коэффициенты каждой позиции
+// считаются один раз и хранятся разреженной матрицей в виде отдельных массивов; ошибка и градиент
+// считаются параллельно по блокам позиций, шаг делает Adam. Результат - заголовок в формате EvalParams.h.
+class Tuner
+{
+public:
+    static constexpr int WEIGHT_COUNT = TERM_COUNT * 2; // сначала миттельшпиль, затем эндшпиль
+
+    explicit Tuner(TunerOptions options);
+
+    bool load();
+    bool run();
+    bool writeHeader(const std::string& path) const;
+
+private:
+    TunerOptions options;
+    std::vector<PackedPosition> positions;
+
+    // строки позиции i - элементы [offsets[i], offsets[i + 1]) массивов terms и counts
+    std::vector<uint32_t> offsets;
+    std::vector<uint16_t> terms;
+    std::vector<int8_t> counts;
+    std::vector<float> phases;       // доля миттельшпиля 0..1
+    std::vector<float> targets;      // 0, 0.5, 1
+
+    std::vector<double> weights;
+    double scale = 1.0;
+
+    void extractFeatures();
+    double positionEval(size_t i) const;
+    double computeLoss(double k) const;
+    double computeGradient(std::vector<double>& gradient) const;
+    double findScale() const;
+    template <typename Job>
+    void runParallel(size_t count, Job job) const;
+};
\ No newline at end of file
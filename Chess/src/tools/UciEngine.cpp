@@ -0,0 +1,381 @@
+#include "UciEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+static const char* BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "8/8/8/5k2/8/2R5/5K2/8 w - - 0 1",
+    "8/3k4/8/8/8/8/1P6/4K3 w - - 0 1",
+    "bqnb1rkr/pp3ppp/3ppn2/2p5/5P2/P2P4/NPP1P1PP/BQ1BNRKR w HFhf - 2 9"
+};
+
+UciEngine::UciEngine()
+{
+    search.setHashSize(hashMb);
+    search.setInfoCallback([this](const SearchInfo& info) { send(formatInfo(searchRoot, info)); });
+    loadTablebase();
+    position.setFen(FastBoard::START_FEN);
+}
+
+UciEngine::~UciEngine()
+{
+    search.stop();
+    waitForSearch();
+}
+
+void UciEngine::send(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+void UciEngine::waitForSearch()
+{
+    if (worker.joinable())
+        worker.join();
+}
+
+void UciEngine::loadTablebase()
+{
+    auto tablebase = std::make_shared<const Tablebase>(tablebasePath);
+    search.setTablebase(tablebase->getTableCount() > 0 ? tablebase : nullptr);
+}
+
+void UciEngine::loadNetwork(const std::string& path)
+{
+    network = nullptr;
+    if (!path.empty())
+    {
+        auto loaded = std::make_shared<NnueNetwork>();
+        if (loaded->load(path))
+        {
+            network = loaded;
+            send("info string NNUE " + path + " (" + NnueNetwork::simdName() + ")");
+        }
+        else
+            send("info string Cannot load network " + path + ", using classical evaluation");
+    }
+    search.setNetwork(network);
+}
+
+void UciEngine::loop(std::istream& in)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!execute(line))
+            return;
+    }
+    // ввод закрыт - как quit
+    execute("quit");
+}
+
+bool UciEngine::execute(const std::string& line)
+{
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "uci")
+        handleUci();
+    else if (command == "isready")
+        send("readyok");
+    else if (command == "ucinewgame")
+    {
+        waitForSearch();
+        search.clearHash();
+    }
+    else if (command == "setoption")
+        handleSetOption(args);
+    else if (command == "position")
+        handlePosition(args);
+    else if (command == "go")
+        handleGo(args);
+    else if (command == "ponderhit")
+        search.ponderHit();
+    else if (command == "stop")
+    {
+        search.stop();
+        waitForSearch();
+    }
+    else if (command == "quit")
+    {
+        search.stop();
+        waitForSearch();
+        return false;
+    }
+    else if (command == "bench")
+    {
+        waitForSearch();
+        int depth = BENCH_DEPTH;
+        args >> depth;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        bench(depth, std::cout, network);
+    }
+    else if (command == "d")
+        send(position.getFen());
+    else if (!command.empty())
+        send("info string Unknown command: " + command);
+    return true;
+}
+
+void UciEngine::handleUci()
+{
+    send("id name Chess");
+    send("id author Chess authors");
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name Clear Hash type button");
+    send("option name Move Overhead type spin default 30 min 0 max 5000");
+    send("option name MultiPV type spin default 1 min 1 max 64");
+    send("option name Ponder type check default false");
+    send("option name UCI_Chess960 type check default false");
+    send("option name TablebasePath type string default tb");
+    send("option name EvalFile type string default <empty>");
+    send("uciok");
+}
+
+void UciEngine::handleSetOption(std::istringstream& args)
+{
+    // setoption name <имя из нескольких слов> [value <значение>]
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+    while (args >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    waitForSearch();
+    try
+    {
+        if (name == "Hash")
+        {
+            hashMb = std::clamp<size_t>(std::stoul(value), 1, 4096);
+            search.setHashSize(hashMb);
+        }
+        else if (name == "Clear Hash")
+            search.clearHash();
+        else if (name == "Move Overhead")
+            moveOverheadMs = std::clamp(std::stoi(value), 0, 5000);
+        else if (name == "MultiPV")
+            multiPv = std::clamp(std::stoi(value), 1, 64);
+        else if (name == "Ponder")
+            ; // только сообщает, что GUI будет присылать go ponder
+        else if (name == "UCI_Chess960")
+        {
+            chess960 = value == "true";
+            position.setChess960(chess960 || position.isChess960());
+        }
+        else if (name == "TablebasePath")
+        {
+            tablebasePath = value.empty() ? "tb" : value;
+            loadTablebase();
+        }
+        else if (name == "EvalFile")
+            loadNetwork(value == "<empty>" ? "" : value);
+        else
+            send("info string Unknown option: " + name);
+    }
+    catch (const std::exception&)
+    {
+        send("info string Invalid value for option " + name);
+    }
+}
+
+void UciEngine::handlePosition(std::istringstream& args)
+{
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos")
+    {
+        fen = FastBoard::START_FEN;
+        args >> token;
+    }
+    else if (token == "fen")
+    {
+        while (args >> token && token != "moves")
+            fen += (fen.empty() ? "" : " ") + token;
+    }
+    else
+        return;
+
+    waitForSearch();
+    FastBoard next;
+    if (!next.setFen(fen))
+    {
+        send("info string Invalid FEN: " + fen);
+        return;
+    }
+    if (chess960)
+        next.setChess960(true);
+
+    std::vector<uint64_t> keys;
+    while (args >> token)
+    {
+        FastMove m = next.parseUci(token);
+        if (m == NO_MOVE)
+        {
+            send("info string Illegal move: " + token);
+            break;
+        }
+        keys.push_back(next.getKey());
+        UndoInfo undo;
+        next.makeMove(m, undo);
+    }
+
+    position = next;
+    history = std::move(keys);
+}
+
+void UciEngine::handleGo(std::istringstream& args)
+{
+    SearchLimits limits;
+    limits.moveOverheadMs = moveOverheadMs;
+    limits.multiPv = multiPv;
+    bool ponder = false;
+
+    std::string token;
+    while (args >> token)
+    {
+        if (token == "searchmoves")
+        {
+            std::streampos mark = args.tellg();
+            while (args >> token)
+            {
+                FastMove m = position.parseUci(token);
+                if (m == NO_MOVE)
+                {
+                    args.clear();
+                    args.seekg(mark);
+                    break;
+                }
+                limits.searchMoves.push_back(m);
+                mark = args.tellg();
+            }
+        }
+        else if (token == "wtime")
+            args >> limits.timeMs[SIDE_WHITE];
+        else if (token == "btime")
+            args >> limits.timeMs[SIDE_BLACK];
+        else if (token == "winc")
+            args >> limits.incMs[SIDE_WHITE];
+        else if (token == "binc")
+            args >> limits.incMs[SIDE_BLACK];
+        else if (token == "movestogo")
+            args >> limits.movesToGo;
+        else if (token == "depth")
+            args >> limits.depth;
+        else if (token == "nodes")
+            args >> limits.nodes;
+        else if (token == "mate")
+            args >> limits.mate;
+        else if (token == "movetime")
+            args >> limits.moveTimeMs;
+        else if (token == "infinite")
+            limits.infinite = true;
+        else if (token == "ponder")
+            ponder = true;
+    }
+
+    waitForSearch();
+    searchRoot = position;
+    search.clearStop(ponder);
+    worker = std::thread([this, limits] {
+        SearchResult result = search.run(searchRoot, limits, history);
+
+        std::string line = "bestmove " + (result.bestMove == NO_MOVE ? std::string("0000") : searchRoot.moveToUci(result.bestMove));
+        if (result.bestMove != NO_MOVE && result.ponderMove != NO_MOVE)
+        {
+            FastBoard next = searchRoot;
+            UndoInfo undo;
+            next.makeMove(result.bestMove, undo);
+            line += " ponder " + next.moveToUci(result.ponderMove);
+        }
+        send(line);
+    });
+}
+
+std::string UciEngine::formatScore(int score)
+{
+    int mate = Search::mateIn(score);
+    return mate != 0 ? "mate " + std::to_string(mate) : "cp " + std::to_string(score);
+}
+
+std::string UciEngine::formatInfo(const FastBoard& root, const SearchInfo& info)
+{
+    std::string line = "info depth " + std::to_string(info.depth) + " seldepth " + std::to_string(info.selDepth)
+        + " multipv " + std::to_string(info.multiPv) + " score " + formatScore(info.score) + " nodes " + std::to_string(info.nodes)
+        + " nps " + std::to_string(info.nodes * 1000 / std::max<int64_t>(info.timeMs, 1))
+        + " hashfull " + std::to_string(info.hashfull) + " time " + std::to_string(info.timeMs) + " pv";
+
+    // запись рокировки в режиме Фишера зависит от позиции, поэтому ходы проигрываются по порядку
+    FastBoard pos = root;
+    for (FastMove m : info.pv)
+    {
+        line += " " + pos.moveToUci(m);
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+    }
+    return line;
+}
+
+uint64_t UciEngine::bench(int depth, std::ostream& out, std::shared_ptr<const NnueNetwork> network)
+{
+    SearchLimits limits;
+    limits.depth = depth;
+
+    // сначала обычная оценка (её число узлов - контрольная сумма), затем сеть
+    struct Run
+    {
+        const char* name;
+        uint64_t nodes;
+        int64_t elapsed;
+    };
+    std::vector<Run> runs;
+    for (auto evaluator : { std::shared_ptr<const NnueNetwork>(), network })
+    {
+        if (!runs.empty() && !evaluator)
+            break;
+
+        Search benchSearch;
+        benchSearch.setNetwork(evaluator);
+        uint64_t totalNodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        int count = static_cast<int>(sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]));
+        for (int i = 0; i < count; ++i)
+        {
+            FastBoard pos;
+            pos.setFen(BENCH_POSITIONS[i]);
+            benchSearch.clearHash();
+            SearchResult result = benchSearch.run(pos, limits);
+            totalNodes += result.nodes;
+            out << "Position " << (i + 1) << "/" << count << ": " << BENCH_POSITIONS[i]
+                << " -> " << pos.moveToUci(result.bestMove) << " (" << result.nodes << " nodes)" << std::endl;
+        }
+
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        runs.push_back({ evaluator ? "NNUE" : "Classical", totalNodes, elapsed });
+        out << "===========================" << std::endl;
+        out << "Evaluation      : " << runs.back().name << (evaluator ? std::string(" (") + NnueNetwork::simdName() + ")" : "") << std::endl;
+        out << "Total time (ms) : " << elapsed << std::endl;
+        out << "Nodes searched  : " << totalNodes << std::endl;
+        out << "Nodes/second    : " << totalNodes * 1000 / std::max<int64_t>(elapsed, 1) << std::endl;
+    }
+
+    if (runs.size() == 2)
+    {
+        auto nps = [](const Run& run) { return run.nodes * 1000.0 / std::max<int64_t>(run.elapsed, 1); };
+        out << "===========================" << std::endl;
+        out << "NNUE speed      : " << static_cast<int>(100 * nps(runs[1]) / std::max(nps(runs[0]), 1.0)) << "% of classical" << std::endl;
+    }
+    return runs[0].nodes;
+}
\ No newline at end of file
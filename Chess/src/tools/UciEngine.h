@@ -0,0 +1,59 @@
+#pragma once
+#include "../core/FastBoard.h"
+#include "../core/Search.h"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Протокол UCI поверх собственного ядра: позиция на битбордах, перебор Search и таблицы эндшпиля.
+// Поиск идёт в отдельном потоке, чтобы во время него принимать stop, isready и quit.
+class UciEngine
+{
+public:
+    static constexpr int BENCH_DEPTH = 10;
+
+    UciEngine();
+    ~UciEngine();
+
+    // Читает команды до quit или конца ввода
+    void loop(std::istream& in);
+    // false - получена команда quit
+    bool execute(const std::string& line);
+
+    // Фиксированный набор позиций на заданную глубину; число узлов - контрольная сумма перебора.
+    // С сетью тот же набор повторяется с NNUE и печатается сравнение скорости с обычной оценкой.
+    static uint64_t bench(int depth, std::ostream& out, std::shared_ptr<const NnueNetwork> network = nullptr);
+
+private:
+    Search search;
+    FastBoard position;
+    FastBoard searchRoot;
+    std::vector<uint64_t> history;
+    bool chess960 = false;
+    int moveOverheadMs = 30;
+    int multiPv = 1;
+    size_t hashMb = 16;
+    std::string tablebasePath = "tb";
+    std::shared_ptr<const NnueNetwork> network;
+
+    std::thread worker;
+    std::mutex outputMutex;
+
+    void send(const std::string& line);
+    void waitForSearch();
+    void loadTablebase();
+    void loadNetwork(const std::string& path);
+
+    void handleUci();
+    void handleSetOption(std::istringstream& args);
+    void handlePosition(std::istringstream& args);
+    void handleGo(std::istringstream& args);
+
+    static std::string formatScore(int score);
+    static std::string formatInfo(const FastBoard& root, const SearchInfo& info);
+};
\ No newline at end of file
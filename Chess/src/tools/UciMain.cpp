@@ -0,0 +1,35 @@
+#include "UciEngine.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        // "chess-uci bench [depth] [network.nnue]" - замер скорости и контрольное число узлов без GUI
+        if (argc > 1 && std::string(argv[1]) == "bench")
+        {
+            int depth = argc > 2 ? std::stoi(argv[2]) : UciEngine::BENCH_DEPTH;
+            std::shared_ptr<NnueNetwork> network;
+            if (argc > 3)
+            {
+                network = std::make_shared<NnueNetwork>();
+                if (!network->load(argv[3]))
+                    return -1;
+            }
+            UciEngine::bench(depth, std::cout, network);
+            return 0;
+        }
+
+        UciEngine engine;
+        engine.loop(std::cin);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Critical Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file